@@ -0,0 +1,367 @@
+#include "nes/sys/nes.hh"
+#include "nes/sys/rom-image.hh"
+#include "nes/common/display.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs many ROMs in parallel without any output and reports the result of each of them, for example to check the
+// compatibility with a collection of test ROMs. ROMs either run for a fixed number of frames or until a blargg-style
+// test ROM reports its result.
+//
+// Jobs are either passed on the command line (using the default condition) or read from a list with one ROM per line:
+//
+//   # path                  condition  frames
+//   roms/game.nes           frames     600
+//   tests/instr_test.nes    blargg     3600
+//
+// For "blargg", the number of frames is the timeout.
+
+namespace
+{
+	/// Discards all frames, only the console state is of interest.
+	class null_display final : public nes::display
+	{
+	public:
+		auto switch_buffers() -> void override {}
+		auto set(nes::u32, nes::u32, nes::rgb) -> void override {}
+	};
+
+	enum class condition
+	{
+		frames,
+		blargg,
+	};
+
+	struct job
+	{
+		std::string path;
+		condition stop_condition{ condition::frames };
+		nes::u64 frames{ 0 };
+	};
+
+	enum class outcome
+	{
+		done, // Ran for the requested number of frames.
+		passed,
+		failed,
+		timeout,
+		error,
+	};
+
+	struct result
+	{
+		outcome kind{ outcome::error };
+		nes::u64 frames{ 0 };
+		double elapsed_s{ 0.0 };
+		nes::u64 state_hash{ 0 };
+		std::string message;
+	};
+
+	struct options
+	{
+		std::vector<job> jobs;
+		unsigned threads{ 0 };
+		bool json{ false };
+	};
+
+	auto to_string(outcome const value) -> char const*
+	{
+		switch (value)
+		{
+			case outcome::done: return "done";
+			case outcome::passed: return "passed";
+			case outcome::failed: return "failed";
+			case outcome::timeout: return "timeout";
+			case outcome::error: return "error";
+		}
+
+		return "unknown";
+	}
+
+	auto read_file(std::string const& path, std::vector<nes::u8>& result) -> bool
+	{
+		auto file = std::ifstream{ path, std::ios::binary };
+		if (!file) { return false; }
+
+		result.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+		return true;
+	}
+
+	auto parse_condition(std::string const& text, condition& result) -> bool
+	{
+		if (text == "frames") { result = condition::frames; }
+		else if (text == "blargg") { result = condition::blargg; }
+		else { return false; }
+
+		return true;
+	}
+
+	auto read_list(char const* path, std::vector<job>& result) -> bool
+	{
+		auto file = std::ifstream{ path };
+		if (!file) { return false; }
+
+		auto line = std::string{};
+		auto line_number = 0;
+		while (std::getline(file, line))
+		{
+			line_number += 1;
+			auto stream = std::istringstream{ line };
+			auto j = job{};
+			auto condition_name = std::string{};
+			if (!(stream >> j.path) || j.path[0] == '#') { continue; }
+
+			if (!(stream >> condition_name >> j.frames) || !parse_condition(condition_name, j.stop_condition))
+			{
+				std::cerr << path << ":" << line_number << ": expected a condition and a number of frames" << std::endl;
+				return false;
+			}
+
+			result.push_back(std::move(j));
+		}
+
+		return true;
+	}
+
+	auto parse_options(int const argc, char** argv, options& result) -> bool
+	{
+		auto default_condition = condition::frames;
+		auto default_frames = nes::u64{ 600 };
+		auto roms = std::vector<std::string>{};
+
+		for (auto i = 1; i < argc; ++i)
+		{
+			auto const has_value = i + 1 < argc;
+			if (std::strcmp(argv[i], "--list") == 0 && has_value)
+			{
+				if (!read_list(argv[++i], result.jobs))
+				{
+					std::cerr << "Unable to read list " << argv[i] << std::endl;
+					return false;
+				}
+			}
+			else if (std::strcmp(argv[i], "--frames") == 0 && has_value)
+			{
+				default_condition = condition::frames;
+				default_frames = std::strtoull(argv[++i], nullptr, 10);
+			}
+			else if (std::strcmp(argv[i], "--blargg") == 0 && has_value)
+			{
+				default_condition = condition::blargg;
+				default_frames = std::strtoull(argv[++i], nullptr, 10);
+			}
+			else if (std::strcmp(argv[i], "--jobs") == 0 && has_value)
+			{
+				result.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (std::strcmp(argv[i], "--json") == 0)
+			{
+				result.json = true;
+			}
+			else if (argv[i][0] != '-')
+			{
+				roms.emplace_back(argv[i]);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		for (auto& path : roms) { result.jobs.push_back(job{ std::move(path), default_condition, default_frames }); }
+		return !result.jobs.empty();
+	}
+
+	/// Check the status of a blargg-style test ROM, which writes its status to $6000 (after writing a signature to
+	/// $6001-$6003) and a message to $6004. Returns false while the test is still running.
+	auto check_blargg(nes::sys::nes const& console, result& r) -> bool
+	{
+		constexpr nes::u8 signature[]{ 0xDE, 0xB0, 0x61 };
+
+		auto const ram = console.get_cartridge_ram();
+		if (ram.get_length() < 5 || !std::equal(std::begin(signature), std::end(signature), ram.get_data() + 1))
+		{
+			return false;
+		}
+
+		auto const code = ram[0];
+		if (code == 0x80) { return false; }
+
+		for (auto i = nes::u32{ 4 }; i < ram.get_length() && ram[i] != 0; ++i) { r.message += static_cast<char>(ram[i]); }
+		while (!r.message.empty() && r.message.back() == '\n') { r.message.pop_back(); }
+		if (code == 0x81)
+		{
+			// The test wants the console to be reset, which is not supported here.
+			r.kind = outcome::error;
+			r.message = "Reset requested";
+		}
+		else
+		{
+			r.kind = code == 0x00 ? outcome::passed : outcome::failed;
+		}
+
+		return true;
+	}
+
+	auto run(job const& j) -> result
+	{
+		auto r = result{};
+		auto const start = std::chrono::steady_clock::now();
+
+		auto rom_data = std::vector<nes::u8>{};
+		if (!read_file(j.path, rom_data))
+		{
+			r.message = "Unable to read file";
+			return r;
+		}
+
+		auto const rom = std::make_unique<nes::sys::rom_image>(
+			nes::span<nes::u8 const>{ rom_data.data(), static_cast<nes::u32>(rom_data.size()) });
+		if (rom->get_status() != nes::status::success)
+		{
+			r.message = nes::to_string(rom->get_status());
+			return r;
+		}
+
+		auto display = null_display{};
+		auto const console = std::make_unique<nes::sys::nes>(display, *rom);
+		console->set_video_enabled(false);
+		console->ref_apu().set_output_muted(true);
+
+		r.kind = j.stop_condition == condition::frames ? outcome::done : outcome::timeout;
+		while (r.frames < j.frames)
+		{
+			console->run_frame();
+			r.frames += 1;
+			if (console->get_status() != nes::status::success)
+			{
+				r.kind = outcome::error;
+				r.message = nes::to_string(console->get_status());
+				break;
+			}
+			if (j.stop_condition == condition::blargg && check_blargg(*console, r)) { break; }
+		}
+
+		r.state_hash = console->get_state_hash();
+		r.elapsed_s = std::chrono::duration<double>{ std::chrono::steady_clock::now() - start }.count();
+		return r;
+	}
+
+	/// Run all jobs on the given number of threads. Jobs take very different amounts of time, so each thread takes the
+	/// next job whenever it is done with the previous one.
+	auto run_all(std::vector<job> const& jobs, unsigned const thread_count) -> std::vector<result>
+	{
+		auto results = std::vector<result>(jobs.size());
+		auto next_job = std::atomic<std::size_t>{ 0 };
+		auto const work = [&]
+		{
+			for (auto i = next_job.fetch_add(1); i < jobs.size(); i = next_job.fetch_add(1))
+			{
+				results[i] = run(jobs[i]);
+			}
+		};
+
+		auto threads = std::vector<std::thread>{};
+		for (auto i = 1u; i < thread_count; ++i) { threads.emplace_back(work); }
+		work();
+		for (auto& thread : threads) { thread.join(); }
+
+		return results;
+	}
+
+	auto print_json_string(std::string const& value) -> void
+	{
+		std::cout << '"';
+		for (auto const c : value)
+		{
+			if (c == '"' || c == '\\') { std::cout << '\\' << c; }
+			else if (static_cast<unsigned char>(c) < 0x20) { std::cout << ' '; }
+			else { std::cout << c; }
+		}
+		std::cout << '"';
+	}
+
+	auto print_text(std::vector<job> const& jobs, std::vector<result> const& results) -> void
+	{
+		for (auto i = std::size_t{ 0 }; i < jobs.size(); ++i)
+		{
+			auto const& r = results[i];
+			std::cout << std::left << std::setw(8) << to_string(r.kind) << std::right << std::dec << std::setw(8)
+				<< r.frames << " frames " << std::fixed << std::setprecision(1) << std::setw(9) << r.elapsed_s * 1000.0
+				<< " ms  " << std::hex << std::setw(16) << std::setfill('0') << r.state_hash << std::setfill(' ') << "  "
+				<< jobs[i].path;
+
+			// Messages of test ROMs usually span multiple lines.
+			auto message = r.message;
+			std::replace(message.begin(), message.end(), '\n', ' ');
+			if (!message.empty()) { std::cout << "  (" << message << ")"; }
+			std::cout << '\n';
+		}
+		std::cout << std::flush;
+	}
+
+	auto print_json(std::vector<job> const& jobs, std::vector<result> const& results) -> void
+	{
+		std::cout << "[\n";
+		for (auto i = std::size_t{ 0 }; i < jobs.size(); ++i)
+		{
+			auto const& r = results[i];
+			std::cout << "  { \"rom\": ";
+			print_json_string(jobs[i].path);
+			std::cout << ", \"result\": \"" << to_string(r.kind) << "\", \"frames\": " << std::dec << r.frames
+				<< ", \"elapsed_s\": " << r.elapsed_s << ", \"state_hash\": \"" << std::hex << std::setw(16)
+				<< std::setfill('0') << r.state_hash << std::setfill(' ') << "\", \"message\": ";
+			print_json_string(r.message);
+			std::cout << " }" << (i + 1 < jobs.size() ? "," : "") << '\n';
+		}
+		std::cout << "]" << std::endl;
+	}
+} // namespace
+
+auto main(int const argc, char** argv) -> int
+{
+	auto o = options{};
+	if (!parse_options(argc, argv, o))
+	{
+		std::cerr << "Usage:\n";
+		std::cerr << "  " << argv[0]
+			<< " [--jobs <count>] [--frames <count> | --blargg <timeout>] [--list <file>] [--json] [<rom>...]\n\n";
+		std::cerr << "Runs the ROMs in parallel and prints the result, the runtime and the final state hash of each."
+			<< std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto thread_count = o.threads != 0 ? o.threads : std::max(1u, std::thread::hardware_concurrency());
+	thread_count = std::min(thread_count, static_cast<unsigned>(o.jobs.size()));
+
+	auto const start = std::chrono::steady_clock::now();
+	auto const results = run_all(o.jobs, thread_count);
+	auto const elapsed = std::chrono::duration<double>{ std::chrono::steady_clock::now() - start };
+
+	if (o.json) { print_json(o.jobs, results); }
+	else { print_text(o.jobs, results); }
+
+	auto total_frames = nes::u64{ 0 };
+	auto unsuccessful = std::size_t{ 0 };
+	for (auto const& r : results)
+	{
+		total_frames += r.frames;
+		if (r.kind != outcome::done && r.kind != outcome::passed) { unsuccessful += 1; }
+	}
+
+	std::cerr << "Ran " << results.size() << " ROMs (" << total_frames << " frames) on " << thread_count
+		<< " threads in " << elapsed.count() * 1000.0 << " ms, " << unsuccessful << " unsuccessful" << std::endl;
+	return unsuccessful == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
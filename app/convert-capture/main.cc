@@ -0,0 +1,200 @@
+#include "nes/sys/ppu.hh"
+#include "nes/common/frame-codec.hh"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Converts a capture (recorded by the replay app) into a format other tools understand: either a Y4M video with full
+// chroma, which can be played back or encoded by most video tools, or raw RGB frames (three bytes per pixel).
+//
+// For example, the following encodes a capture as a regular video:
+//
+//   convert-capture game.nesv - | ffmpeg -i - game.mkv
+
+namespace
+{
+	enum class format
+	{
+		y4m,
+		rgb,
+	};
+
+	/// Frame rate of the NTSC console (60.0988 Hz) as a fraction.
+	constexpr auto frame_rate_numerator = 39375000;
+	constexpr auto frame_rate_denominator = 655171;
+	/// Channels which are not emphasized are attenuated by roughly this much.
+	constexpr auto emphasis_attenuation = 0.746;
+
+	struct frame
+	{
+		nes::u16 pixels[nes::frame_codec::pixel_count]{};
+	};
+
+	struct options
+	{
+		char const* input{ nullptr };
+		char const* output{ nullptr };
+		format output_format{ format::y4m };
+	};
+
+	auto parse_options(int const argc, char** argv, options& result) -> bool
+	{
+		for (auto i = 1; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--rgb") == 0) { result.output_format = format::rgb; }
+			else if (std::strcmp(argv[i], "--y4m") == 0) { result.output_format = format::y4m; }
+			else if (!result.input) { result.input = argv[i]; }
+			else if (!result.output) { result.output = argv[i]; }
+			else { return false; }
+		}
+
+		return result.input && result.output;
+	}
+
+	/// Colors of all raw pixels (including the emphasis bits).
+	auto build_palette() -> std::vector<nes::rgb>
+	{
+		auto result = std::vector<nes::rgb>(512);
+		for (auto pixel = 0u; pixel < result.size(); ++pixel)
+		{
+			auto color = nes::sys::ppu::get_palette_rgb(static_cast<nes::u8>(pixel & 0x3F));
+			auto const emphasis = pixel >> 6;
+			auto const attenuate = [&](nes::u8& channel, unsigned const bit)
+			{
+				if (emphasis != 0 && !(emphasis & bit)) { channel = static_cast<nes::u8>(channel * emphasis_attenuation); }
+			};
+			attenuate(color.r, 0b001);
+			attenuate(color.g, 0b010);
+			attenuate(color.b, 0b100);
+			result[pixel] = color;
+		}
+
+		return result;
+	}
+
+	/// Convert to BT.601 YCbCr with limited range, as expected by most players.
+	auto write_y4m_frame(std::ostream& output, std::vector<nes::rgb> const& colors) -> void
+	{
+		auto planes = std::vector<char>(colors.size() * 3);
+		auto const count = colors.size();
+		for (auto i = std::size_t{ 0 }; i < count; ++i)
+		{
+			auto const r = colors[i].r;
+			auto const g = colors[i].g;
+			auto const b = colors[i].b;
+			planes[i] = static_cast<char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+			// Chroma is offset by 128 before shifting to keep the values positive.
+			planes[count + i] = static_cast<char>((-38 * r - 74 * g + 112 * b + 32896) >> 8);
+			planes[2 * count + i] = static_cast<char>((112 * r - 94 * g - 18 * b + 32896) >> 8);
+		}
+
+		output << "FRAME\n";
+		output.write(planes.data(), static_cast<std::streamsize>(planes.size()));
+	}
+
+	auto write_rgb_frame(std::ostream& output, std::vector<nes::rgb> const& colors) -> void
+	{
+		auto bytes = std::vector<char>(colors.size() * 3);
+		for (auto i = std::size_t{ 0 }; i < colors.size(); ++i)
+		{
+			bytes[3 * i + 0] = static_cast<char>(colors[i].r);
+			bytes[3 * i + 1] = static_cast<char>(colors[i].g);
+			bytes[3 * i + 2] = static_cast<char>(colors[i].b);
+		}
+
+		output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	}
+} // namespace
+
+auto main(int const argc, char** argv) -> int
+{
+	auto o = options{};
+	if (!parse_options(argc, argv, o))
+	{
+		std::cerr << "Usage:\n";
+		std::cerr << "  " << argv[0] << " [--y4m | --rgb] <capture> <output>\n\n";
+		std::cerr << "Converts a capture into a Y4M video (default) or raw RGB frames. Use - to write to stdout."
+			<< std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto input = std::ifstream{ o.input, std::ios::binary };
+	auto header = nes::frame_codec::file_header{};
+	if (!input.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != nes::frame_codec::file_magic ||
+		header.version != nes::frame_codec::file_version || header.width != nes::display::width ||
+		header.height != nes::display::height)
+	{
+		std::cerr << "Unable to read capture: " << nes::to_string(nes::status::error_invalid_capture) << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto file = std::ofstream{};
+	auto const to_stdout = std::strcmp(o.output, "-") == 0;
+	if (!to_stdout) { file.open(o.output, std::ios::binary | std::ios::trunc); }
+	auto& output = to_stdout ? std::cout : file;
+	if (!output)
+	{
+		std::cerr << "Unable to create " << o.output << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (o.output_format == format::y4m)
+	{
+		output << "YUV4MPEG2 W" << header.width << " H" << header.height << " F" << frame_rate_numerator << ":"
+			<< frame_rate_denominator << " Ip A8:7 C444\n";
+	}
+
+	auto const palette = build_palette();
+	auto f = std::make_unique<frame>();
+	auto previous = std::make_unique<frame>();
+	auto colors = std::vector<nes::rgb>(nes::frame_codec::pixel_count);
+	auto data = std::vector<nes::u8>(nes::frame_codec::max_encoded_size);
+	auto frame_count = nes::u32{ 0 };
+	auto frame_header = nes::frame_codec::frame_header{};
+	while (input.read(reinterpret_cast<char*>(&frame_header), sizeof(frame_header)))
+	{
+		// Decoding can only start at a key frame.
+		auto const is_key_frame = (frame_header.flags & nes::frame_codec::key_frame_flag) != 0;
+		if (frame_count == 0 && !is_key_frame) { break; }
+		if (is_key_frame) { std::memset(previous->pixels, 0, sizeof(previous->pixels)); }
+
+		if (frame_header.size > nes::frame_codec::max_encoded_size ||
+			!input.read(reinterpret_cast<char*>(data.data()), frame_header.size) ||
+			nes::frame_codec::decode(data.data(), frame_header.size, previous->pixels, f->pixels) !=
+				nes::status::success)
+		{
+			std::cerr << "Capture is damaged after frame " << frame_count << std::endl;
+			break;
+		}
+
+		for (auto i = nes::u32{ 0 }; i < nes::frame_codec::pixel_count; ++i)
+		{
+			colors[i] = palette[f->pixels[i] & 0x1FF];
+		}
+		if (o.output_format == format::y4m) { write_y4m_frame(output, colors); }
+		else { write_rgb_frame(output, colors); }
+		std::swap(f, previous);
+		frame_count += 1;
+	}
+
+	output.flush();
+	if (!output)
+	{
+		std::cerr << "Unable to write " << o.output << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// A capture which was not closed properly is still readable up to its last complete frame.
+	if (header.frame_count != 0 && frame_count != header.frame_count)
+	{
+		std::cerr << "Converted " << frame_count << " of " << header.frame_count << " frames" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cerr << "Converted " << frame_count << " frames" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+#include "capture-writer.hh"
+#include "nes/sys/movie.hh"
+#include "nes/sys/nes.hh"
+#include "nes/sys/rom-image.hh"
+#include "nes/common/display.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	/// Discards all frames, replays only care about the console state.
+	class null_display final : public nes::display
+	{
+	public:
+		auto switch_buffers() -> void override {}
+		auto set(nes::u32, nes::u32, nes::rgb) -> void override {}
+	};
+
+	/// Passes the raw frames on to a capture.
+	class capture_display final : public nes::display
+	{
+		nes::capture_writer& writer_;
+		nes::u16 frame_[nes::frame_codec::pixel_count]{};
+
+	public:
+		explicit capture_display(nes::capture_writer& writer)
+			: display{ true }
+			, writer_{ writer }
+		{
+		}
+
+		auto switch_buffers() -> void override { writer_.push(frame_); }
+		auto set(nes::u32, nes::u32, nes::rgb) -> void override {}
+		auto set_index(nes::u32 const x, nes::u32 const y, nes::u16 const pixel) -> void override
+		{
+			frame_[y * width + x] = pixel;
+		}
+	};
+
+	auto read_file(char const* path, std::vector<nes::u8>& result) -> bool
+	{
+		auto file = std::ifstream{ path, std::ios::binary };
+		if (!file) { return false; }
+
+		result.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+		return true;
+	}
+} // namespace
+
+auto main(int const argc, char** argv) -> int
+{
+	auto const capture_path = argc == 5 && std::strcmp(argv[3], "--capture") == 0 ? argv[4] : nullptr;
+	if (argc != 3 && !capture_path)
+	{
+		std::cerr << "Usage:\n";
+		std::cerr << "  " << argv[0] << " <rom> <movie> [--capture <file>]\n\n";
+		std::cerr << "Replays a movie as fast as possible and prints the hash of the console state after every frame."
+			<< std::endl;
+		std::cerr << "With --capture, the video output is also recorded (see convert-capture for playing it back)."
+			<< std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto rom_data = std::vector<nes::u8>{};
+	auto movie_data = std::vector<nes::u8>{};
+	if (!read_file(argv[1], rom_data) || !read_file(argv[2], movie_data))
+	{
+		std::cerr << "Unable to read input files" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto const rom = std::make_unique<nes::sys::rom_image>(
+		nes::span<nes::u8 const>{ rom_data.data(), static_cast<nes::u32>(rom_data.size()) });
+	if (rom->get_status() != nes::status::success)
+	{
+		std::cerr << "Unable to load cartridge: " << nes::to_string(rom->get_status()) << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto writer = std::make_unique<nes::capture_writer>();
+	if (capture_path)
+	{
+		if (auto const s = writer->open(capture_path); s != nes::status::success)
+		{
+			std::cerr << "Unable to create capture: " << nes::to_string(s) << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	auto null = null_display{};
+	auto const capture = std::make_unique<capture_display>(*writer);
+	auto& display = capture_path ? static_cast<nes::display&>(*capture) : null;
+	auto const console = std::make_unique<nes::sys::nes>(display, *rom);
+	auto reader = nes::sys::movie_reader{};
+	auto const movie = nes::span<nes::u8 const>{ movie_data.data(), static_cast<nes::u32>(movie_data.size()) };
+	if (auto const s = reader.begin(movie, *console); s != nes::status::success)
+	{
+		std::cerr << "Unable to load movie: " << nes::to_string(s) << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto const start = std::chrono::steady_clock::now();
+	auto controller_1 = nes::sys::button_mask{};
+	auto controller_2 = nes::sys::button_mask{};
+	while (reader.next(controller_1, controller_2))
+	{
+		console->ref_controller_1().set_pressed(controller_1);
+		console->ref_controller_2().set_pressed(controller_2);
+		console->run_frame();
+		if (console->get_status() != nes::status::success)
+		{
+			std::cerr << "Runtime error in frame " << reader.get_frame_index() << ": "
+				<< nes::to_string(console->get_status()) << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		std::cout << std::dec << reader.get_frame_index() << ' ' << std::hex << std::setw(16) << std::setfill('0')
+			<< console->get_state_hash() << '\n';
+	}
+	auto const elapsed = std::chrono::duration<double>{ std::chrono::steady_clock::now() - start };
+
+	std::cerr << "Replayed " << reader.get_frame_count() << " frames in " << elapsed.count() * 1000.0 << " ms ("
+		<< static_cast<double>(reader.get_frame_count()) / elapsed.count() << " frames per second)" << std::endl;
+
+	if (capture_path)
+	{
+		if (auto const s = writer->close(); s != nes::status::success)
+		{
+			std::cerr << "Unable to write capture: " << nes::to_string(s) << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		auto const frame_count = std::max(writer->get_frame_count(), nes::u32{ 1 });
+		std::cerr << "Captured " << writer->get_frame_count() << " frames ("
+			<< writer->get_encoded_bytes() / frame_count << " bytes per frame, waited for the writer "
+			<< writer->get_stalls() << " times)" << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+#include "impl/audio-sink-sdl.hh"
+#include "nes/common/utils.hh"
+#include <SDL3/SDL_audio.h>
+#include <iostream>
+
+namespace nes::app::sdl
+{
+	audio_sink_sdl::~audio_sink_sdl()
+	{
+		// Destroying the stream also stops the callback.
+		if (stream_) { SDL_DestroyAudioStream(stream_); }
+	}
+
+	auto audio_sink_sdl::open() -> status
+	{
+		auto const spec = SDL_AudioSpec{ SDL_AUDIO_S16, 1, static_cast<int>(sample_rate) };
+		stream_ = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, &handle_stream_callback, this);
+		if (!stream_)
+		{
+			std::cerr << "Couldn't open audio device: " << SDL_GetError() << std::endl;
+			return status::error_system_error;
+		}
+
+		if (!SDL_ResumeAudioStreamDevice(stream_))
+		{
+			std::cerr << "Couldn't start audio playback: " << SDL_GetError() << std::endl;
+			return status::error_system_error;
+		}
+
+		return status::success;
+	}
+
+	auto audio_sink_sdl::get_rate_adjustment() const -> i32
+	{
+		// Speed up while the queue is below the target and slow down while it is above it, proportionally to the
+		// distance from the target.
+		auto const distance = static_cast<i64>(target_fill) - static_cast<i64>(get_fill());
+		auto const adjustment = distance * max_rate_adjustment / static_cast<i64>(target_fill);
+		return static_cast<i32>(max(min(adjustment, i64{ max_rate_adjustment }), i64{ -max_rate_adjustment }));
+	}
+
+	auto audio_sink_sdl::write(span<i16 const> const samples) -> void
+	{
+		if (samples.is_empty()) { return; }
+
+		if (buffer_.write(samples) < samples.get_length())
+		{
+			overruns_.fetch_add(1, std::memory_order_relaxed);
+		}
+		started_.store(true, std::memory_order_relaxed);
+	}
+
+	auto SDLCALL audio_sink_sdl::handle_stream_callback(void* const userdata, SDL_AudioStream* const stream, int const additional_amount, int) -> void
+	{
+		if (additional_amount <= 0) { return; }
+		static_cast<audio_sink_sdl*>(userdata)->fill_stream(stream, static_cast<u32>(additional_amount) / sizeof(i16));
+	}
+
+	auto audio_sink_sdl::fill_stream(SDL_AudioStream* const stream, u32 sample_count) -> void
+	{
+		i16 chunk[512];
+		auto missing = false;
+		while (sample_count > 0)
+		{
+			auto const requested = min(sample_count, static_cast<u32>(sizeof(chunk) / sizeof(i16)));
+			auto const count = buffer_.read(span{ chunk, requested });
+			if (count > 0) { last_sample_ = chunk[count - 1]; }
+
+			// Repeat the last sample instead of jumping to zero, which would be audible as a click.
+			for (auto i = count; i < requested; ++i) { chunk[i] = last_sample_; }
+			missing = missing || count < requested;
+
+			SDL_PutAudioStreamData(stream, chunk, static_cast<int>(requested * sizeof(i16)));
+			sample_count -= requested;
+		}
+
+		if (missing && started_.load(std::memory_order_relaxed))
+		{
+			underruns_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+} // namespace nes::app::sdl
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "nes/common/audio-sink.hh"
+#include "nes/common/containers/spsc-ring-buffer.hh"
+#include "nes/common/status.hh"
+#include <atomic>
+
+#include <SDL3/SDL.h>
+
+namespace nes::app::sdl
+{
+	/// Audio sink implementation playing samples using an SDL audio stream.
+	///
+	/// Samples are passed to SDL's audio thread using a lock-free queue. The sink requests small changes of the sample
+	/// rate depending on the queue's fill level, so that the emulation follows the audio device's clock without the
+	/// queue running dry or overflowing.
+	class audio_sink_sdl final : public audio_sink
+	{
+		static constexpr auto sample_rate = u32{ 48000 };
+		static constexpr auto buffer_capacity = u32{ 4096 };
+		static constexpr auto target_fill = buffer_capacity / 2;
+		static constexpr auto max_rate_adjustment = i32{ 5000 }; // 0.5%
+
+		SDL_AudioStream* stream_{ nullptr };
+		spsc_ring_buffer<i16, buffer_capacity> buffer_;
+		std::atomic<bool> started_{ false };
+		std::atomic<u64> underruns_{ 0 };
+		std::atomic<u64> overruns_{ 0 };
+		i16 last_sample_{ 0 }; // Only accessed by the audio thread.
+
+	public:
+		explicit audio_sink_sdl() = default;
+		~audio_sink_sdl() override;
+
+		/// Open the default playback device (requires SDL's audio subsystem).
+		auto open() -> status;
+
+		auto get_fill() const -> u32 { return buffer_.get_size(); }
+		auto get_capacity() const -> u32 { return buffer_capacity; }
+		/// Number of times the audio device requested more samples than were queued.
+		auto get_underruns() const -> u64 { return underruns_.load(std::memory_order_relaxed); }
+		/// Number of times samples had to be dropped because the queue was full.
+		auto get_overruns() const -> u64 { return overruns_.load(std::memory_order_relaxed); }
+
+		auto get_sample_rate() const -> u32 override { return sample_rate; }
+		auto get_rate_adjustment() const -> i32 override;
+		auto write(span<i16 const> samples) -> void override;
+
+	private:
+		static auto SDLCALL handle_stream_callback(void* userdata, SDL_AudioStream*, int additional_amount, int total_amount) -> void;
+		auto fill_stream(SDL_AudioStream*, u32 sample_count) -> void;
+	};
+} // namespace nes::app::sdl
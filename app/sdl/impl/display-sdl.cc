@@ -1,16 +1,228 @@
 #include "impl/display-sdl.hh"
+#include "nes/common/xxh3.hh"
+#include "nes/common/utils.hh"
+#include <cstring>
 
 namespace nes::app::sdl
 {
+	display_sdl::display_sdl(scaler const& s)
+		: display{ s.kind == scaler_kind::ntsc }
+		, scaler_{ s }
+	{
+		if (scaler_.kind == scaler_kind::none || scaler_.kind == scaler_kind::ntsc) { scaler_.factor = 1; }
+		if (scaler_.kind == scaler_kind::ntsc) { ntsc_ = std::make_unique<ntsc_filter>(scaler_.ntsc_layout); }
+		scaler_.thread_count = min(max(scaler_.thread_count, u32{ 1 }), height);
+		if (scaler_.kind != scaler_kind::none) { workers_ = std::make_unique<worker_pool>(scaler_.thread_count); }
+	}
+
 	auto display_sdl::set(u32 const x, u32 const y, rgb const color) -> void
 	{
-		buffer_back_[(y * width) + x] = (color.r << 24) | (color.g << 16) | (color.b << 8);
+		buffers_[back_][(y * width) + x] = (color.r << 24) | (color.g << 16) | (color.b << 8);
+		if (ntsc_)
+		{
+			raw_buffers_[back_][(y * width) + x] = rgb_pixel;
+			rgb_rows_[back_][y] = true;
+		}
+	}
+
+	auto display_sdl::set_index(u32 const x, u32 const y, u16 const pixel) -> void
+	{
+		raw_buffers_[back_][(y * width) + x] = pixel;
+	}
+
+	auto display_sdl::end_scanline(u32 const y) -> void
+	{
+		completed_lines_ = y + 1;
+		progress_.store((frame_count_ << 10) | (completed_lines_ << 2) | back_, std::memory_order_release);
 	}
 
 	auto display_sdl::switch_buffers() -> void
 	{
-		if (!texture_) { return; }
+		auto const& buffer = buffers_[back_];
+		if (ntsc_)
+		{
+			// The filtered frame also depends on the phase of the dot crawl.
+			auto const& raw_buffer = raw_buffers_[back_];
+			auto const parity = static_cast<u8>(frame_count_ & 1);
+			auto h = xxh3{};
+			h.update(span<u8 const>{ reinterpret_cast<u8 const*>(raw_buffer), sizeof(raw_buffer) });
+			h.update(span<u8 const>{ reinterpret_cast<u8 const*>(buffer), sizeof(buffer) });
+			h.update(span<u8 const>{ &parity, 1 });
+			hashes_[back_] = h.get_value();
+		}
+		else
+		{
+			hashes_[back_] = xxh3::hash(span<u8 const>{ reinterpret_cast<u8 const*>(buffer), sizeof(buffer) });
+		}
+		frames_[back_] = frame_count_++;
+
+		back_ = middle_.exchange(back_ | new_frame_flag, std::memory_order_acq_rel) & index_mask;
+		completed_lines_ = 0;
+		progress_.store((frame_count_ << 10) | back_, std::memory_order_release);
+		// The PPU (even with rendering disabled) and the UI screens draw every pixel of a frame, so the buffers are
+		// completely overwritten. Only the flags need to be reset explicitly.
+		if (ntsc_) { std::memset(rgb_rows_[back_], 0, sizeof(rgb_rows_[back_])); }
+	}
+
+	auto display_sdl::upload(SDL_Texture* const texture) -> bool
+	{
+		if (middle_.load(std::memory_order_relaxed) & new_frame_flag)
+		{
+			front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index_mask;
+			front_pending_ = true;
+			// Menus and paused games produce the same frame over and over again. The texture then already shows the
+			// frame.
+			if (has_uploaded_ && hashes_[front_] == uploaded_hash_)
+			{
+				presented_line_ = max(presented_line_, (frames_[front_] + 1) * height);
+				front_pending_ = false;
+			}
+		}
+		if (!front_pending_) { return false; }
+
+		// If the texture cannot be locked, the frame stays pending and is uploaded by the next call (unless a newer
+		// frame has been completed by then).
+		void* pixels = nullptr;
+		auto pitch = 0;
+		if (!SDL_LockTexture(texture, nullptr, &pixels, &pitch)) { return false; }
+
+		auto const row_size = width * sizeof(u32);
+		auto const* source = buffers_[front_];
+		if (scaler_.kind != scaler_kind::none)
+		{
+			// The scaled frame is written directly into the texture, with the render thread scaling one of the bands.
+			auto const target = pixel_view<u32>{
+				static_cast<u32*>(pixels), get_texture_width(), get_texture_height(), static_cast<u32>(pitch) / 4 };
+			auto const band_size = (height + scaler_.thread_count - 1) / scaler_.thread_count;
+			auto const band_count = (height + band_size - 1) / band_size;
+			workers_->run(band_count, [this, &target, band_size](u32 const band)
+			{
+				auto const first_row = band * band_size;
+				scale(target, first_row, min(band_size, height - first_row));
+			});
+		}
+		else if (static_cast<std::size_t>(pitch) == row_size)
+		{
+			std::memcpy(pixels, source, row_size * height);
+		}
+		else
+		{
+			auto* target = static_cast<u8*>(pixels);
+			for (auto y = u32{ 0 }; y < height; ++y)
+			{
+				std::memcpy(target + y * static_cast<std::size_t>(pitch), source + y * width, row_size);
+			}
+		}
+		SDL_UnlockTexture(texture);
+
+		presented_line_ = max(presented_line_, (frames_[front_] + 1) * height);
+		uploaded_hash_ = hashes_[front_];
+		has_uploaded_ = true;
+		front_pending_ = false;
+		return true;
+	}
+
+	auto display_sdl::upload_lines(SDL_Texture* const texture) -> bool
+	{
+		auto const progress = progress_.load(std::memory_order_acquire);
+		auto const frame = progress >> 10;
+		auto const lines = static_cast<u32>((progress >> 2) & 0xFF);
+		auto const index = static_cast<u32>(progress & index_mask);
+		if (frame != band_frame_)
+		{
+			band_frame_ = frame;
+			band_lines_ = 0;
+		}
+		if (lines < band_lines_ + band_height) { return false; }
+
+		auto const rect = SDL_Rect{
+			0, static_cast<int>(band_lines_), static_cast<int>(width), static_cast<int>(lines - band_lines_) };
+		void* pixels = nullptr;
+		auto pitch = 0;
+		if (!SDL_LockTexture(texture, &rect, &pixels, &pitch)) { return false; }
+
+		auto* target = static_cast<u8*>(pixels);
+		auto const copy_lines = [&](u32 const* const source)
+		{
+			for (auto y = band_lines_; y < lines; ++y)
+			{
+				auto const row = target + (y - band_lines_) * static_cast<std::size_t>(pitch);
+				std::memcpy(row, source + y * width, width * sizeof(u32));
+			}
+		};
+		copy_lines(buffers_[index]);
+		// If the emulation thread got far enough ahead to draw into the buffer again, the lines might be torn. They are
+		// replaced with the lines of the last complete frame (which only the render thread uses), so the texture can be
+		// presented anyway, and the next complete frame is uploaded in any case.
+		auto const torn = (progress_.load(std::memory_order_acquire) >> 10) > frame + 1;
+		if (torn) { copy_lines(buffers_[front_]); }
+		SDL_UnlockTexture(texture);
+
+		band_lines_ = lines;
+		if (torn)
+		{
+			has_uploaded_ = false;
+			return false;
+		}
+
+		presented_line_ = max(presented_line_, frame * height + lines);
+		return true;
+	}
+
+	auto display_sdl::begin_latency_probe(u64 const input_time_ns) -> void
+	{
+		if (probe_pending_.load(std::memory_order_acquire)) { return; }
+
+		probe_line_ = frame_count_ * height + completed_lines_;
+		probe_time_ns_ = input_time_ns;
+		probe_pending_.store(true, std::memory_order_release);
+	}
+
+	auto display_sdl::end_latency_probe(u64 const present_time_ns) -> u64
+	{
+		if (!probe_pending_.load(std::memory_order_acquire) || presented_line_ <= probe_line_) { return 0; }
+
+		auto const latency_ns = present_time_ns > probe_time_ns_ ? present_time_ns - probe_time_ns_ : u64{ 1 };
+		probe_pending_.store(false, std::memory_order_release);
+		return latency_ns;
+	}
+
+	auto display_sdl::scale(pixel_view<u32> const target, u32 const first_row, u32 const row_count) const -> void
+	{
+		auto const source = pixel_view<u32 const>{ buffers_[front_], width, height, width };
+		switch (scaler_.kind)
+		{
+			case scaler_kind::none:
+				break;
+			case scaler_kind::nearest:
+				scale_nearest(source, target, scaler_.factor, first_row, row_count);
+				break;
+			case scaler_kind::scale_nx:
+				scale_nx(source, target, scaler_.factor, first_row, row_count);
+				break;
+			case scaler_kind::xbr_lite:
+				scale_xbr_lite(source, target, scaler_.factor, first_row, row_count);
+				break;
+			case scaler_kind::ntsc:
+			{
+				auto const raw = pixel_view<u16 const>{ raw_buffers_[front_], width, height, width };
+				ntsc_->filter(raw, target, frames_[front_], first_row, row_count);
+
+				// Pixels drawn by the UI are stretched over the filtered ones.
+				for (auto y = first_row; y < first_row + row_count; ++y)
+				{
+					if (!rgb_rows_[front_][y]) { continue; }
 
-		SDL_UpdateTexture(texture_, nullptr, buffer_back_, width * 4);
+					auto const in = raw.get_row(y);
+					auto const out = target.get_row(y);
+					for (auto x = u32{ 0 }; x < target.get_width(); ++x)
+					{
+						auto const source_x = x * width / target.get_width();
+						if (in[source_x] == rgb_pixel) { out[x] = source.get_row(y)[source_x]; }
+					}
+				}
+				break;
+			}
+		}
 	}
 } // namespace nes::app::sdl
@@ -1,24 +1,115 @@
 #pragma once
 
 #include "nes/common/display.hh"
+#include "nes/app/graphics/scalers/scalers.hh"
+#include "nes/app/graphics/ntsc-filter.hh"
+#include "worker-pool.hh"
+#include <atomic>
+#include <memory>
 
 #include <SDL3/SDL.h>
 
 namespace nes::app::sdl
 {
-	/// Display implementation rendering contents into an SDL texture.
+	/// Display implementation handing frames from the emulation thread to the render thread.
+	///
+	/// Frames are triple-buffered: the emulation thread draws into the back buffer and swaps it with the middle buffer
+	/// when done, the render thread swaps the middle buffer with the front buffer when a new frame is available. Neither
+	/// thread ever waits for the other, and the render thread always gets the newest complete frame.
+	///
+	/// Frames are hashed when they are completed, so that the texture is only updated if the content has changed.
+	///
+	/// Optionally, frames are scaled up on the CPU while they are copied into the texture (which is then factor times as
+	/// large), split into bands of rows which are scaled in parallel. The NTSC filter works the same way, but needs the
+	/// raw output of the PPU, so the display is indexed then (pixels drawn by the UI are converted separately).
+	///
+	/// For beam racing, the lines of the back buffer can also be uploaded in bands while the frame is still being drawn.
+	/// The emulation thread only writes to a buffer again after two more frames, which the render thread detects (and
+	/// falls back to the complete frame) if it ever falls this far behind.
 	class display_sdl final : public display
 	{
-		SDL_Texture* texture_{ nullptr };
-		u32 buffer_back_[width * height]{};
+	public:
+		enum class scaler_kind
+		{
+			none,
+			nearest,
+			scale_nx,
+			xbr_lite,
+			ntsc,
+		};
+
+		struct scaler
+		{
+			scaler_kind kind{ scaler_kind::none };
+			u32 factor{ 1 };
+			u32 thread_count{ 1 };
+			ntsc_filter::layout ntsc_layout{ ntsc_filter::layout::standard };
+		};
+
+		/// Lines per band while beam racing.
+		static constexpr auto band_height = u32{ 16 };
+
+	private:
+		static constexpr auto new_frame_flag = u32{ 0b100 };
+		static constexpr auto index_mask = u32{ 0b011 };
+		// Marks raw pixels which were drawn as RGB values instead (by the UI), the rest of the pixel is black.
+		static constexpr auto rgb_pixel = u16{ 0x8000 | 0x0F };
+
+		u32 buffers_[3][width * height]{};
+		// Only used with the NTSC filter.
+		u16 raw_buffers_[3][width * height]{};
+		bool rgb_rows_[3][height]{}; // Rows containing pixels drawn as RGB values.
+		u64 frames_[3]{}; // Frame numbers (for the dot crawl and for measuring the latency).
+		u64 frame_count_{ 0 }; // Only used by the emulation thread.
+		u32 completed_lines_{ 0 }; // Lines of the back buffer drawn so far, only used by the emulation thread.
+		// Progress of the back buffer: (frame number << 10) | (completed lines << 2) | buffer index.
+		std::atomic<u64> progress_{ 0 };
+		u64 band_frame_{ 0 }; // Frame of the lines in the texture, only used by the render thread.
+		u32 band_lines_{ 0 }; // Lines of band_frame_ in the texture, only used by the render thread.
+		u64 presented_line_{ 0 }; // Newest line in the texture (frame * height + line), only used by the render thread.
+		// Input-to-photon measurement: started by the emulation thread when input is applied, completed by the render
+		// thread once a line drawn afterwards is uploaded.
+		std::atomic<bool> probe_pending_{ false };
+		u64 probe_line_{ 0 };
+		u64 probe_time_ns_{ 0 };
+		u64 hashes_[3]{};
+		u64 uploaded_hash_{ 0 }; // Only used by the render thread.
+		bool has_uploaded_{ false }; // Only used by the render thread.
+		u32 back_{ 0 }; // Only used by the emulation thread.
+		u32 front_{ 1 }; // Only used by the render thread.
+		bool front_pending_{ false }; // Front buffer not uploaded yet, only used by the render thread.
+		std::atomic<u32> middle_{ 2 }; // Index of the middle buffer, possibly with the new frame flag.
+		scaler scaler_;
+		std::unique_ptr<ntsc_filter> ntsc_;
+		std::unique_ptr<worker_pool> workers_; // Scales bands of rows in parallel, only used by the render thread.
 
 	public:
-		explicit display_sdl() = default;
+		explicit display_sdl(scaler const& s);
 
-		auto get_texture() const -> SDL_Texture* { return texture_; }
-		auto set_texture(SDL_Texture* v) -> void { texture_ = v; }
+		auto get_texture_width() const -> u32 { return ntsc_ ? ntsc_->get_output_width() : width * scaler_.factor; }
+		auto get_texture_height() const -> u32 { return height * scaler_.factor; }
 
 		auto switch_buffers() -> void override;
+		auto end_scanline(u32 y) -> void override;
 		auto set(u32 x, u32 y, rgb value) -> void override;
+		auto set_index(u32 x, u32 y, u16 pixel) -> void override;
+
+		/// Copy the newest frame into the (streaming) texture, called on the render thread. Returns false if no frame
+		/// with new content has been completed since the last call.
+		auto upload(SDL_Texture*) -> bool;
+		/// Copy the next band of completed lines of the frame which is currently being drawn into the texture, called on
+		/// the render thread (without CPU scaling). Returns false if there is no complete band, or if it was overwritten
+		/// while copying it, in which case the texture keeps the lines of the last complete frame.
+		auto upload_lines(SDL_Texture*) -> bool;
+
+		/// Start measuring the latency of input received at the given time (on the emulation thread, after applying it).
+		/// Only one measurement runs at a time.
+		auto begin_latency_probe(u64 input_time_ns) -> void;
+		/// Complete the measurement if the texture contains a line drawn after the input was applied (on the render
+		/// thread, after presenting it). Returns the latency, or 0 if the measurement is not complete.
+		auto end_latency_probe(u64 present_time_ns) -> u64;
+
+	private:
+		auto scale(pixel_view<u32> target, u32 first_row, u32 row_count) const -> void;
 	};
 } // namespace nes::app::sdl
@@ -1,16 +1,94 @@
 #include "impl/input-device-keyboard-sdl.hh"
+#include "nes/common/utils.hh"
 #include <SDL3/SDL_keycode.h>
 
 namespace nes::app::sdl
 {
 	auto input_device_keyboard_sdl::handle_key_down(SDL_Event* event) -> void
 	{
-		if (auto key = convert_key(event->key.scancode)) { buffer_.key_down(*key); }
+		if (auto key = convert_key(event->key.scancode))
+		{
+			update_snapshot(*key, true, event->key.timestamp);
+			push_change(*key, true);
+		}
 	}
 
 	auto input_device_keyboard_sdl::handle_key_up(SDL_Event* event) -> void
 	{
-		if (auto key = convert_key(event->key.scancode)) { buffer_.key_up(*key); }
+		if (auto key = convert_key(event->key.scancode))
+		{
+			update_snapshot(*key, false, event->key.timestamp);
+			push_change(*key, false);
+		}
+	}
+
+	auto input_device_keyboard_sdl::update_snapshot(key const key, bool const pressed, u64 const timestamp_ns) -> void
+	{
+		auto buttons = pressed_buttons_;
+		for (auto const& b : button_keys)
+		{
+			if (b.k != key) { continue; }
+			if (pressed) { buttons.add(b.button); }
+			else if (buttons.contains(b.button)) { buttons.remove(b.button); }
+		}
+		if (buttons.get_raw_value() == pressed_buttons_.get_raw_value()) { return; }
+
+		pressed_buttons_ = buttons;
+		buttons_changed_ns_.store(timestamp_ns, std::memory_order_relaxed);
+		buttons_snapshot_.store(buttons.get_raw_value(), std::memory_order_release);
+	}
+
+	auto input_device_keyboard_sdl::read_buttons_now() -> sys::button_mask
+	{
+		auto const buttons = sys::button_mask::from_raw_value(buttons_snapshot_.load(std::memory_order_acquire));
+		if (buttons.get_raw_value() != latched_buttons_.get_raw_value())
+		{
+			// The timestamp may already belong to a newer change, which only makes the age appear shorter.
+			auto const changed_ns = buttons_changed_ns_.load(std::memory_order_relaxed);
+			auto const now_ns = SDL_GetTicksNS();
+			auto const age_us = static_cast<u32>(now_ns > changed_ns ? (now_ns - changed_ns) / 1000 : 0);
+			input_age_histogram_[min(age_us / input_age_bucket_us, input_age_bucket_count - 1)] += 1;
+			input_age_count_ += 1;
+			max_input_age_us_ = max(max_input_age_us_, age_us);
+			latched_buttons_ = buttons;
+		}
+		return buttons;
+	}
+
+	auto input_device_keyboard_sdl::get_input_age_percentile_us(u32 const percent) const -> u32
+	{
+		auto const target = (input_age_count_ * min(percent, u32{ 100 }) + 99) / 100;
+		auto count = u64{ 0 };
+		for (auto i = u32{ 0 }; i < input_age_bucket_count; ++i)
+		{
+			count += input_age_histogram_[i];
+			if (count >= target && count > 0) { return (i + 1) * input_age_bucket_us; }
+		}
+
+		return 0;
+	}
+
+	auto input_device_keyboard_sdl::push_change(key const key, bool const pressed) -> void
+	{
+		auto const write = queue_write_.load(std::memory_order_relaxed);
+		// Drop the change if the emulation thread is hanging.
+		if (write - queue_read_.load(std::memory_order_acquire) == queue_size) { return; }
+
+		queue_[write % queue_size] = key_change{ key, pressed };
+		queue_write_.store(write + 1, std::memory_order_release);
+	}
+
+	auto input_device_keyboard_sdl::apply_changes() -> void
+	{
+		auto read = queue_read_.load(std::memory_order_relaxed);
+		auto const write = queue_write_.load(std::memory_order_acquire);
+		for (; read != write; ++read)
+		{
+			auto const change = queue_[read % queue_size];
+			if (change.pressed) { buffer_.key_down(change.k); }
+			else { buffer_.key_up(change.k); }
+		}
+		queue_read_.store(read, std::memory_order_release);
 	}
 
 	auto input_device_keyboard_sdl::convert_key(SDL_Scancode code) const -> std::optional<key>
@@ -2,6 +2,7 @@
 
 #include "nes/app/input/input-device-keyboard.hh"
 #include "nes/app/input/input-buffer.hh"
+#include <atomic>
 #include <optional>
 
 #include <SDL3/SDL.h>
@@ -9,20 +10,61 @@
 namespace nes::app::sdl
 {
 	/// Keyboard implementation using SDL.
+	///
+	/// Events are received on the main thread, but the application runs on the emulation thread. Key changes are passed
+	/// through a lock-free queue and applied to the input buffer by apply_changes. In addition, the main thread publishes
+	/// a snapshot of the controller buttons, which is sampled by read_buttons_now when the game latches the controller
+	/// (so button changes do not have to wait for the next frame).
 	class input_device_keyboard_sdl final : public input_device_keyboard
 	{
+	public:
+		static constexpr auto input_age_bucket_count = u32{ 128 };
+		static constexpr auto input_age_bucket_us = u32{ 250 };
+
+	private:
+		struct key_change
+		{
+			key k{};
+			bool pressed{ false };
+		};
+
+		static constexpr auto queue_size = u32{ 256 };
+
 		input_buffer buffer_;
+		key_change queue_[queue_size]{};
+		std::atomic<u32> queue_read_{ 0 };
+		std::atomic<u32> queue_write_{ 0 };
+
+		sys::button_mask pressed_buttons_{}; // Only accessed on the main thread.
+		std::atomic<u8> buttons_snapshot_{ 0 };
+		std::atomic<u64> buttons_changed_ns_{ 0 };
+		// Only accessed on the emulation thread.
+		sys::button_mask latched_buttons_{};
+		u32 input_age_histogram_[input_age_bucket_count]{};
+		u64 input_age_count_{ 0 };
+		u32 max_input_age_us_{ 0 };
 
 	public:
 		explicit input_device_keyboard_sdl() = default;
 
 		auto handle_key_down(SDL_Event*) -> void;
 		auto handle_key_up(SDL_Event*) -> void;
+		/// Apply the key changes received since the last call (called on the emulation thread).
+		auto apply_changes() -> void;
 
 		auto read_key(key const key) -> bool override { return buffer_.read_key(key); }
 		auto poll_event() -> input_event override { return buffer_.poll_event(); }
+		auto read_buttons_now() -> sys::button_mask override;
+
+		// Statistics of the button changes' ages (time from the key event until the game latched the change).
+		auto get_input_age_count() const -> u64 { return input_age_count_; }
+		auto get_max_input_age_us() const -> u32 { return max_input_age_us_; }
+		/// Upper bound of the given percentile of the ages (at histogram resolution).
+		auto get_input_age_percentile_us(u32 percent) const -> u32;
 
 	private:
+		auto push_change(key, bool pressed) -> void;
+		auto update_snapshot(key, bool pressed, u64 timestamp_ns) -> void;
 		auto convert_key(SDL_Scancode) const -> std::optional<key>;
 	};
 } // namespace nes::app::sdl
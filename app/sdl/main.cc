@@ -1,15 +1,105 @@
 #include "state.hh"
 #include <SDL3/SDL_init.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
 
 #define SDL_MAIN_USE_CALLBACKS
 #include <SDL3/SDL_main.h>
 
+namespace
+{
+	using scaler_kind = nes::app::sdl::display_sdl::scaler_kind;
+
+	struct scaler_name
+	{
+		char const* name;
+		scaler_kind kind;
+		nes::u32 factor;
+	};
+
+	constexpr scaler_name scaler_names[]
+	{
+		{ "nearest2", scaler_kind::nearest, 2 },
+		{ "nearest3", scaler_kind::nearest, 3 },
+		{ "nearest4", scaler_kind::nearest, 4 },
+		{ "scale2x", scaler_kind::scale_nx, 2 },
+		{ "scale3x", scaler_kind::scale_nx, 3 },
+		{ "xbr2", scaler_kind::xbr_lite, 2 },
+		{ "xbr3", scaler_kind::xbr_lite, 3 },
+		{ "xbr4", scaler_kind::xbr_lite, 4 },
+	};
+} // namespace
+
 auto SDL_AppInit(void** appstate, int argc, char** argv) -> SDL_AppResult
 {
-	(void)argc;
-	(void)argv;
+	auto test_tone = false;
+	auto movie_path = std::string{ "movie.nesm" };
+	auto display_sync = true;
+	auto beam_racing = false;
+	auto scaler = nes::app::sdl::display_sdl::scaler{};
+	scaler.thread_count = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+	for (auto i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--test-tone") == 0)
+		{
+			test_tone = true;
+		}
+		else if (std::strcmp(argv[i], "--no-display-sync") == 0)
+		{
+			display_sync = false;
+		}
+		else if (std::strcmp(argv[i], "--beam-racing") == 0)
+		{
+			beam_racing = true;
+		}
+		else if (std::strcmp(argv[i], "--movie") == 0 && i + 1 < argc)
+		{
+			movie_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--scaler") == 0 && i + 1 < argc)
+		{
+			auto const name = argv[++i];
+			auto const it = std::find_if(
+				std::begin(scaler_names), std::end(scaler_names),
+				[name](scaler_name const& n) { return std::strcmp(n.name, name) == 0; });
+			if (it == std::end(scaler_names))
+			{
+				std::cerr << "Unknown scaler " << name << " (available: nearest2-4, scale2x, scale3x, xbr2-4)" << std::endl;
+				return SDL_APP_FAILURE;
+			}
+			scaler.kind = it->kind;
+			scaler.factor = it->factor;
+		}
+		else if (std::strcmp(argv[i], "--ntsc") == 0 || std::strcmp(argv[i], "--ntsc-wide") == 0)
+		{
+			using layout = nes::app::ntsc_filter::layout;
+			scaler.kind = scaler_kind::ntsc;
+			scaler.ntsc_layout = std::strcmp(argv[i], "--ntsc-wide") == 0 ? layout::wide : layout::standard;
+		}
+		else if (std::strcmp(argv[i], "--scaler-threads") == 0 && i + 1 < argc)
+		{
+			scaler.thread_count = static_cast<nes::u32>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else
+		{
+			std::cerr << "Usage:\n";
+			std::cerr << "  " << argv[0] << " [--test-tone] [--no-display-sync] [--beam-racing] [--movie <path>]"
+				<< " [--scaler <name> | --ntsc | --ntsc-wide] [--scaler-threads <count>]" << std::endl;
+			return SDL_APP_FAILURE;
+		}
+	}
+
+	if (beam_racing && scaler.kind != scaler_kind::none)
+	{
+		std::cerr << "Beam racing is not supported with scalers or the NTSC filter" << std::endl;
+		return SDL_APP_FAILURE;
+	}
 
-	auto const state = new nes::app::sdl::state;
+	auto const state = new nes::app::sdl::state{ test_tone, movie_path, display_sync, scaler, beam_racing };
 	*appstate = state;
 
 	return state->get_status() == nes::status::success ? SDL_APP_CONTINUE : SDL_APP_FAILURE;
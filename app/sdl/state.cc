@@ -1,16 +1,42 @@
 #include "state.hh"
+#include "nes/common/utils.hh"
 #include <SDL3/SDL_events.h>
 #include <SDL3/SDL_video.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 
 namespace nes::app::sdl
 {
-	state::state()
-		: application_{ display_, keyboard_, file_browser_ }
+	namespace
 	{
+		// Enough for about 10 minutes of gameplay in most games.
+		constexpr auto rewind_storage_size = u32{ 32 * 1024 * 1024 };
+		// Each change of input takes 4 bytes, which is enough for hours of gameplay.
+		constexpr auto movie_storage_size = u32{ 4 * 1024 * 1024 };
+		// One line of the console takes 341 dots at 5.369318 MHz.
+		constexpr auto scanline_ns = 63556.0;
+		constexpr auto band_ns = static_cast<u64>(display_sdl::band_height * scanline_ns);
+		constexpr auto max_slice_ns = 4 * frame_pacer::console_period_ns;
+	} // namespace
+
+	state::state(
+		bool const test_tone, std::string movie_path, bool const display_sync, display_sdl::scaler const& scaler,
+		bool const beam_racing)
+		: beam_racing_{ beam_racing }
+		, rewind_storage_{ std::make_unique<u8[]>(rewind_storage_size) }
+		, movie_path_{ std::move(movie_path) }
+		, movie_storage_{ std::make_unique<u8[]>(movie_storage_size) }
+		, display_{ scaler }
+		, application_{ display_, keyboard_, file_browser_ }
+	{
+		application_.set_rewind_storage(span{ rewind_storage_.get(), rewind_storage_size });
+
 		SDL_SetAppMetadata("NES", "1.0", "com.github.hannesschulze.nes");
 
-		if (!SDL_Init(SDL_INIT_VIDEO))
+		if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO))
 		{
 			std::cerr << "Couldn't initialize SDL: " << SDL_GetError() << std::endl;
 			status_ = status::error_system_error;
@@ -26,7 +52,27 @@ namespace nes::app::sdl
 
 		SDL_SetRenderVSync(renderer_, SDL_RENDERER_VSYNC_ADAPTIVE);
 
-		if (!(texture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBX8888, SDL_TEXTUREACCESS_STREAMING, display::width, display::height)))
+		auto const* mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window_));
+		auto const refresh_period_ns = mode && mode->refresh_rate > 0.0f
+			? static_cast<u64>(1e9 / static_cast<double>(mode->refresh_rate))
+			: u64{ 0 };
+
+		// With vsync, bands can only be shown on the next refresh. Unless the display refreshes at least twice per
+		// frame of the console, that is not any earlier than the complete frame, and only mixes lines of two frames.
+		if (beam_racing_ && (refresh_period_ns == 0 || 2 * refresh_period_ns > frame_pacer::console_period_ns))
+		{
+			std::cout << "beam racing: the display refreshes too slowly for presenting bands, presenting whole frames"
+				<< std::endl;
+			beam_racing_ = false;
+		}
+
+		if (display_sync && !beam_racing_ && refresh_period_ns != 0 && pacer_.sync_to_display(refresh_period_ns))
+		{
+			// Only whole frames are presented, so each present marks a refresh of the display.
+			std::cout << "pacing: synchronized to the display (" << mode->refresh_rate << " Hz)" << std::endl;
+		}
+
+		if (!(texture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBX8888, SDL_TEXTUREACCESS_STREAMING, display_.get_texture_width(), display_.get_texture_height())))
 		{
 			std::cerr << "Couldn't create texture: " << SDL_GetError() << std::endl;
 			status_ = status::error_system_error;
@@ -40,19 +86,47 @@ namespace nes::app::sdl
 			return;
 		}
 
-		display_.set_texture(texture_);
+		// Missing audio is not fatal, the emulator just stays silent.
+		if (audio_.open() == status::success)
+		{
+			if (test_tone) { test_tone_.emplace(audio_.get_sample_rate(), 440, 8000); }
+			else { application_.set_audio_sink(&audio_); }
+		}
+
+		running_ = true;
+		emulation_thread_ = std::thread{ [this] { run_emulation(); } };
 	}
 
 	state::~state()
 	{
+		running_ = false;
+		if (emulation_thread_.joinable())
+		{
+			emulation_thread_.join();
+			report_pacing();
+			report_latency();
+			report_input_age();
+		}
 		if (texture_) { SDL_DestroyTexture(texture_); }
 	}
 
 	auto state::handle_event(SDL_Event* event) -> void
 	{
+		if (event->type == SDL_EVENT_KEY_DOWN || event->type == SDL_EVENT_KEY_UP)
+		{
+			// Recorded before passing on the key, so that the emulation thread cannot apply it earlier.
+			auto expected = u64{ 0 };
+			input_time_ns_.compare_exchange_strong(expected, max(static_cast<u64>(event->key.timestamp), u64{ 1 }));
+		}
+
 		switch (event->type)
 		{
 			case SDL_EVENT_KEY_DOWN:
+				if (event->key.scancode == SDL_SCANCODE_F9 && !event->key.repeat) { toggle_recording_requested_ = true; }
+				else if (event->key.scancode == SDL_SCANCODE_F10 && !event->key.repeat)
+				{
+					toggle_playback_requested_ = true;
+				}
 				keyboard_.handle_key_down(event);
 				break;
 			case SDL_EVENT_KEY_UP:
@@ -65,12 +139,8 @@ namespace nes::app::sdl
 
 	auto state::handle_iterate() -> void
 	{
-		auto const current = std::chrono::steady_clock::now();
-		auto const previous = last_time_point_.value_or(current);
-		last_time_point_ = current;
-
-		auto const elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(current - previous);
-		application_.frame(static_cast<u32>(elapsed_us.count()));
+		// Presenting waits for the next refresh, which shows the lines of the current frame completed until then.
+		if (!display_.upload(texture_) && beam_racing_) { display_.upload_lines(texture_); }
 
 		if (!SDL_RenderTexture(renderer_, texture_, nullptr, nullptr))
 		{
@@ -85,5 +155,228 @@ namespace nes::app::sdl
 			status_ = status::error_system_error;
 			return;
 		}
+
+		if (auto const latency_ns = display_.end_latency_probe(SDL_GetTicksNS())) { latencies_ns_.push_back(latency_ns); }
+
+		{
+			auto const lock = std::lock_guard{ refresh_mutex_ };
+			refresh_count_ += 1;
+		}
+		refresh_changed_.notify_one();
+	}
+
+	auto state::run_emulation() -> void
+	{
+		auto previous = std::chrono::steady_clock::now();
+		auto slice_remainder_ns = u64{ 0 };
+		auto last_refresh = u64{ 0 };
+		while (running_)
+		{
+			auto const current = std::chrono::steady_clock::now();
+			auto const elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(current - previous);
+			previous = current;
+
+			keyboard_.apply_changes();
+			if (auto const input_time_ns = input_time_ns_.exchange(0)) { display_.begin_latency_probe(input_time_ns); }
+			if (toggle_recording_requested_.exchange(false)) { toggle_recording(); }
+			if (toggle_playback_requested_.exchange(false)) { toggle_playback(); }
+
+			if (beam_racing_ && application_.is_game_running())
+			{
+				// Emulate the elapsed time in slices of one band, so that lines are completed about as fast as the
+				// display scans them out (the menus still run at the frame rate).
+				auto const slice_ns = min(static_cast<u64>(elapsed_ns.count()) + slice_remainder_ns, max_slice_ns);
+				slice_remainder_ns = slice_ns % 1000;
+				application_.frame(static_cast<u32>(slice_ns / 1000));
+				std::this_thread::sleep_until(current + std::chrono::nanoseconds{ band_ns });
+				continue;
+			}
+
+			auto const elapsed_us = pacer_.advance(static_cast<u64>(elapsed_ns.count()));
+			application_.frame(elapsed_us);
+			auto const frame_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - current);
+			report_run_ahead(elapsed_us, static_cast<u64>(frame_time_us.count()));
+			if (test_tone_) { play_test_tone(elapsed_us); }
+
+			if (pacer_.is_synced_to_display())
+			{
+				wait_for_refresh(last_refresh);
+			}
+			else
+			{
+				std::this_thread::sleep_until(current + std::chrono::nanoseconds{ pacer_.get_time_until_next_frame_ns() });
+			}
+		}
+	}
+
+	auto state::wait_for_refresh(u64& last_refresh) -> void
+	{
+		// Presenting does not wait for vsync while the window is hidden on some platforms, and stops while it is being
+		// moved on others. The pacer limits the former to one frame per refresh period, the timeout covers the latter
+		// (with the pacer catching up on the missed frame).
+		auto lock = std::unique_lock{ refresh_mutex_ };
+		refresh_changed_.wait_for(lock, std::chrono::nanoseconds{ 2 * frame_pacer::console_period_ns }, [&]
+		{
+			return refresh_count_ != last_refresh;
+		});
+		last_refresh = refresh_count_;
+	}
+
+	auto state::report_pacing() const -> void
+	{
+		auto const to_ms = [](u64 const ns) { return static_cast<double>(ns) / 1e6; };
+		std::cout << "pacing: " << pacer_.get_frame_count() << " frames"
+			<< ", " << pacer_.get_dropped_frames() << " dropped"
+			<< ", frame time p50 " << to_ms(pacer_.get_frame_time_percentile_ns(50)) << " ms"
+			<< ", p99 " << to_ms(pacer_.get_frame_time_percentile_ns(99)) << " ms"
+			<< ", max " << to_ms(pacer_.get_max_frame_time_ns()) << " ms" << std::endl;
+	}
+
+	auto state::report_latency() -> void
+	{
+		if (latencies_ns_.empty()) { return; }
+
+		// Measured from the input event to presenting the first line drawn after the console received it, which is the
+		// earliest the game could react.
+		std::sort(latencies_ns_.begin(), latencies_ns_.end());
+		auto const to_scanlines = [](u64 const ns) { return static_cast<double>(ns) / scanline_ns; };
+		auto const percentile = [&](std::size_t const p) { return latencies_ns_[(latencies_ns_.size() - 1) * p / 100]; };
+		std::cout << "latency: " << latencies_ns_.size() << " inputs"
+			<< ", input to photon p50 " << to_scanlines(percentile(50)) << " lines"
+			<< ", p99 " << to_scanlines(percentile(99)) << " lines"
+			<< ", max " << to_scanlines(latencies_ns_.back()) << " lines"
+			<< " (" << static_cast<double>(percentile(50)) / 1e6 << " ms median)" << std::endl;
+	}
+
+	auto state::report_input_age() const -> void
+	{
+		if (keyboard_.get_input_age_count() == 0) { return; }
+
+		// Measured from the key event until the game latched the controller (while the console is not running ahead).
+		std::cout << "input age: " << keyboard_.get_input_age_count() << " changes"
+			<< ", p50 " << keyboard_.get_input_age_percentile_us(50) << " us"
+			<< ", p99 " << keyboard_.get_input_age_percentile_us(99) << " us"
+			<< ", max " << keyboard_.get_max_input_age_us() << " us" << std::endl;
+	}
+
+	auto state::play_test_tone(u32 const elapsed_us) -> void
+	{
+		// Produce samples for the elapsed time using the rate requested by the sink, like the emulator would.
+		auto const rate = static_cast<i64>(audio_.get_sample_rate()) * (1000000 + audio_.get_rate_adjustment()) / 1000000;
+		auto const count = static_cast<u32>(min(rate * elapsed_us / 1000000, i64{ 4096 }));
+		i16 samples[4096];
+		test_tone_->generate(span{ samples, count });
+		audio_.write(span<i16 const>{ samples, count });
+
+		// Report the queue state once per second.
+		test_tone_elapsed_us_ += elapsed_us;
+		if (test_tone_elapsed_us_ >= 1000000)
+		{
+			test_tone_elapsed_us_ -= 1000000;
+			std::cout << "audio: fill " << audio_.get_fill() << "/" << audio_.get_capacity()
+				<< ", rate adjustment " << audio_.get_rate_adjustment() << " ppm"
+				<< ", underruns " << audio_.get_underruns()
+				<< ", overruns " << audio_.get_overruns() << std::endl;
+		}
+	}
+
+	auto state::toggle_recording() -> void
+	{
+		if (application_.is_recording())
+		{
+			auto const movie = application_.stop_recording();
+			auto file = std::ofstream{ movie_path_, std::ios::binary };
+			file.write(reinterpret_cast<char const*>(movie.get_data()), movie.get_length());
+			if (!file)
+			{
+				std::cerr << "Unable to write movie to " << movie_path_ << std::endl;
+				return;
+			}
+			std::cout << "movie: saved to " << movie_path_ << " (" << movie.get_length() << " bytes)" << std::endl;
+			return;
+		}
+
+		if (!application_.is_game_running()) { return; }
+
+		if (auto const s = application_.start_recording(span{ movie_storage_.get(), movie_storage_size });
+			s != status::success)
+		{
+			std::cerr << "Unable to start recording: " << to_string(s) << std::endl;
+			return;
+		}
+		std::cout << "movie: recording" << std::endl;
+	}
+
+	auto state::toggle_playback() -> void
+	{
+		if (application_.is_playing())
+		{
+			application_.stop_playback();
+			std::cout << "movie: playback stopped" << std::endl;
+			return;
+		}
+
+		if (!application_.is_game_running()) { return; }
+
+		auto file = std::ifstream{ movie_path_, std::ios::binary };
+		if (!file)
+		{
+			std::cerr << "Unable to read movie from " << movie_path_ << std::endl;
+			return;
+		}
+		movie_playback_.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+
+		auto const movie = span<u8 const>{ movie_playback_.data(), static_cast<u32>(movie_playback_.size()) };
+		if (auto const s = application_.start_playback(movie); s != status::success)
+		{
+			std::cerr << "Unable to play movie: " << to_string(s) << std::endl;
+			return;
+		}
+		std::cout << "movie: playing" << std::endl;
+	}
+
+	auto state::report_run_ahead(u32 const elapsed_us, u64 const frame_time_us) -> void
+	{
+		run_ahead_report_.elapsed_us += elapsed_us;
+		run_ahead_report_.frame_time_us += frame_time_us;
+		run_ahead_report_.frames += 1;
+		if (run_ahead_report_.elapsed_us < 1000000) { return; }
+
+		// The reaction time is measured from a change of the input until the picture changes, with or without
+		// run-ahead, so the latency saved can be compared by switching it in the settings.
+		auto const& timer = application_.get_reaction_timer();
+		auto const frames_ahead = application_.get_run_ahead_frames();
+		auto const reactions = timer.get_reactions() - run_ahead_report_.reactions;
+		if (reactions > 0)
+		{
+			auto const reaction_time_us = timer.get_reaction_time_us() - run_ahead_report_.reaction_time_us;
+			std::cout << "reaction: " << reactions << " inputs, "
+				<< static_cast<double>(reaction_time_us) / 1000.0 / static_cast<double>(reactions) << " ms on average"
+				<< " (run-ahead: " << frames_ahead << " frames)" << std::endl;
+		}
+
+		// Each frame emulated ahead costs emulating it (and restoring the state) on every presented frame.
+		auto const& statistics = application_.get_run_ahead_statistics();
+		if (frames_ahead > 0)
+		{
+			auto const presented = statistics.presented_frames - run_ahead_report_.last.presented_frames;
+			auto const emulated = statistics.emulated_frames - run_ahead_report_.last.emulated_frames;
+			auto const frame_time_ms = static_cast<double>(run_ahead_report_.frame_time_us) / 1000.0 /
+				static_cast<double>(run_ahead_report_.frames);
+			auto const factor = presented > 0 ? static_cast<double>(emulated) / static_cast<double>(presented) : 0.0;
+			std::cout << "run-ahead: " << frames_ahead << " frames"
+				<< ", " << factor << " frames emulated per presented frame"
+				<< ", " << frame_time_ms << " ms per frame"
+				<< " (+" << (factor > 0.0 ? frame_time_ms * (factor - 1.0) / factor : 0.0) << " ms for run-ahead)"
+				<< std::endl;
+		}
+
+		run_ahead_report_.elapsed_us = 0;
+		run_ahead_report_.frame_time_us = 0;
+		run_ahead_report_.frames = 0;
+		run_ahead_report_.last = statistics;
+		run_ahead_report_.reactions = timer.get_reactions();
+		run_ahead_report_.reaction_time_us = timer.get_reaction_time_us();
 	}
 } // namespace nes::app::sdl
@@ -2,36 +2,96 @@
 
 #include "nes/common/status.hh"
 #include "nes/app/application.hh"
+#include "nes/common/tone-generator.hh"
+#include "nes/common/frame-pacer.hh"
+#include "impl/audio-sink-sdl.hh"
 #include "impl/display-sdl.hh"
 #include "impl/input-device-keyboard-sdl.hh"
 #include "impl/file-browser-posix.hh"
-#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <SDL3/SDL.h>
 
 namespace nes::app::sdl
 {
 	/// Manages the SDL application lifecycle.
+	///
+	/// The application (including the emulation) runs on its own thread at the console's frame rate, while the main
+	/// thread handles SDL events and presents the newest frame at the display's refresh rate. With display sync, each
+	/// refresh (signaled by the main thread after presenting with vsync) starts the next frame instead.
 	class state
 	{
 		status status_{ status::success };
 		SDL_Window* window_{ nullptr };
 		SDL_Renderer* renderer_{ nullptr };
 		SDL_Texture* texture_{ nullptr };
-		std::optional<std::chrono::steady_clock::time_point> last_time_point_;
+		std::thread emulation_thread_;
+		std::atomic<bool> running_{ false };
+		// Requests from the main thread, handled on the emulation thread.
+		std::atomic<bool> toggle_recording_requested_{ false };
+		std::atomic<bool> toggle_playback_requested_{ false };
+		std::atomic<u64> input_time_ns_{ 0 }; // Time of the oldest input not applied yet (0 if none).
+		bool beam_racing_;
+		std::vector<u64> latencies_ns_; // Input-to-photon latencies, only used by the main thread.
+		frame_pacer pacer_;
+		// Number of frames presented by the main thread, which waits for vsync when presenting.
+		std::mutex refresh_mutex_;
+		std::condition_variable refresh_changed_;
+		u64 refresh_count_{ 0 };
+		std::optional<tone_generator> test_tone_;
+		u64 test_tone_elapsed_us_{ 0 };
+		std::unique_ptr<u8[]> rewind_storage_;
+		std::string movie_path_;
+		std::unique_ptr<u8[]> movie_storage_;
+		std::vector<u8> movie_playback_;
+		struct
+		{
+			u64 elapsed_us{ 0 };
+			u64 frame_time_us{ 0 };
+			u64 frames{ 0 };
+			application::run_ahead_statistics last{};
+			u64 reactions{ 0 };
+			u64 reaction_time_us{ 0 };
+		} run_ahead_report_{};
 		display_sdl display_;
+		audio_sink_sdl audio_;
 		input_device_keyboard_sdl keyboard_;
 		file_browser_posix file_browser_;
 		application application_;
 
 	public:
-		explicit state();
+		/// In test tone mode, the audio output plays a synthetic tone instead of the emulator output. Movies are
+		/// recorded to (F9) and played back from (F10) the given path. With display sync, the emulation runs one frame
+		/// per refresh of the display if its rate is close to the console's (not while beam racing). Frames are scaled
+		/// up on the CPU by the given scaler (otherwise only by the renderer). With beam racing, the emulation runs in
+		/// slices of a few lines, and each refresh of the display shows the lines completed so far. This needs a
+		/// display refreshing at least twice per frame, otherwise whole frames are presented.
+		explicit state(
+			bool test_tone, std::string movie_path, bool display_sync, display_sdl::scaler const& scaler,
+			bool beam_racing);
 		~state();
 
 		auto get_status() const -> status { return status_; }
 
 		auto handle_event(SDL_Event* event) -> void;
 		auto handle_iterate() -> void;
+
+	private:
+		auto run_emulation() -> void;
+		auto wait_for_refresh(u64& last_refresh) -> void;
+		auto play_test_tone(u32 elapsed_us) -> void;
+		auto toggle_recording() -> void;
+		auto toggle_playback() -> void;
+		auto report_run_ahead(u32 elapsed_us, u64 frame_time_us) -> void;
+		auto report_pacing() const -> void;
+		auto report_latency() -> void;
+		auto report_input_age() const -> void;
 	};
 } // namespace nes::app::sdl
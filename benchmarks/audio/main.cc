@@ -0,0 +1,167 @@
+#include "nes/common/audio-mixer.hh"
+#include "nes/common/band-limited-buffer.hh"
+#include "nes/common/containers/span.hh"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+// Compares the band-limited buffer against sampling the mixed output on every clock tick, using a synthetic signal
+// with a typical channel configuration (two pulse waves, a triangle wave and noise).
+
+namespace
+{
+	constexpr auto clock_rate = nes::u64{ 1789773 };
+	constexpr auto sample_rate = nes::u32{ 48000 };
+	constexpr auto frame_length = nes::u64{ 29781 };
+
+	struct voice
+	{
+		nes::u32 period;
+		nes::u32 countdown;
+		nes::u32 step;
+
+		auto clock() -> void
+		{
+			countdown = period;
+			step += 1;
+		}
+	};
+
+	struct signal
+	{
+		voice pulse_1{ 508, 508, 0 };
+		voice pulse_2{ 762, 762, 0 };
+		voice triangle{ 254, 254, 0 };
+		voice noise{ 32, 32, 0 };
+		nes::u32 lfsr{ 1 };
+
+		auto clock_noise() -> void
+		{
+			noise.clock();
+			auto const feedback = (lfsr ^ (lfsr >> 1)) & 1;
+			lfsr = (lfsr >> 1) | (feedback << 14);
+		}
+
+		auto get_level() const -> nes::i32
+		{
+			auto const triangle_step = triangle.step % 32;
+			return nes::audio_mixer::mix(
+				pulse_1.step % 8 < 4 ? 12 : 0,
+				pulse_2.step % 8 < 2 ? 8 : 0,
+				triangle_step < 16 ? 15 - triangle_step : triangle_step - 16,
+				(lfsr & 1) != 0 ? 0 : 4,
+				0);
+		}
+	};
+
+	auto run_per_tick(nes::u64 const seconds) -> nes::i64
+	{
+		auto s = signal{};
+		auto checksum = nes::i64{ 0 };
+		auto sum = nes::i64{ 0 };
+		auto count = nes::i64{ 0 };
+		auto fraction = nes::u64{ 0 };
+
+		for (auto tick = nes::u64{ 0 }; tick < seconds * clock_rate; ++tick)
+		{
+			if (--s.pulse_1.countdown == 0) { s.pulse_1.clock(); }
+			if (--s.pulse_2.countdown == 0) { s.pulse_2.clock(); }
+			if (--s.triangle.countdown == 0) { s.triangle.clock(); }
+			if (--s.noise.countdown == 0) { s.clock_noise(); }
+
+			// Box filter down to the output rate.
+			sum += s.get_level();
+			count += 1;
+			fraction += sample_rate;
+			if (fraction >= clock_rate)
+			{
+				fraction -= clock_rate;
+				checksum += sum / count;
+				sum = 0;
+				count = 0;
+			}
+		}
+
+		return checksum;
+	}
+
+	auto run_band_limited(nes::u64 const seconds) -> nes::i64
+	{
+		static auto buffer = nes::band_limited_buffer{ clock_rate, sample_rate };
+		buffer.reset(0);
+
+		auto s = signal{};
+		auto checksum = nes::i64{ 0 };
+		auto level = nes::i32{ 0 };
+		auto time = nes::u64{ 0 };
+		nes::i16 samples[nes::band_limited_buffer::max_samples]{};
+
+		for (auto frame_end = frame_length; frame_end <= seconds * clock_rate; frame_end += frame_length)
+		{
+			while (true)
+			{
+				auto next = s.pulse_1.countdown;
+				if (s.pulse_2.countdown < next) { next = s.pulse_2.countdown; }
+				if (s.triangle.countdown < next) { next = s.triangle.countdown; }
+				if (s.noise.countdown < next) { next = s.noise.countdown; }
+				if (time + next > frame_end) { break; }
+
+				time += next;
+				s.pulse_1.countdown -= next;
+				s.pulse_2.countdown -= next;
+				s.triangle.countdown -= next;
+				s.noise.countdown -= next;
+				if (s.pulse_1.countdown == 0) { s.pulse_1.clock(); }
+				if (s.pulse_2.countdown == 0) { s.pulse_2.clock(); }
+				if (s.triangle.countdown == 0) { s.triangle.clock(); }
+				if (s.noise.countdown == 0) { s.clock_noise(); }
+
+				auto const new_level = s.get_level();
+				buffer.add_delta(time, new_level - level);
+				level = new_level;
+			}
+
+			buffer.end_frame(frame_end);
+			auto const count = buffer.read_samples(nes::span{ samples });
+			for (auto i = nes::u32{ 0 }; i < count; ++i) { checksum += samples[i]; }
+		}
+
+		return checksum;
+	}
+
+	template<typename Function>
+	auto measure(char const* name, nes::u64 const seconds, Function const& function) -> double
+	{
+		auto const start = std::chrono::steady_clock::now();
+		auto const checksum = function(seconds);
+		auto const end = std::chrono::steady_clock::now();
+		auto const elapsed = std::chrono::duration<double>(end - start).count();
+
+		std::cout << name << ": " << elapsed * 1000.0 / static_cast<double>(seconds) << " ms per emulated second ("
+			<< static_cast<double>(seconds) / elapsed << "x real-time, checksum " << checksum << ")" << std::endl;
+		return elapsed;
+	}
+} // namespace
+
+auto main(int const argc, char** argv) -> int
+{
+	if (argc > 2)
+	{
+		std::cerr << "Usage:\n";
+		std::cerr << "  " << argv[0] << " [<emulated seconds>]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto const seconds = argc == 2 ? std::strtoull(argv[1], nullptr, 10) : nes::u64{ 60 };
+	if (seconds == 0)
+	{
+		std::cerr << "Invalid number of seconds" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto const per_tick = measure("per-tick sampling", seconds, run_per_tick);
+	auto const band_limited = measure("band-limited buffer", seconds, run_band_limited);
+	std::cout << "band-limited buffer takes " << band_limited / per_tick * 100.0 << "% of the per-tick time" << std::endl;
+
+	return EXIT_SUCCESS;
+}
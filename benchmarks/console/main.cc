@@ -0,0 +1,305 @@
+#include "nes/sys/nes.hh"
+#include "nes/sys/rom-image.hh"
+#include "nes/common/display.hh"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs a ROM for a fixed number of frames without any output and reports the emulation speed. Frames are stepped
+// exactly (independent of the wall-clock time), and the input is either empty or read from a script, so that the
+// same work is measured in every run. The final state hash shows whether two runs are comparable at all.
+//
+// Input scripts contain one line per input change, consisting of the frame number and the buttons pressed on each
+// controller from that frame on (joined using "+", or "-" for none), for example:
+//
+//   # Skip the title screen and walk right.
+//   60 start
+//   61 -
+//   120 right+b -
+
+namespace
+{
+	/// Discards all frames, only the emulation itself is measured.
+	class null_display final : public nes::display
+	{
+	public:
+		auto switch_buffers() -> void override {}
+		auto set(nes::u32, nes::u32, nes::rgb) -> void override {}
+	};
+
+	struct input_change
+	{
+		nes::u64 frame;
+		nes::sys::button_mask controller_1;
+		nes::sys::button_mask controller_2;
+	};
+
+	struct options
+	{
+		char const* rom_path{ nullptr };
+		char const* script_path{ nullptr };
+		nes::u64 frames{ 3600 };
+		nes::u64 warmup_frames{ 60 };
+		bool json{ false };
+	};
+
+	struct result
+	{
+		nes::u64 frames{ 0 };
+		nes::u64 instructions{ 0 };
+		nes::u64 cpu_cycles{ 0 };
+		nes::u64 ppu_dots{ 0 };
+		double elapsed_s{ 0.0 };
+		nes::u64 state_hash{ 0 };
+	};
+
+	auto read_file(char const* path, std::vector<nes::u8>& result) -> bool
+	{
+		auto file = std::ifstream{ path, std::ios::binary };
+		if (!file) { return false; }
+
+		result.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+		return true;
+	}
+
+	auto parse_buttons(std::string const& text, nes::sys::button_mask& result) -> bool
+	{
+		constexpr char const* names[]{ "a", "b", "select", "start", "up", "down", "left", "right" };
+
+		result = nes::sys::button_mask{};
+		if (text == "-") { return true; }
+
+		auto stream = std::istringstream{ text };
+		auto name = std::string{};
+		while (std::getline(stream, name, '+'))
+		{
+			auto found = false;
+			for (auto i = nes::u32{ 0 }; i < 8; ++i)
+			{
+				if (name != names[i]) { continue; }
+				result.add(nes::sys::button_mask::from_raw_value(static_cast<nes::u8>(1 << i)));
+				found = true;
+			}
+			if (!found) { return false; }
+		}
+
+		return true;
+	}
+
+	auto read_script(char const* path, std::vector<input_change>& result) -> bool
+	{
+		auto file = std::ifstream{ path };
+		if (!file) { return false; }
+
+		auto line = std::string{};
+		auto line_number = 0;
+		while (std::getline(file, line))
+		{
+			line_number += 1;
+			auto stream = std::istringstream{ line };
+			auto change = input_change{ 0, nes::sys::button_mask{}, nes::sys::button_mask{} };
+			auto controller_1 = std::string{};
+			auto controller_2 = std::string{ "-" };
+			if (!(stream >> change.frame))
+			{
+				// Allow empty lines and comments.
+				auto first = std::string{};
+				if (std::istringstream{ line } >> first && first[0] != '#')
+				{
+					std::cerr << path << ":" << line_number << ": expected a frame number" << std::endl;
+					return false;
+				}
+				continue;
+			}
+
+			stream >> controller_1 >> controller_2;
+			if (!parse_buttons(controller_1, change.controller_1) || !parse_buttons(controller_2, change.controller_2))
+			{
+				std::cerr << path << ":" << line_number << ": invalid buttons" << std::endl;
+				return false;
+			}
+			if (!result.empty() && change.frame < result.back().frame)
+			{
+				std::cerr << path << ":" << line_number << ": frames must be in ascending order" << std::endl;
+				return false;
+			}
+
+			result.push_back(change);
+		}
+
+		return true;
+	}
+
+	auto parse_options(int const argc, char** argv, options& result) -> bool
+	{
+		for (auto i = 1; i < argc; ++i)
+		{
+			auto const has_value = i + 1 < argc;
+			if (std::strcmp(argv[i], "--frames") == 0 && has_value)
+			{
+				result.frames = std::strtoull(argv[++i], nullptr, 10);
+				if (result.frames == 0) { return false; }
+			}
+			else if (std::strcmp(argv[i], "--warmup") == 0 && has_value)
+			{
+				result.warmup_frames = std::strtoull(argv[++i], nullptr, 10);
+			}
+			else if (std::strcmp(argv[i], "--input") == 0 && has_value)
+			{
+				result.script_path = argv[++i];
+			}
+			else if (std::strcmp(argv[i], "--json") == 0)
+			{
+				result.json = true;
+			}
+			else if (argv[i][0] != '-' && !result.rom_path)
+			{
+				result.rom_path = argv[i];
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return result.rom_path != nullptr;
+	}
+
+	/// Run frames (with the inputs of the script applied) until the given frame has been completed.
+	auto run(
+		nes::sys::nes& console, std::vector<input_change> const& script, std::size_t& next_change, nes::u64 const end)
+		-> nes::u64
+	{
+		auto instructions = nes::u64{ 0 };
+		while (console.get_frame_count() < end && console.get_status() == nes::status::success)
+		{
+			auto const frame = console.get_frame_count();
+			while (next_change < script.size() && script[next_change].frame <= frame)
+			{
+				console.ref_controller_1().set_pressed(script[next_change].controller_1);
+				console.ref_controller_2().set_pressed(script[next_change].controller_2);
+				next_change += 1;
+			}
+
+			// Like nes::run_frame (but finishing the PPU catch-up), counting the instructions.
+			while (console.get_frame_count() == frame && console.get_status() == nes::status::success)
+			{
+				console.step();
+				instructions += 1;
+			}
+		}
+
+		return instructions;
+	}
+
+	auto print_text(options const& o, result const& r) -> void
+	{
+		auto const elapsed_s = r.elapsed_s;
+		std::cout << "rom:                     " << o.rom_path << "\n";
+		std::cout << "frames:                  " << r.frames << " (after " << o.warmup_frames << " warmup frames)\n";
+		std::cout << "elapsed:                 " << elapsed_s * 1000.0 << " ms\n";
+		std::cout << "frames per second:       " << static_cast<double>(r.frames) / elapsed_s << "\n";
+		std::cout << "emulated CPU clock:      " << static_cast<double>(r.cpu_cycles) / elapsed_s / 1e6 << " MHz\n";
+		std::cout << "instructions per second: " << static_cast<double>(r.instructions) / elapsed_s << "\n";
+		std::cout << "time per PPU dot:        " << elapsed_s * 1e9 / static_cast<double>(r.ppu_dots) << " ns\n";
+		std::cout << "state hash:              " << std::hex << std::setw(16) << std::setfill('0') << r.state_hash
+			<< std::dec << std::endl;
+	}
+
+	auto print_json(options const& o, result const& r) -> void
+	{
+		auto const elapsed_s = r.elapsed_s;
+		std::cout << "{\n";
+		// Paths are only escaped minimally, which is enough for typical file names.
+		std::cout << "  \"rom\": \"";
+		for (auto const* c = o.rom_path; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\') { std::cout << '\\'; }
+			std::cout << *c;
+		}
+		std::cout << "\",\n";
+		std::cout << "  \"input\": " << (o.script_path ? "true" : "false") << ",\n";
+		std::cout << "  \"frames\": " << r.frames << ",\n";
+		std::cout << "  \"warmup_frames\": " << o.warmup_frames << ",\n";
+		std::cout << "  \"instructions\": " << r.instructions << ",\n";
+		std::cout << "  \"cpu_cycles\": " << r.cpu_cycles << ",\n";
+		std::cout << "  \"ppu_dots\": " << r.ppu_dots << ",\n";
+		std::cout << "  \"elapsed_s\": " << elapsed_s << ",\n";
+		std::cout << "  \"frames_per_second\": " << static_cast<double>(r.frames) / elapsed_s << ",\n";
+		std::cout << "  \"cpu_mhz\": " << static_cast<double>(r.cpu_cycles) / elapsed_s / 1e6 << ",\n";
+		std::cout << "  \"instructions_per_second\": " << static_cast<double>(r.instructions) / elapsed_s << ",\n";
+		std::cout << "  \"ns_per_ppu_dot\": " << elapsed_s * 1e9 / static_cast<double>(r.ppu_dots) << ",\n";
+		std::cout << "  \"state_hash\": \"" << std::hex << std::setw(16) << std::setfill('0') << r.state_hash
+			<< std::dec << "\"\n";
+		std::cout << "}" << std::endl;
+	}
+} // namespace
+
+auto main(int const argc, char** argv) -> int
+{
+	auto o = options{};
+	if (!parse_options(argc, argv, o))
+	{
+		std::cerr << "Usage:\n";
+		std::cerr << "  " << argv[0] << " <rom> [--frames <count>] [--warmup <count>] [--input <script>] [--json]"
+			<< std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto rom_data = std::vector<nes::u8>{};
+	if (!read_file(o.rom_path, rom_data))
+	{
+		std::cerr << "Unable to read " << o.rom_path << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto script = std::vector<input_change>{};
+	if (o.script_path && !read_script(o.script_path, script))
+	{
+		std::cerr << "Unable to read input script " << o.script_path << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto const rom = std::make_unique<nes::sys::rom_image>(
+		nes::span<nes::u8 const>{ rom_data.data(), static_cast<nes::u32>(rom_data.size()) });
+	if (rom->get_status() != nes::status::success)
+	{
+		std::cerr << "Unable to load cartridge: " << nes::to_string(rom->get_status()) << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto display = null_display{};
+	auto const console = std::make_unique<nes::sys::nes>(display, *rom);
+	auto next_change = std::size_t{ 0 };
+
+	// Warm up caches and branch predictors (the first frames are often not representative either).
+	run(*console, script, next_change, o.warmup_frames);
+
+	auto r = result{};
+	auto const start_cycles = console->get_cycles();
+	auto const start = std::chrono::steady_clock::now();
+	r.instructions = run(*console, script, next_change, o.warmup_frames + o.frames);
+	r.elapsed_s = std::chrono::duration<double>{ std::chrono::steady_clock::now() - start }.count();
+	r.frames = o.frames;
+	r.cpu_cycles = (console->get_cycles() - start_cycles).to_cpu();
+	r.ppu_dots = (console->get_cycles() - start_cycles).to_ppu();
+	r.state_hash = console->get_state_hash();
+
+	if (console->get_status() != nes::status::success)
+	{
+		std::cerr << "Runtime error: " << nes::to_string(console->get_status()) << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (o.json) { print_json(o, r); }
+	else { print_text(o, r); }
+	return EXIT_SUCCESS;
+}
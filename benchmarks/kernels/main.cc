@@ -0,0 +1,524 @@
+#include "nes/sys/cartridge.hh"
+#include "nes/sys/controller.hh"
+#include "nes/sys/cpu.hh"
+#include "nes/sys/ppu.hh"
+#include "nes/sys/apu.hh"
+#include "nes/sys/rom-image.hh"
+#include "nes/app/graphics/renderer.hh"
+#include "nes/app/graphics/mask-tile.hh"
+#include "nes/app/graphics/scalers/scalers.hh"
+#include "nes/app/graphics/ntsc-filter.hh"
+#include "nes/app/crypto/aes256.hh"
+#include "nes/app/crypto/sha256.hh"
+#include "nes/common/display.hh"
+#include "nes/common/frame-codec.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Measures isolated hot paths of the emulator and the UI, which end-to-end numbers (like nes_bench_console) hide.
+//
+// Each kernel runs a fixed batch of operations per repetition. After some warmup repetitions, the time per operation
+// is reported as the median and the 99th percentile over all repetitions.
+
+namespace
+{
+	constexpr auto default_warmup = 5u;
+	constexpr auto default_repetitions = 101u;
+
+	/// Discards everything, the sink is only there to keep the display calls from being optimized away.
+	class null_display final : public nes::display
+	{
+	public:
+		nes::u32 sink{ 0 };
+
+		auto switch_buffers() -> void override { sink += 1; }
+		auto set(nes::u32 const x, nes::u32, nes::rgb const value) -> void override { sink += x ^ value.r; }
+	};
+
+	/// The components of a console, wired up like in nes::sys::nes but accessible individually.
+	struct machine
+	{
+		null_display display;
+		nes::sys::cartridge cartridge;
+		nes::sys::controller controller_1;
+		nes::sys::controller controller_2;
+		nes::sys::ppu ppu;
+		nes::sys::apu apu;
+		nes::sys::cpu cpu;
+
+		explicit machine(nes::sys::rom_image const& rom)
+			: cartridge{ rom }
+			, ppu{ cpu, cartridge, display }
+			, apu{ cpu }
+			, cpu{ ppu, apu, cartridge, controller_1, controller_2 }
+		{
+		}
+	};
+
+	struct options
+	{
+		char const* rom_path{ nullptr };
+		char const* filter{ nullptr };
+		unsigned warmup{ default_warmup };
+		unsigned repetitions{ default_repetitions };
+	};
+
+	/// Run a batch of operations per repetition and report the time per operation. If bytes_per_operation is not 0,
+	/// the throughput is reported in MB/s instead of operations per second. Returns the checksum of the results, or
+	/// nothing if the kernel was filtered out.
+	template<typename Function>
+	auto measure(
+		options const& o, char const* name, nes::u64 const operations, nes::u64 const bytes_per_operation,
+		Function&& function) -> std::optional<nes::u64>
+	{
+		if (o.filter && !std::strstr(name, o.filter)) { return std::nullopt; }
+
+		auto checksum = nes::u64{ 0 };
+		for (auto i = 0u; i < o.warmup; ++i) { checksum += function(); }
+
+		auto samples = std::vector<double>{};
+		samples.reserve(o.repetitions);
+		for (auto i = 0u; i < o.repetitions; ++i)
+		{
+			auto const start = std::chrono::steady_clock::now();
+			checksum += function();
+			auto const end = std::chrono::steady_clock::now();
+			samples.push_back(std::chrono::duration<double, std::nano>{ end - start }.count() / static_cast<double>(operations));
+		}
+
+		std::sort(samples.begin(), samples.end());
+		auto const median = samples[samples.size() / 2];
+		auto const p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+
+		std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(10) << median << " ns/op (median)" << std::setw(10) << p99 << " ns/op (p99)";
+		if (bytes_per_operation > 0)
+		{
+			std::cout << std::setw(10) << static_cast<double>(bytes_per_operation) * 1e3 / median << " MB/s";
+		}
+		else
+		{
+			std::cout << std::setw(10) << 1e3 / median << " Mop/s";
+		}
+		std::cout << "   (checksum " << std::hex << (checksum & 0xFFFF) << std::dec << ")" << std::endl;
+		return checksum;
+	}
+
+	/// Build an NROM image with the program at $8000 (all vectors pointing to it) and pseudo-random CHR data.
+	auto make_rom(std::vector<nes::u8> const& program) -> std::vector<nes::u8>
+	{
+		constexpr auto prg_size = 16 * 1024;
+		constexpr auto chr_size = 8 * 1024;
+
+		auto res = std::vector<nes::u8>(16 + prg_size + chr_size, 0xEA); // Filled with NOPs.
+		nes::u8 const header[16]{ 'N', 'E', 'S', 0x1A, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+		std::copy(std::begin(header), std::end(header), res.begin());
+		std::copy(program.begin(), program.end(), res.begin() + 16);
+		for (auto vector = 0x3FFA; vector < 0x4000; vector += 2)
+		{
+			res[16 + vector + 0] = 0x00;
+			res[16 + vector + 1] = 0x80;
+		}
+
+		auto seed = nes::u32{ 1 };
+		for (auto i = 0; i < chr_size; ++i)
+		{
+			seed = seed * 1103515245 + 12345;
+			res[16 + prg_size + i] = static_cast<nes::u8>(seed >> 16);
+		}
+
+		return res;
+	}
+
+	/// Repeat an instruction sequence (filling most of the first 4 KiB) followed by a jump back to the start.
+	auto make_program(std::vector<nes::u8> const& sequence) -> std::vector<nes::u8>
+	{
+		auto res = std::vector<nes::u8>{};
+		while (res.size() + sequence.size() + 3 <= 0x0F00) { res.insert(res.end(), sequence.begin(), sequence.end()); }
+		res.insert(res.end(), { 0x4C, 0x00, 0x80 }); // JMP $8000
+		return res;
+	}
+
+	auto load_rom(std::vector<nes::u8> const& data) -> std::unique_ptr<nes::sys::rom_image>
+	{
+		auto res = std::make_unique<nes::sys::rom_image>(
+			nes::span<nes::u8 const>{ data.data(), static_cast<nes::u32>(data.size()) });
+		if (res->get_status() != nes::status::success)
+		{
+			std::cerr << "Unable to load cartridge: " << nes::to_string(res->get_status()) << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+		return res;
+	}
+
+	auto run_cpu_kernels(options const& o) -> void
+	{
+		struct group
+		{
+			char const* name;
+			std::vector<nes::u8> program;
+		};
+
+		// JSR/RTS needs a subroutine, which is placed at $8F00.
+		auto calls = make_program({ 0x20, 0x00, 0x8F }); // JSR $8F00
+		calls.resize(0x0F00, 0xEA);
+		calls.push_back(0x60); // RTS
+
+		group const groups[]
+		{
+			// LDA #, LDX zp, STA zp, LDY abs, STA abs,X, LDA abs,Y
+			{ "cpu/load-store", make_program({ 0xA9, 0x42, 0xA6, 0x10, 0x85, 0x20, 0xAC, 0x00, 0x03, 0x9D, 0x00, 0x03, 0xB9, 0x00, 0x04 }) },
+			// ADC #, SBC #, AND #, ORA #, EOR #, CMP #
+			{ "cpu/alu", make_program({ 0x69, 0x11, 0xE9, 0x05, 0x29, 0xF7, 0x09, 0x21, 0x49, 0x5A, 0xC9, 0x40 }) },
+			// INC zp, ASL zp, ROR A, DEC abs, LSR A
+			{ "cpu/read-modify-write", make_program({ 0xE6, 0x10, 0x06, 0x11, 0x6A, 0xCE, 0x00, 0x04, 0x4A }) },
+			// CLC, BCC +0 (taken), SEC, BCC +0 (not taken)
+			{ "cpu/branch", make_program({ 0x18, 0x90, 0x00, 0x38, 0x90, 0x00 }) },
+			// PHA, PHP, PLP, PLA
+			{ "cpu/stack", make_program({ 0x48, 0x08, 0x28, 0x68 }) },
+			// LDA (zp),Y, STA (zp,X), LDA zp,X
+			{ "cpu/indirect", make_program({ 0xB1, 0x30, 0x81, 0x30, 0xB5, 0x40 }) },
+			// TAX, INX, TAY, DEY, NOP, TXA
+			{ "cpu/implied", make_program({ 0xAA, 0xE8, 0xA8, 0x88, 0xEA, 0x8A }) },
+			{ "cpu/jsr-rts", calls },
+		};
+
+		constexpr auto instructions = nes::u64{ 100000 };
+		for (auto const& g : groups)
+		{
+			auto const data = make_rom(g.program);
+			auto const rom = load_rom(data);
+			auto const m = std::make_unique<machine>(*rom);
+			measure(o, g.name, instructions, 0, [&]
+			{
+				for (auto i = nes::u64{ 0 }; i < instructions; ++i) { m->cpu.step(); }
+				return static_cast<nes::u64>(m->cpu.get_state().registers.a);
+			});
+		}
+	}
+
+	auto run_ppu_kernels(options const& o, nes::sys::rom_image const& rom) -> void
+	{
+		struct variant
+		{
+			char const* name;
+			nes::u8 mask;
+		};
+
+		constexpr variant variants[]
+		{
+			{ "ppu/rendering-off", 0x00 },
+			{ "ppu/background", 0x0A },
+			{ "ppu/sprites", 0x14 },
+			{ "ppu/background+sprites", 0x1E },
+		};
+
+		// One frame worth of dots.
+		constexpr auto dots = nes::u64{ 341 * 262 };
+		auto checksums = std::vector<nes::u64>{};
+		for (auto const& v : variants)
+		{
+			auto const m = std::make_unique<machine>(rom);
+			for (auto i = nes::u32{ 0 }; i < 0x800; ++i) { m->ppu.ref_vram().write(i, static_cast<nes::u8>(i * 7)); }
+			for (auto i = nes::u16{ 0 }; i < 0x20; ++i) { m->ppu.write8(nes::sys::address{ static_cast<nes::u16>(0x3F00 + i) }, i); }
+			for (auto i = nes::u32{ 0 }; i < 64; ++i)
+			{
+				// Spread the sprites over the screen, with up to 8 sprites on some lines.
+				m->ppu.ref_oam().write(i * 4 + 0, static_cast<nes::u8>((i % 32) * 7));
+				m->ppu.ref_oam().write(i * 4 + 1, static_cast<nes::u8>(i));
+				m->ppu.ref_oam().write(i * 4 + 2, static_cast<nes::u8>(i & 0xE3));
+				m->ppu.ref_oam().write(i * 4 + 3, static_cast<nes::u8>(i * 13));
+			}
+			// The PPU ignores writes to PPUMASK until it has booted up, so the mask is set directly.
+			auto state = m->ppu.get_state();
+			state.mask.value = v.mask;
+			m->ppu.set_state(state);
+
+			auto const checksum = measure(o, v.name, dots, 0, [&]
+			{
+				for (auto i = nes::u64{ 0 }; i < dots; ++i) { m->ppu.step(); }
+				return static_cast<nes::u64>(m->display.sink);
+			});
+			if (checksum) { checksums.push_back(*checksum); }
+		}
+
+		// Each variant draws something different, otherwise the kernels measure the wrong thing.
+		std::sort(checksums.begin(), checksums.end());
+		if (std::adjacent_find(checksums.begin(), checksums.end()) != checksums.end())
+		{
+			std::cerr << "PPU kernels produced the same output for different masks" << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+	}
+
+	auto run_mapper_kernels(options const& o, nes::sys::rom_image const& rom) -> void
+	{
+		auto const m = std::make_unique<machine>(rom);
+		auto& mapper = m->cartridge.get_mapper();
+
+		constexpr auto cpu_reads = nes::u64{ 0x8000 };
+		measure(o, "mapper/read-cpu", cpu_reads, 0, [&]
+		{
+			auto res = nes::u64{ 0 };
+			for (auto i = nes::u64{ 0 }; i < cpu_reads; ++i)
+			{
+				res += mapper.read_cpu(nes::sys::address{ static_cast<nes::u16>(0x8000 + i) }, m->cartridge);
+			}
+			return res;
+		});
+
+		constexpr auto ppu_reads = nes::u64{ 0x3000 };
+		measure(o, "mapper/read-ppu", ppu_reads, 0, [&]
+		{
+			auto res = nes::u64{ 0 };
+			for (auto i = nes::u64{ 0 }; i < ppu_reads; ++i)
+			{
+				res += mapper.read_ppu(nes::sys::address{ static_cast<nes::u16>(i) }, m->cartridge, m->ppu.get_vram());
+			}
+			return res;
+		});
+
+		constexpr auto tile_rows = nes::u64{ 0x2000 };
+		measure(o, "mapper/read-ppu-tile-row", tile_rows, 0, [&]
+		{
+			auto res = nes::u64{ 0 };
+			for (auto i = nes::u64{ 0 }; i < tile_rows; ++i)
+			{
+				auto const row = (i & ~nes::u64{ 0xF }) | (i & 0x7); // Skip the second bitplane.
+				res += mapper.read_ppu_tile_row(nes::sys::address{ static_cast<nes::u16>(row) }, m->cartridge);
+			}
+			return res;
+		});
+	}
+
+	auto run_renderer_kernels(options const& o) -> void
+	{
+		auto display = null_display{};
+		auto r = nes::app::renderer{ display };
+
+		constexpr auto lines = nes::u64{ nes::app::renderer::height };
+		measure(o, "renderer/render-text", lines, 0, [&]
+		{
+			for (auto y = nes::u64{ 0 }; y < lines; ++y)
+			{
+				r.render_text(0, static_cast<nes::i32>(y), "THE QUICK BROWN FOX JUMPS OVER.", nes::app::color::foreground_primary);
+			}
+			return static_cast<nes::u64>(display.sink);
+		});
+
+		constexpr auto tiles = nes::u64{ nes::app::renderer::width * nes::app::renderer::height };
+		auto const tile = nes::app::mask_tile{ { 0x3C, 0x66, 0xC3, 0xFF, 0xC3, 0xC3, 0x66, 0x00 } };
+		measure(o, "renderer/render-mask-tile", tiles, 0, [&]
+		{
+			for (auto i = nes::u64{ 0 }; i < tiles; ++i)
+			{
+				auto const x = static_cast<nes::i32>(i % nes::app::renderer::width);
+				auto const y = static_cast<nes::i32>(i / nes::app::renderer::width);
+				r.render_mask_tile(x, y, tile, nes::app::color::accent_primary);
+			}
+			return static_cast<nes::u64>(display.sink);
+		});
+	}
+
+	auto run_scaler_kernels(options const& o) -> void
+	{
+		constexpr auto width = nes::display::width;
+		constexpr auto height = nes::display::height;
+		constexpr auto max_factor = nes::u32{ 4 };
+
+		// Pixel art with flat areas, diagonal stripes and some noise (one operation is a whole frame).
+		auto source = std::vector<nes::u32>(width * height);
+		for (auto y = nes::u32{ 0 }; y < height; ++y)
+		{
+			for (auto x = nes::u32{ 0 }; x < width; ++x)
+			{
+				auto color = ((x / 16 + y / 16) % 3) * nes::u32{ 0x40404000 };
+				if ((x + y) % 13 == 0) { color = 0xFF000000; }
+				if ((x * 7 + y * 13) % 97 == 0) { color = 0x00FF0000; }
+				source[y * width + x] = color;
+			}
+		}
+		auto target = std::vector<nes::u32>(width * height * max_factor * max_factor);
+
+		auto const run = [&](char const* name, nes::u32 const factor, auto const scale)
+		{
+			measure(o, name, 1, 0, [&]
+			{
+				auto const source_view = nes::app::pixel_view<nes::u32 const>{ source.data(), width, height, width };
+				auto const target_view = nes::app::pixel_view<nes::u32>{
+					target.data(), width * factor, height * factor, width * factor };
+				scale(source_view, target_view, factor, 0, height);
+				return static_cast<nes::u64>(target[target.size() / 2]);
+			});
+		};
+
+		run("scaler/nearest-2x", 2, nes::app::scale_nearest);
+		run("scaler/nearest-4x", 4, nes::app::scale_nearest);
+		run("scaler/scale2x", 2, nes::app::scale_nx);
+		run("scaler/scale3x", 3, nes::app::scale_nx);
+		run("scaler/xbr-lite-2x", 2, nes::app::scale_xbr_lite);
+		run("scaler/xbr-lite-4x", 4, nes::app::scale_xbr_lite);
+
+		auto raw = std::vector<nes::u16>(width * height);
+		for (auto i = nes::u32{ 0 }; i < width * height; ++i) { raw[i] = static_cast<nes::u16>((source[i] >> 24) & 0x3F); }
+		for (auto const layout : { nes::app::ntsc_filter::layout::standard, nes::app::ntsc_filter::layout::wide })
+		{
+			auto const filter = std::make_unique<nes::app::ntsc_filter>(layout);
+			auto const output_width = filter->get_output_width();
+			auto frame = nes::u64{ 0 };
+			measure(o, output_width == 602 ? "scaler/ntsc-602" : "scaler/ntsc-640", 1, 0, [&]
+			{
+				filter->filter(
+					nes::app::pixel_view<nes::u16 const>{ raw.data(), width, height, width },
+					nes::app::pixel_view<nes::u32>{ target.data(), output_width, height, output_width }, frame++, 0,
+					height);
+				return static_cast<nes::u64>(target[output_width * height / 2]);
+			});
+		}
+	}
+
+	auto run_capture_kernels(options const& o) -> void
+	{
+		constexpr auto width = nes::display::width;
+		constexpr auto height = nes::display::height;
+
+		struct frame
+		{
+			nes::u16 pixels[nes::frame_codec::pixel_count]{};
+		};
+
+		// The same pixel art as for the scalers, once as a key frame and once scrolled by a pixel (which changes about
+		// a third of the pixels, but is coded as a copy at an offset).
+		auto const zero = std::make_unique<frame>();
+		auto const previous = std::make_unique<frame>();
+		auto const current = std::make_unique<frame>();
+		for (auto y = nes::u32{ 0 }; y < height; ++y)
+		{
+			for (auto x = nes::u32{ 0 }; x < width; ++x)
+			{
+				auto const pixel = [&](nes::u32 const px)
+				{
+					auto index = ((px / 16 + y / 16) % 3) * 0x10;
+					if ((px + y) % 13 == 0) { index = 0x30; }
+					if ((px * 7 + y * 13) % 97 == 0) { index = 0x16; }
+					return static_cast<nes::u16>(index);
+				};
+				previous->pixels[y * width + x] = pixel(x);
+				current->pixels[y * width + x] = pixel(x + 1);
+			}
+		}
+		auto encoded = std::vector<nes::u8>(nes::frame_codec::max_encoded_size);
+
+		measure(o, "capture/encode-key", 1, 0, [&]
+		{
+			return static_cast<nes::u64>(nes::frame_codec::encode(current->pixels, zero->pixels, encoded.data()));
+		});
+		measure(o, "capture/encode-scroll", 1, 0, [&]
+		{
+			return static_cast<nes::u64>(nes::frame_codec::encode(current->pixels, previous->pixels, encoded.data()));
+		});
+
+		auto const size = nes::frame_codec::encode(current->pixels, previous->pixels, encoded.data());
+		auto const decoded = std::make_unique<frame>();
+		measure(o, "capture/decode-scroll", 1, 0, [&]
+		{
+			nes::frame_codec::decode(encoded.data(), size, previous->pixels, decoded->pixels);
+			return static_cast<nes::u64>(decoded->pixels[nes::frame_codec::pixel_count / 2]);
+		});
+	}
+
+	auto run_crypto_kernels(options const& o) -> void
+	{
+		constexpr auto size = nes::u32{ 64 * 1024 };
+		auto data = std::vector<nes::u8>(size);
+		for (auto i = nes::u32{ 0 }; i < size; ++i) { data[i] = static_cast<nes::u8>(i * 31); }
+		auto const key = nes::app::sha256::hash(nes::span<nes::u8 const>{ data.data(), 16 });
+
+		measure(o, "crypto/aes256-decrypt", 1, size, [&]
+		{
+			nes::app::aes256::decrypt(nes::span{ data.data(), size }, key.get_data());
+			return static_cast<nes::u64>(data[0]);
+		});
+
+		measure(o, "crypto/sha256-hash", 1, size, [&]
+		{
+			auto const hash = nes::app::sha256::hash(nes::span<nes::u8 const>{ data.data(), size });
+			return static_cast<nes::u64>(hash.get_data()[0]);
+		});
+	}
+
+	auto parse_options(int const argc, char** argv, options& result) -> bool
+	{
+		for (auto i = 1; i < argc; ++i)
+		{
+			auto const has_value = i + 1 < argc;
+			if (std::strcmp(argv[i], "--rom") == 0 && has_value)
+			{
+				result.rom_path = argv[++i];
+			}
+			else if (std::strcmp(argv[i], "--filter") == 0 && has_value)
+			{
+				result.filter = argv[++i];
+			}
+			else if (std::strcmp(argv[i], "--warmup") == 0 && has_value)
+			{
+				result.warmup = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (std::strcmp(argv[i], "--repetitions") == 0 && has_value)
+			{
+				result.repetitions = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+				if (result.repetitions == 0) { return false; }
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+} // namespace
+
+auto main(int const argc, char** argv) -> int
+{
+	auto o = options{};
+	if (!parse_options(argc, argv, o))
+	{
+		std::cerr << "Usage:\n";
+		std::cerr << "  " << argv[0] << " [--rom <path>] [--filter <text>] [--warmup <count>] [--repetitions <count>]\n\n";
+		std::cerr << "The PPU and mapper kernels use the given ROM (or a synthetic NROM image)." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto rom_data = make_rom(make_program({ 0xEA }));
+	if (o.rom_path)
+	{
+		auto file = std::ifstream{ o.rom_path, std::ios::binary };
+		if (!file)
+		{
+			std::cerr << "Unable to read " << o.rom_path << std::endl;
+			return EXIT_FAILURE;
+		}
+		rom_data.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+	}
+	auto const rom = load_rom(rom_data);
+
+	run_cpu_kernels(o);
+	run_ppu_kernels(o, *rom);
+	run_mapper_kernels(o, *rom);
+	run_renderer_kernels(o);
+	run_scaler_kernels(o);
+	run_capture_kernels(o);
+	run_crypto_kernels(o);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+#include "capture-writer.hh"
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+namespace nes
+{
+	namespace
+	{
+		// The writer is much faster than the emulation, so polling an empty queue does not need to be very responsive.
+		constexpr auto idle_delay = std::chrono::milliseconds{ 1 };
+		constexpr auto full_delay = std::chrono::microseconds{ 100 };
+	} // namespace
+
+	capture_writer::capture_writer()
+		: queue_{ std::make_unique<frame[]>(queue_size) }
+		, previous_{ std::make_unique<frame>() }
+		, encoded_{ std::make_unique<u8[]>(frame_codec::max_encoded_size) }
+	{
+	}
+
+	capture_writer::~capture_writer()
+	{
+		close();
+	}
+
+	auto capture_writer::open(char const* const path) -> status
+	{
+		close();
+
+		file_ = std::ofstream{ path, std::ios::binary | std::ios::trunc };
+		auto const header = frame_codec::file_header{
+			frame_codec::file_magic, frame_codec::file_version, display::width, display::height, 0 };
+		file_.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		if (!file_) { return status::error_system_error; }
+
+		status_ = status::success;
+		frame_count_ = 0;
+		encoded_bytes_ = 0;
+		stalls_ = 0;
+		queue_read_.store(0, std::memory_order_relaxed);
+		queue_write_.store(0, std::memory_order_relaxed);
+		running_.store(true, std::memory_order_release);
+		thread_ = std::thread{ [this] { run(); } };
+		return status::success;
+	}
+
+	auto capture_writer::push(span<u16 const, frame_codec::pixel_count> const pixels) -> void
+	{
+		NES_ASSERT(is_open() && "capture has not been opened");
+
+		auto const write = queue_write_.load(std::memory_order_relaxed);
+		if (write - queue_read_.load(std::memory_order_acquire) == queue_size)
+		{
+			stalls_ += 1;
+			while (write - queue_read_.load(std::memory_order_acquire) == queue_size)
+			{
+				std::this_thread::sleep_for(full_delay);
+			}
+		}
+
+		std::memcpy(queue_[write % queue_size].pixels, pixels.get_data(), sizeof(frame::pixels));
+		queue_write_.store(write + 1, std::memory_order_release);
+	}
+
+	auto capture_writer::close() -> status
+	{
+		if (!thread_.joinable()) { return status_; }
+
+		running_.store(false, std::memory_order_release);
+		thread_.join();
+
+		// The number of frames is only known now.
+		file_.seekp(offsetof(frame_codec::file_header, frame_count));
+		file_.write(reinterpret_cast<char const*>(&frame_count_), sizeof(frame_count_));
+		file_.close();
+		if (!file_) { status_ = status::error_system_error; }
+
+		return status_;
+	}
+
+	auto capture_writer::run() -> void
+	{
+		auto read = queue_read_.load(std::memory_order_relaxed);
+		while (true)
+		{
+			// Frames pushed before closing are still written.
+			auto const stopping = !running_.load(std::memory_order_acquire);
+			auto const write = queue_write_.load(std::memory_order_acquire);
+			if (read == write)
+			{
+				if (stopping) { break; }
+
+				std::this_thread::sleep_for(idle_delay);
+				continue;
+			}
+
+			for (; read != write; ++read)
+			{
+				write_frame(queue_[read % queue_size]);
+				queue_read_.store(read + 1, std::memory_order_release);
+			}
+		}
+	}
+
+	auto capture_writer::write_frame(frame const& f) -> void
+	{
+		// After an error, frames are dropped to keep the emulation going.
+		if (status_ != status::success) { return; }
+
+		auto header = frame_codec::frame_header{ 0, 0 };
+		if (frame_count_ % key_frame_interval == 0)
+		{
+			header.flags |= frame_codec::key_frame_flag;
+			std::memset(previous_->pixels, 0, sizeof(previous_->pixels));
+		}
+		header.size = frame_codec::encode(f.pixels, previous_->pixels, encoded_.get());
+
+		file_.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		file_.write(reinterpret_cast<char const*>(encoded_.get()), header.size);
+		if (!file_)
+		{
+			status_ = status::error_system_error;
+			return;
+		}
+
+		std::memcpy(previous_->pixels, f.pixels, sizeof(previous_->pixels));
+		frame_count_ += 1;
+		encoded_bytes_ += sizeof(header) + header.size;
+	}
+} // namespace nes
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "nes/common/frame-codec.hh"
+#include "nes/common/containers/span.hh"
+#include "nes/common/status.hh"
+#include "nes/common/types.hh"
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+namespace nes
+{
+	/// Writes frames of an indexed display into a capture file (see frame_codec) without holding up the emulation.
+	///
+	/// Frames are copied into a lock-free queue and encoded and written by a separate thread. The emulation only waits
+	/// if the writer falls behind by more than the whole queue, so no frames are lost.
+	class capture_writer
+	{
+	public:
+		/// About a second of frames (and 7.5 MiB).
+		static constexpr auto queue_size = u32{ 64 };
+		/// Frames between key frames (a minute of gameplay).
+		static constexpr auto key_frame_interval = u32{ 3600 };
+
+	private:
+		struct frame
+		{
+			u16 pixels[frame_codec::pixel_count];
+		};
+
+		std::unique_ptr<frame[]> queue_;
+		std::atomic<u32> queue_read_{ 0 };
+		std::atomic<u32> queue_write_{ 0 };
+		std::atomic<bool> running_{ false };
+		std::thread thread_;
+		std::ofstream file_;
+		// Only used by the writer thread while it is running.
+		std::unique_ptr<frame> previous_;
+		std::unique_ptr<u8[]> encoded_;
+		status status_{ status::success };
+		u32 frame_count_{ 0 };
+		u64 encoded_bytes_{ 0 };
+		u64 stalls_{ 0 }; // Only used by the emulation thread.
+
+	public:
+		explicit capture_writer();
+		~capture_writer();
+
+		capture_writer(capture_writer const&) = delete;
+		capture_writer(capture_writer&&) = delete;
+		auto operator=(capture_writer const&) -> capture_writer& = delete;
+		auto operator=(capture_writer&&) -> capture_writer& = delete;
+
+		auto is_open() const -> bool { return running_.load(std::memory_order_relaxed); }
+
+		/// Create the file and start the writer thread.
+		auto open(char const* path) -> status;
+		/// Queue the next frame.
+		auto push(span<u16 const, frame_codec::pixel_count>) -> void;
+		/// Write the remaining frames and close the file. Returns whether all frames could be written.
+		auto close() -> status;
+
+		// Statistics, which are only valid after closing the capture.
+		auto get_frame_count() const -> u32 { return frame_count_; }
+		/// Size of the frames in the file, including their headers.
+		auto get_encoded_bytes() const -> u64 { return encoded_bytes_; }
+		/// Number of frames for which the emulation had to wait for the writer.
+		auto get_stalls() const -> u64 { return stalls_; }
+
+	private:
+		auto run() -> void;
+		auto write_frame(frame const&) -> void;
+	};
+} // namespace nes
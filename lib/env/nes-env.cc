@@ -0,0 +1,318 @@
+#include "nes-env.h"
+#include "nes/sys/nes.hh"
+#include "nes/sys/rom-image.hh"
+#include "nes/common/display.hh"
+#include "worker-pool.hh"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr auto block_alignment = std::size_t{ 64 };
+
+	auto align(std::size_t const value) -> std::size_t
+	{
+		return (value + block_alignment - 1) / block_alignment * block_alignment;
+	}
+
+	/// Writes the pixels directly into the caller's buffer.
+	class frame_display final : public nes::display
+	{
+		nes::u8* target_{ nullptr };
+
+	public:
+		explicit frame_display(bool const rgb)
+			: nes::display{ !rgb }
+		{
+		}
+
+		auto set_target(nes::u8* const value) -> void { target_ = value; }
+
+		auto switch_buffers() -> void override {}
+
+		auto set(nes::u32 const x, nes::u32 const y, nes::rgb const value) -> void override
+		{
+			if (!target_) { return; }
+
+			auto* pixel = target_ + (y * width + x) * 3;
+			pixel[0] = value.r;
+			pixel[1] = value.g;
+			pixel[2] = value.b;
+		}
+
+		auto set_index(nes::u32 const x, nes::u32 const y, nes::u16 const pixel) -> void override
+		{
+			if (!target_) { return; }
+
+			target_[y * width + x] = static_cast<nes::u8>(pixel & 0x3F);
+		}
+	};
+
+	struct console
+	{
+		frame_display display;
+		std::unique_ptr<nes::sys::nes> system;
+		bool done{ false };
+		// State before the last frame which was emulated without rendering it (see step_console).
+		std::vector<nes::u8> frame_start;
+
+		explicit console(bool const rgb, nes::sys::rom_image const& rom)
+			: display{ rgb }
+			, system{ std::make_unique<nes::sys::nes>(display, rom) }
+			, frame_start(nes::sys::nes::state_size)
+		{
+			system->ref_apu().set_output_muted(true);
+		}
+	};
+} // namespace
+
+struct nes_env
+{
+	std::vector<nes::u8> rom_data;
+	std::unique_ptr<nes::sys::rom_image> rom;
+	nes_env_config config{};
+	nes_env_layout layout{};
+	std::vector<std::unique_ptr<console>> consoles;
+	std::unique_ptr<nes::worker_pool> workers;
+	std::vector<nes::u8> start_state;
+	std::vector<nes::u8> start_observation;
+	nes::u8* buffer{ nullptr };
+
+	auto get_observation(nes::u32 const index) const -> nes::u8*
+	{
+		return buffer + layout.observation_offset + index * layout.observation_stride;
+	}
+
+	auto get_ram(nes::u32 const index) const -> nes::u8*
+	{
+		return buffer + layout.ram_offset + index * layout.ram_stride;
+	}
+
+	auto get_reward(nes::u32 const index) const -> float*
+	{
+		return reinterpret_cast<float*>(buffer + layout.reward_offset) + index;
+	}
+
+	auto get_done(nes::u32 const index) const -> nes::u8*
+	{
+		return buffer + layout.done_offset + index;
+	}
+};
+
+namespace
+{
+	auto make_layout(nes_env_config const& config) -> nes_env_layout
+	{
+		auto const pixel_size = config.observation == NES_ENV_OBSERVATION_RGB ? std::size_t{ 3 } : std::size_t{ 1 };
+
+		auto res = nes_env_layout{};
+		res.observation_stride = align(nes::display::width * nes::display::height * pixel_size);
+		res.ram_stride = config.copy_ram ? align(NES_ENV_RAM_SIZE) : 0;
+		res.observation_offset = 0;
+		res.ram_offset = res.observation_offset + config.console_count * res.observation_stride;
+		res.reward_offset = res.ram_offset + config.console_count * res.ram_stride;
+		res.done_offset = align(res.reward_offset + config.console_count * sizeof(float));
+		res.size = align(res.done_offset + config.console_count);
+		return res;
+	}
+
+	auto load_start_state(nes_env& env, nes::u32 const index) -> bool
+	{
+		auto& c = *env.consoles[index];
+		auto const state = nes::span<nes::u8 const>{ env.start_state.data(), nes::sys::nes::state_size };
+		if (c.system->load_state(state) != nes::status::success) { return false; }
+
+		// Consoles which stopped with an error run again after being reset.
+		c.done = false;
+		return c.system->get_status() == nes::status::success;
+	}
+
+	/// Copy everything except for the frame, which is rendered into the buffer directly.
+	auto publish(nes_env& env, nes::u32 const index, float const reward) -> void
+	{
+		auto const& c = *env.consoles[index];
+		if (env.config.copy_ram)
+		{
+			auto const ram = c.system->get_cpu_ram();
+			std::memcpy(env.get_ram(index), ram.get_data(), ram.get_length());
+		}
+		*env.get_reward(index) = reward;
+		*env.get_done(index) = c.done ? 1 : 0;
+	}
+
+	auto set_actions(console& c, std::uint8_t const* const actions, nes::u32 const index) -> void
+	{
+		c.system->ref_controller_1().set_pressed(nes::sys::button_mask::from_raw_value(actions[index * 2 + 0]));
+		c.system->ref_controller_2().set_pressed(nes::sys::button_mask::from_raw_value(actions[index * 2 + 1]));
+	}
+
+	/// Emulate the given number of frames (unless the episode ends earlier), only rendering the last one. If the reward
+	/// function ends the episode early, the last frame is emulated again to render it.
+	auto step_console(nes_env& env, nes::u32 const index, std::uint8_t const* const actions, nes::u32 const frames)
+		-> void
+	{
+		auto& c = *env.consoles[index];
+		auto const frame_start = nes::span<nes::u8>{ c.frame_start.data(), nes::sys::nes::state_size };
+		auto reward = 0.0f;
+		set_actions(c, actions, index);
+		for (auto i = nes::u32{ 0 }; i < frames && !c.done; ++i)
+		{
+			auto const rendered = i + 1 == frames;
+			if (env.config.reward_function && !rendered) { c.system->save_state(frame_start); }
+			c.system->set_video_enabled(rendered);
+			c.system->run_frame();
+			if (c.system->get_status() != nes::status::success)
+			{
+				c.done = true;
+				break;
+			}
+
+			if (env.config.reward_function)
+			{
+				auto done = std::uint8_t{ 0 };
+				reward += env.config.reward_function(
+					env.config.reward_user_data, index, c.system->get_cpu_ram().get_data(), &done);
+				c.done = done != 0;
+				if (c.done && !rendered)
+				{
+					// Emulation is deterministic, so this ends in the same state.
+					c.system->load_state(nes::span<nes::u8 const>{ c.frame_start.data(), nes::sys::nes::state_size });
+					c.system->set_video_enabled(true);
+					c.system->run_frame();
+				}
+			}
+		}
+
+		publish(env, index, reward);
+	}
+} // namespace
+
+extern "C" auto nes_env_create(nes_env_config const* config, char const** error) -> nes_env*
+{
+	auto const fail = [error](char const* message) -> nes_env*
+	{
+		if (error) { *error = message; }
+		return nullptr;
+	};
+
+	if (!config || !config->rom || config->console_count == 0) { return fail("Invalid configuration"); }
+	if (config->observation != NES_ENV_OBSERVATION_INDEXED && config->observation != NES_ENV_OBSERVATION_RGB)
+	{
+		return fail("Invalid observation type");
+	}
+
+	try
+	{
+		auto env = std::make_unique<nes_env>();
+		env->config = *config;
+		env->layout = make_layout(*config);
+		env->rom_data.assign(config->rom, config->rom + config->rom_size);
+		env->rom = std::make_unique<nes::sys::rom_image>(
+			nes::span<nes::u8 const>{ env->rom_data.data(), static_cast<nes::u32>(env->rom_data.size()) });
+		if (env->rom->get_status() != nes::status::success) { return fail(nes::to_string(env->rom->get_status())); }
+
+		auto const rgb = config->observation == NES_ENV_OBSERVATION_RGB;
+		for (auto i = nes::u32{ 0 }; i < config->console_count; ++i)
+		{
+			env->consoles.push_back(std::make_unique<console>(rgb, *env->rom));
+		}
+
+		// Render the first frame of the first console to get a complete start state.
+		env->start_observation.resize(env->layout.observation_stride);
+		env->start_state.resize(nes::sys::nes::state_size);
+		auto& first = *env->consoles.front();
+		first.display.set_target(env->start_observation.data());
+		first.system->run_frame();
+		first.display.set_target(nullptr);
+		if (first.system->get_status() != nes::status::success) { return fail(nes::to_string(first.system->get_status())); }
+		first.system->save_state(nes::span<nes::u8>{ env->start_state.data(), nes::sys::nes::state_size });
+		for (auto i = nes::u32{ 0 }; i < config->console_count; ++i)
+		{
+			if (!load_start_state(*env, i)) { return fail("Unable to restore the start state"); }
+		}
+
+		auto const thread_count = config->thread_count != 0 ? config->thread_count : std::thread::hardware_concurrency();
+		env->workers = std::make_unique<nes::worker_pool>(std::clamp(thread_count, 1u, config->console_count));
+		return env.release();
+	}
+	catch (std::bad_alloc const&)
+	{
+		return fail("Out of memory");
+	}
+}
+
+extern "C" auto nes_env_destroy(nes_env* const env) -> void
+{
+	delete env;
+}
+
+extern "C" auto nes_env_get_layout(nes_env const* const env) -> nes_env_layout
+{
+	return env->layout;
+}
+
+extern "C" auto nes_env_bind(nes_env* const env, void* const buffer, std::size_t const size) -> int
+{
+	if (!buffer || size < env->layout.size || reinterpret_cast<std::uintptr_t>(buffer) % alignof(float) != 0)
+	{
+		return NES_ENV_ERROR;
+	}
+
+	env->buffer = static_cast<nes::u8*>(buffer);
+	for (auto i = nes::u32{ 0 }; i < env->config.console_count; ++i)
+	{
+		env->consoles[i]->display.set_target(env->get_observation(i));
+		publish(*env, i, 0.0f);
+	}
+
+	return NES_ENV_OK;
+}
+
+extern "C" auto nes_env_step(nes_env* const env, std::uint8_t const* const actions, std::uint32_t const frames) -> int
+{
+	if (!env->buffer || !actions || frames == 0) { return NES_ENV_ERROR; }
+
+	env->workers->run(env->config.console_count, [env, actions, frames](nes::u32 const index)
+	{
+		step_console(*env, index, actions, frames);
+	});
+
+	auto const failed = std::any_of(env->consoles.begin(), env->consoles.end(), [](auto const& c)
+	{
+		return c->system->get_status() != nes::status::success;
+	});
+	return failed ? NES_ENV_ERROR : NES_ENV_OK;
+}
+
+extern "C" auto nes_env_reset(nes_env* const env, std::uint32_t const index) -> int
+{
+	if (!env->buffer || index >= env->config.console_count || !load_start_state(*env, index)) { return NES_ENV_ERROR; }
+
+	std::memcpy(env->get_observation(index), env->start_observation.data(), env->start_observation.size());
+	publish(*env, index, 0.0f);
+	return NES_ENV_OK;
+}
+
+extern "C" auto nes_env_set_start_state(nes_env* const env, std::uint32_t const index) -> int
+{
+	if (!env->buffer || index >= env->config.console_count) { return NES_ENV_ERROR; }
+
+	auto const& c = *env->consoles[index];
+	if (c.system->get_status() != nes::status::success) { return NES_ENV_ERROR; }
+
+	c.system->save_state(nes::span<nes::u8>{ env->start_state.data(), nes::sys::nes::state_size });
+	std::memcpy(env->start_observation.data(), env->get_observation(index), env->start_observation.size());
+	return NES_ENV_OK;
+}
+
+extern "C" auto nes_env_get_error(nes_env const* const env, std::uint32_t const index) -> char const*
+{
+	if (index >= env->config.console_count) { return nullptr; }
+
+	auto const status = env->consoles[index]->system->get_status();
+	return status == nes::status::success ? nullptr : nes::to_string(status);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+/*
+ * C interface for running many consoles with the same ROM side by side, for example as environments for reinforcement
+ * learning.
+ *
+ * All consoles are stepped at once (in parallel) and write their observations directly into one buffer allocated by
+ * the caller, which contains a block for each kind of data (frames, CPU RAM, rewards and done flags) with one entry
+ * per console. See nes_env_layout for the exact offsets. The CPU RAM is only copied if requested (see copy_ram).
+ *
+ * Each console is emulated on its own, consoles are not run in lockstep (with their registers and RAM in
+ * structure-of-arrays layout and SIMD instructions stepping all of them at once). The CPU hands control to the PPU, APU
+ * and cartridge after every instruction, and memory accesses go through mapper and PPU register handlers with side
+ * effects, so consoles at the same instruction diverge in timing and control flow after a few instructions and nearly
+ * all work would fall back to scalar code. Throughput scales with thread_count instead.
+ *
+ * To use this from other languages, build a shared library by configuring with -DBUILD_SHARED_LIBS=ON and
+ * -DCMAKE_POSITION_INDEPENDENT_CODE=ON.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NES_ENV_WIDTH 256
+#define NES_ENV_HEIGHT 240
+#define NES_ENV_RAM_SIZE 2048
+
+#define NES_ENV_OK 0
+#define NES_ENV_ERROR (-1)
+
+typedef struct nes_env nes_env;
+
+typedef enum nes_env_observation
+{
+	/* One byte per pixel, containing the index (0-63) in the console's palette. */
+	NES_ENV_OBSERVATION_INDEXED = 0,
+	/* Three bytes per pixel (red, green, blue). */
+	NES_ENV_OBSERVATION_RGB = 1,
+} nes_env_observation;
+
+/*
+ * Compute the reward of a console after a frame, using its CPU RAM. Setting *done to a non-zero value ends the episode
+ * (the console is not stepped until it is reset). Called from multiple threads at once, but never concurrently for
+ * the same console.
+ */
+typedef float (*nes_env_reward_function)(void* user_data, uint32_t index, uint8_t const* ram, uint8_t* done);
+
+typedef struct nes_env_config
+{
+	/* The iNES image, which is only read during nes_env_create. */
+	uint8_t const* rom;
+	size_t rom_size;
+	uint32_t console_count;
+	/* Number of threads used for stepping (including the calling thread), or 0 for one per processor. */
+	uint32_t thread_count;
+	nes_env_observation observation;
+	/* Optional, the rewards are 0 otherwise. */
+	nes_env_reward_function reward_function;
+	void* reward_user_data;
+	/*
+	 * Copy the CPU RAM of each console into the buffer after each step. The reward function always receives the RAM,
+	 * so this is only needed for inspecting it directly. Otherwise, the RAM block is empty (ram_stride is 0).
+	 */
+	int copy_ram;
+} nes_env_config;
+
+/* Offsets (in bytes) of the blocks in the buffer, each containing one entry per console. */
+typedef struct nes_env_layout
+{
+	size_t size;
+	size_t observation_offset;
+	size_t observation_stride;
+	size_t ram_offset;
+	/* 0 unless the RAM is copied. */
+	size_t ram_stride;
+	/* One float per console. */
+	size_t reward_offset;
+	/* One uint8_t per console. */
+	size_t done_offset;
+} nes_env_layout;
+
+/*
+ * Create the consoles. The start state used by nes_env_reset is the state after the first frame. Returns NULL on
+ * failure, in which case *error (if given) points to a static description.
+ */
+nes_env* nes_env_create(nes_env_config const* config, char const** error);
+void nes_env_destroy(nes_env* env);
+
+nes_env_layout nes_env_get_layout(nes_env const* env);
+/* Use the buffer (at least layout.size bytes, aligned to 4 bytes) for all following calls until it is replaced. */
+int nes_env_bind(nes_env* env, void* buffer, size_t size);
+
+/*
+ * Step all consoles which are not done by the given number of frames, using one button mask (bits: A, B, select,
+ * start, up, down, left, right) per controller and console, i.e. 2 * console_count bytes. Only the last frame is
+ * rendered (or the frame after which the reward function ends the episode, while consoles stopping with an error keep
+ * their previous frame), rewards are summed up over all frames.
+ */
+int nes_env_step(nes_env* env, uint8_t const* actions, uint32_t frames);
+/* Restore the start state of a console, including its observation. */
+int nes_env_reset(nes_env* env, uint32_t index);
+/* Use the current state of a console as the start state for all consoles. */
+int nes_env_set_start_state(nes_env* env, uint32_t index);
+/* Description of the error a console stopped with, or NULL if it is running. */
+char const* nes_env_get_error(nes_env const* env, uint32_t index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,9 +6,19 @@
 #include "nes/app/action.hh"
 #include "nes/app/crypto/aes256.hh"
 #include "nes/app/crypto/sha256.hh"
+#include "nes/common/audio-sink.hh"
+#include "nes/common/debug.hh"
+#include "nes/common/utils.hh"
+#include "nes/common/xxh3.hh"
 
 namespace nes::app
 {
+	namespace
+	{
+		constexpr auto frame_duration_us = u32{ 16639 };
+		constexpr auto max_frames_behind = u32{ 3 };
+	} // namespace
+
 	auto application::display_proxy::get_front() const -> span<rgb, display::width * display::height>
 	{
 		return buffer_front_;
@@ -20,6 +30,13 @@ namespace nes::app
 		base.set(x, y, value);
 	}
 
+	auto application::display_proxy::set_index(u32 const x, u32 const y, u16 const pixel) -> void
+	{
+		// The buffers are only used for freezing the screen, which ignores the emphasis bits.
+		buffer_back_[y * display::width + x] = sys::ppu::get_palette_rgb(static_cast<u8>(pixel & 0x3F));
+		base.set_index(x, y, pixel);
+	}
+
 	auto application::display_proxy::switch_buffers() -> void
 	{
 		auto r = renderer{ base };
@@ -43,6 +60,15 @@ namespace nes::app
 			r.render_text_format(32, 29, color::fixed_white, attrs, "{}", fps.get_fps());
 		}
 
+		if (!visible_screen && !visible_popup)
+		{
+			auto const picture = reinterpret_cast<u8 const*>(buffer_back_.get_data());
+			reaction.present(xxh3::hash(span<u8 const>{ picture, sizeof(buffers_[0]) }));
+		}
+
+		fps.frame(elapsed_since_frame_us);
+		elapsed_since_frame_us = 0;
+
 		swap(buffer_front_, buffer_back_);
 		base.switch_buffers();
 	}
@@ -51,6 +77,7 @@ namespace nes::app
 		: input_manager_{ keyboard }
 		, file_browser_{ file_browser }
 		, display_{ preferences_, display }
+		, audio_buffer_{ sys::cycle_count::from_microseconds(1000 * 1000).to_cpu(), 48000 }
 		, screen_title_{ keyboard }
 		, screen_browser_{ keyboard, file_browser }
 		, screen_settings_{ input_manager_, preferences_ }
@@ -65,7 +92,7 @@ namespace nes::app
 
 	auto application::frame(u32 const elapsed_time_us) -> void
 	{
-		display_.fps.frame(elapsed_time_us);
+		display_.elapsed_since_frame_us += elapsed_time_us;
 
 		if (display_.visible_popup)
 		{
@@ -100,24 +127,102 @@ namespace nes::app
 				}
 			}
 
-			// Forward current input state to the NES.
-			console_->ref_controller_1().set_pressed(input_manager_.get_input_1().read_buttons());
-			console_->ref_controller_2().set_pressed(input_manager_.get_input_2().read_buttons());
+			auto const controller_1 = input_manager_.get_input_1().read_buttons();
+			auto const controller_2 = input_manager_.get_input_2().read_buttons();
+			if (!movie_reader_.is_active())
+			{
+				display_.reaction.input(controller_1.get_raw_value() | (controller_2.get_raw_value() << 8));
+			}
+			display_.reaction.elapse(elapsed_time_us);
+
+			// While rewinding, the console goes back to the state before the previous frame and replays that frame from
+			// there (to produce a picture), otherwise the state before the frame is recorded. Movies would get out of
+			// sync, so rewinding is not possible while recording or playing one. Frames may be emulated in slices
+			// (e.g. while beam racing), so this only happens once the console has started a new frame.
+			auto const movie_active = movie_writer_.is_active() || movie_reader_.is_active();
+			if (console_->get_frame_count() != rewind_frame_)
+			{
+				auto const rewinding = !movie_active && input_manager_.get_keyboard().read_key(key::backspace) &&
+					rewind_.pop(*console_);
+				if (!rewinding && !rewind_.get_storage().is_empty()) { rewind_.push(*console_); }
+				rewind_frame_ = console_->get_frame_count();
+			}
 
 			// The scene is rendered by the console after the PPU requests a new frame (thus calling
 			// display_proxy::switch_buffers).
-			console_->step(sys::cycle_count::from_microseconds(elapsed_time_us));
+			if (preferences_.get_run_ahead_frames() > 0 || movie_active)
+			{
+				// Both need the same input for the whole frame.
+				console_->ref_controller_1().set_input(nullptr);
+				console_->ref_controller_2().set_input(nullptr);
+				run_frames(elapsed_time_us, controller_1, controller_2);
+			}
+			else
+			{
+				// Forward current input state to the NES, which is sampled again whenever the game latches the
+				// controllers.
+				console_->ref_controller_1().set_pressed(controller_1);
+				console_->ref_controller_2().set_pressed(controller_2);
+				console_->ref_controller_1().set_input(&controller_latch_1_);
+				console_->ref_controller_2().set_input(&controller_latch_2_);
+				console_->step(sys::cycle_count::from_microseconds(elapsed_time_us));
+				flush_audio();
+			}
 
 			if (console_->get_status() != status::success)
 			{
 				screen_freeze_.freeze(display_.get_front());
 				display_.visible_screen = &screen_freeze_;
 				show_error("Runtime error", console_->get_status(), action::go_to_browser());
-				console_.clear();
+				close_game();
 			}
 		}
 	}
 
+	auto application::set_audio_sink(audio_sink* const sink) -> void
+	{
+		audio_sink_ = sink;
+		if (audio_sink_)
+		{
+			audio_buffer_.set_rates(audio_buffer_.get_clock_rate(), audio_sink_->get_sample_rate());
+		}
+
+		if (console_) { console_->ref_apu().set_output(audio_sink_ ? &audio_buffer_ : nullptr); }
+	}
+
+	auto application::set_rewind_storage(span<u8> const storage) -> void
+	{
+		rewind_.set_storage(storage);
+	}
+
+	auto application::start_recording(span<u8> const buffer) -> status
+	{
+		NES_ASSERT(console_ && "no game is running");
+
+		movie_reader_.end();
+		return movie_writer_.begin(buffer, *console_);
+	}
+
+	auto application::stop_recording() -> span<u8 const>
+	{
+		movie_writer_.end();
+		return movie_writer_.get_data();
+	}
+
+	auto application::start_playback(span<u8 const> const movie) -> status
+	{
+		NES_ASSERT(console_ && "no game is running");
+
+		movie_writer_.end();
+		rewind_.clear();
+		return movie_reader_.begin(movie, *console_);
+	}
+
+	auto application::stop_playback() -> void
+	{
+		movie_reader_.end();
+	}
+
 	auto application::handle_action(action const& a) -> void
 	{
 		switch (a.get_type())
@@ -166,7 +271,9 @@ namespace nes::app
 			}
 			case action::type::launch_game:
 			{
-				u8 buffer[sys::cartridge::max_file_size];
+				close_game();
+
+				u8 buffer[sys::rom_image::max_file_size];
 				auto length = u32{ 0 };
 				if (auto const s = file_browser_.load(a.get_file_name(), buffer, &length); s != status::success)
 				{
@@ -181,14 +288,17 @@ namespace nes::app
 					aes256::decrypt(span{ buffer, length }, key_hash.get_data());
 				}
 
-				console_.emplace(display_, span<u8 const>{ buffer, length });
-				if (console_->get_status() != status::success)
+				rom_.emplace(span<u8 const>{ buffer, length });
+				if (rom_->get_status() != status::success)
 				{
-					show_error("Unable to load cartridge", console_->get_status());
-					console_.clear();
+					show_error("Unable to load cartridge", rom_->get_status());
+					rom_.clear();
 					break;
 				}
 
+				console_.emplace(display_, *rom_);
+				if (audio_sink_) { console_->ref_apu().set_output(&audio_buffer_); }
+
 				display_.visible_screen = nullptr;
 				display_.visible_popup = nullptr;
 				break;
@@ -223,8 +333,84 @@ namespace nes::app
 
 	auto application::go_to_screen(screen* screen) -> void
 	{
-		console_.clear();
+		close_game();
 		display_.visible_screen = screen;
 		display_.visible_popup = nullptr;
 	}
+
+	auto application::close_game() -> void
+	{
+		// The console references the ROM image, so it needs to be destroyed first.
+		movie_writer_.end();
+		movie_reader_.end();
+		rewind_.clear();
+		display_.reaction.reset();
+		console_.clear();
+		rom_.clear();
+	}
+
+	auto application::flush_audio() -> void
+	{
+		if (!audio_sink_ || !console_) { return; }
+
+		console_->ref_apu().end_frame();
+		audio_buffer_.set_rate_adjustment(audio_sink_->get_rate_adjustment());
+
+		i16 samples[band_limited_buffer::max_samples];
+		auto const count = audio_buffer_.read_samples(samples);
+		audio_sink_->write(span<i16 const>{ samples, count });
+	}
+
+	auto application::run_frames(
+		u32 const elapsed_time_us, sys::button_mask const controller_1, sys::button_mask const controller_2) -> void
+	{
+		// Whole frames are emulated, so the elapsed time is accumulated (and capped to avoid catching up forever).
+		frame_time_us_ = min(frame_time_us_ + elapsed_time_us, max_frames_behind * frame_duration_us);
+		auto const frames_ahead = preferences_.get_run_ahead_frames();
+
+		while (frame_time_us_ >= frame_duration_us && console_->get_status() == status::success)
+		{
+			frame_time_us_ -= frame_duration_us;
+
+			// Movies store the input applied to each frame.
+			auto input_1 = controller_1;
+			auto input_2 = controller_2;
+			if (movie_reader_.is_active() && !movie_reader_.next(input_1, input_2)) { movie_reader_.end(); }
+			if (movie_writer_.is_active() && movie_writer_.record(input_1, input_2) != status::success)
+			{
+				movie_writer_.end();
+			}
+			console_->ref_controller_1().set_pressed(input_1);
+			console_->ref_controller_2().set_pressed(input_2);
+
+			if (frames_ahead == 0)
+			{
+				console_->run_frame();
+				flush_audio();
+				continue;
+			}
+
+			// Emulate the actual frame without presenting it.
+			console_->set_video_enabled(false);
+			console_->run_frame();
+			flush_audio();
+			console_->save_state(span{ run_ahead_state_ });
+
+			// Emulate the next frames assuming the input stays the same and present the last one, which hides the
+			// game's reaction time. Afterwards, go back to the actual frame.
+			console_->ref_apu().set_output_muted(true);
+			for (auto i = u32{ 0 }; i < frames_ahead; ++i)
+			{
+				console_->set_video_enabled(i + 1 == frames_ahead);
+				console_->run_frame();
+			}
+			console_->load_state(span<u8 const>{ run_ahead_state_ });
+			console_->ref_apu().set_output_muted(false);
+
+			run_ahead_statistics_.presented_frames += 1;
+			run_ahead_statistics_.emulated_frames += 1 + frames_ahead;
+		}
+
+		console_->set_video_enabled(true);
+	}
 } // namespace nes::app
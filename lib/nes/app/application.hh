@@ -11,12 +11,21 @@
 #include "nes/app/ui/screen-prompt-key.hh"
 #include "nes/app/ui/screen-file-viewer.hh"
 #include "nes/app/preferences.hh"
+#include "nes/app/rewind-buffer.hh"
 #include "nes/sys/nes.hh"
+#include "nes/sys/movie.hh"
 #include "nes/common/containers/box.hh"
+#include "nes/common/band-limited-buffer.hh"
 #include "nes/common/display.hh"
 #include "nes/common/fps-counter.hh"
+#include "nes/common/reaction-timer.hh"
 #include "nes/common/types.hh"
 
+namespace nes
+{
+	class audio_sink;
+} // namespace nes
+
 namespace nes::app
 {
 	class screen;
@@ -29,6 +38,15 @@ namespace nes::app
 	/// It delegates some platform-specific tasks to interfaces.
 	class application
 	{
+	public:
+		/// Counters for measuring the cost of run-ahead.
+		struct run_ahead_statistics
+		{
+			u64 presented_frames{ 0 }; // Frames shown to the user.
+			u64 emulated_frames{ 0 }; // Frames emulated, including speculative ones.
+		};
+
+	private:
 		/// Acts like a regular display, but renders a screen on top of the back buffer when requested to switch
 		/// buffers.
 		class display_proxy final : public display
@@ -40,26 +58,64 @@ namespace nes::app
 
 		public:
 			fps_counter fps;
+			reaction_timer reaction; // Only sees the pictures of the game (not of screens and popups).
+			u32 elapsed_since_frame_us{ 0 }; // Frames are counted when they are presented, not per call to frame.
 			display& base;
 			screen* visible_popup{ nullptr };
 			screen* visible_screen{ nullptr };
 
+			/// Passes palette indices on if the base display is indexed.
 			explicit display_proxy(preferences& preferences, display& base)
-				: preferences_{ preferences }
+				: display{ base.is_indexed() }
+				, preferences_{ preferences }
 				, base{ base }
 			{
 			}
 
 			auto set(u32 const x, u32 const y, rgb const value) -> void override;
+			auto set_index(u32 const x, u32 const y, u16 const pixel) -> void override;
+			auto end_scanline(u32 const y) -> void override { base.end_scanline(y); }
 			auto get_front() const -> span<rgb, display::width * display::height>;
 
 			auto switch_buffers() -> void override;
 		};
 
+		/// Samples a controller's input device when the game latches the buttons.
+		class controller_latch final : public sys::controller_input
+		{
+			input_manager& input_manager_;
+			u32 index_;
+
+		public:
+			explicit controller_latch(input_manager& input_manager, u32 const index)
+				: input_manager_{ input_manager }
+				, index_{ index }
+			{
+			}
+
+			auto latch() -> sys::button_mask override
+			{
+				auto& device = index_ == 0 ? input_manager_.get_input_1() : input_manager_.get_input_2();
+				return device.read_buttons_now();
+			}
+		};
+
 		input_manager input_manager_;
+		controller_latch controller_latch_1_{ input_manager_, 0 };
+		controller_latch controller_latch_2_{ input_manager_, 1 };
 		preferences preferences_;
 		file_browser& file_browser_;
 		display_proxy display_;
+		audio_sink* audio_sink_{ nullptr };
+		band_limited_buffer audio_buffer_;
+		rewind_buffer rewind_;
+		u64 rewind_frame_{ 0 }; // Console frame at which a state was last recorded or restored.
+		sys::movie_writer movie_writer_;
+		sys::movie_reader movie_reader_;
+		u32 frame_time_us_{ 0 };
+		run_ahead_statistics run_ahead_statistics_{};
+		u8 run_ahead_state_[sys::nes::state_size]{};
+		box<sys::rom_image> rom_{};
 		box<sys::nes> console_{};
 		screen_title screen_title_;
 		screen_browser screen_browser_;
@@ -84,10 +140,34 @@ namespace nes::app
 
 		auto add_controller(input_device_controller& c) -> void { input_manager_.add_controller(c); }
 		auto remove_controller(input_device_controller& c) -> void { input_manager_.remove_controller(c); }
+		/// Set the audio output, which must outlive the application (nullptr to disable audio).
+		auto set_audio_sink(audio_sink*) -> void;
+		/// Set the memory used for rewinding (holding backspace while playing), which must outlive the application.
+		/// Rewinding is disabled while the storage is empty.
+		auto set_rewind_storage(span<u8>) -> void;
+		auto get_run_ahead_frames() const -> u32 { return preferences_.get_run_ahead_frames(); }
+		auto get_run_ahead_statistics() const -> run_ahead_statistics const& { return run_ahead_statistics_; }
+		/// Measures the latency that run-ahead hides, with and without it.
+		auto get_reaction_timer() const -> reaction_timer const& { return display_.reaction; }
+
+		auto is_game_running() const -> bool { return console_.has_value(); }
+		auto is_recording() const -> bool { return movie_writer_.is_active(); }
+		auto is_playing() const -> bool { return movie_reader_.is_active(); }
+		/// Start recording the input of the running game into a movie, which stops when the buffer is full.
+		auto start_recording(span<u8> buffer) -> status;
+		/// Stop recording and get the recorded movie (which is stored in the buffer passed to start_recording).
+		auto stop_recording() -> span<u8 const>;
+		/// Replace the state and input of the running game with the movie (which must outlive the playback). The
+		/// input is taken over by the user again once the movie has ended.
+		auto start_playback(span<u8 const> movie) -> status;
+		auto stop_playback() -> void;
 
 	private:
 		auto handle_action(action const&) -> void;
 		auto show_error(string_view message, status error, action const& action = action::close_popup()) -> void;
 		auto go_to_screen(screen*) -> void;
+		auto close_game() -> void;
+		auto flush_audio() -> void;
+		auto run_frames(u32 elapsed_time_us, sys::button_mask controller_1, sys::button_mask controller_2) -> void;
 	};
 } // namespace nes::app
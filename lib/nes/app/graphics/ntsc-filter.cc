@@ -0,0 +1,206 @@
+#include "nes/app/graphics/ntsc-filter.hh"
+#include "nes/common/debug.hh"
+#include "nes/common/utils.hh"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace nes::app
+{
+	namespace
+	{
+		// See: https://www.nesdev.org/wiki/NTSC_video
+		//
+		// The PPU outputs 8 samples per pixel at 12 times the frequency of the color subcarrier, i.e. one period of
+		// the subcarrier takes 12 samples. Each sample is either the high or the low level of the color, depending on
+		// whether it is within the half of the period belonging to the color's hue. The TV decodes the luma (Y) as the
+		// average over one period and the chroma (I and Q) by multiplying with the subcarrier.
+
+		constexpr auto samples_per_pixel = u32{ 8 };
+		constexpr auto samples_per_period = u32{ 12 };
+
+		constexpr float signal_levels[2][4]
+		{
+			{ 0.228f, 0.312f, 0.552f, 0.880f }, // Low
+			{ 0.616f, 0.840f, 1.100f, 1.100f }, // High
+		};
+		constexpr auto black_level = 0.312f;
+		constexpr auto white_level = 1.100f;
+		constexpr auto emphasis_attenuation = 0.746f;
+
+		// cos/sin of (phase + 4) * 30 degrees, i.e. with the hue adjusted such that the decoded colors match the
+		// palette used for RGB output (see ppu::get_palette_rgb).
+		constexpr float carrier_cos[samples_per_period]
+		{
+			-0.5f, -0.866025f, -1.0f, -0.866025f, -0.5f, 0.0f, 0.5f, 0.866025f, 1.0f, 0.866025f, 0.5f, 0.0f,
+		};
+		constexpr float carrier_sin[samples_per_period]
+		{
+			0.866025f, 0.5f, 0.0f, -0.5f, -0.866025f, -1.0f, -0.866025f, -0.5f, 0.0f, 0.5f, 0.866025f, 1.0f,
+		};
+		constexpr auto chroma_gain = 1.5f;
+		// Kernel values are fixed-point numbers with 4 fractional bits.
+		constexpr auto fraction_bits = 4;
+
+		constexpr auto padding = u32{ 8 };
+
+		auto is_in_color_phase(u32 const hue, u32 const phase) -> bool
+		{
+			return (hue + phase) % samples_per_period < samples_per_period / 2;
+		}
+
+		/// Normalized signal level (0 = black, 1 = white) of a pixel for one sample.
+		auto get_signal(u32 const pixel, u32 const phase) -> float
+		{
+			auto const hue = pixel & 0x0F;
+			auto const level = hue > 13 ? u32{ 1 } : (pixel >> 4) & 0b11;
+			auto const emphasis = pixel >> 6;
+
+			auto low = signal_levels[0][level];
+			auto high = signal_levels[1][level];
+			if (hue == 0) { low = high; }
+			if (hue > 12) { high = low; }
+
+			auto signal = is_in_color_phase(hue, phase) ? high : low;
+			if (hue < 14 &&
+				(((emphasis & 0b001) && is_in_color_phase(0, phase)) ||
+				((emphasis & 0b010) && is_in_color_phase(4, phase)) ||
+				((emphasis & 0b100) && is_in_color_phase(8, phase))))
+			{
+				signal *= emphasis_attenuation;
+			}
+
+			return (signal - black_level) / (white_level - black_level);
+		}
+
+		auto to_fixed(float const value) -> i16
+		{
+			auto const scaled = value * 255.0f * static_cast<float>(1 << fraction_bits);
+			return static_cast<i16>(static_cast<i32>(scaled + (scaled >= 0.0f ? 0.5f : -0.5f)));
+		}
+
+		auto pack(i16 const* channels) -> u32
+		{
+			auto result = u32{ 0 };
+			for (auto i = u32{ 0 }; i < 4; ++i)
+			{
+				auto const value = min(max(channels[i] >> fraction_bits, 0), 255);
+				result |= static_cast<u32>(value) << (i * 8);
+			}
+			return result;
+		}
+	} // namespace
+
+	ntsc_filter::ntsc_filter(layout const l)
+		: period_input_{ l == layout::standard ? u32{ 3 } : u32{ 2 } }
+		, period_output_{ l == layout::standard ? u32{ 7 } : u32{ 5 } }
+		, output_width_{ l == layout::standard ? u32{ 602 } : u32{ 640 } }
+		, output_offset_{ l == layout::standard ? 2 : 0 }
+	{
+		// Each output pixel averages the samples within one period of the subcarrier around its center.
+		auto const samples_per_output = static_cast<float>(period_input_ * samples_per_pixel) /
+			static_cast<float>(period_output_);
+		auto const get_center = [&](i32 const output) { return (static_cast<float>(output) + 0.5f) * samples_per_output; };
+		auto const half_window = static_cast<float>(samples_per_period) / 2.0f;
+
+		for (auto position = u32{ 0 }; position < period_input_; ++position)
+		{
+			auto const first_sample = static_cast<float>(position * samples_per_pixel) + 0.5f;
+			auto first_output = -static_cast<i32>(kernel_size);
+			while (get_center(first_output) + half_window <= first_sample) { first_output += 1; }
+			kernel_offsets_[position] = first_output;
+		}
+
+		for (auto pixel = u32{ 0 }; pixel < color_count; ++pixel)
+		{
+			for (auto phase_index = u32{ 0 }; phase_index < phase_count; ++phase_index)
+			{
+				auto const phase = phase_index * 4;
+				for (auto position = u32{ 0 }; position < period_input_; ++position)
+				{
+					for (auto k = u32{ 0 }; k < kernel_size; ++k)
+					{
+						auto const center = get_center(kernel_offsets_[position] + static_cast<i32>(k));
+						auto y = 0.0f;
+						auto i = 0.0f;
+						auto q = 0.0f;
+						for (auto s = u32{ 0 }; s < samples_per_pixel; ++s)
+						{
+							auto const sample = static_cast<float>(position * samples_per_pixel + s) + 0.5f;
+							if (sample < center - half_window || sample >= center + half_window) { continue; }
+
+							auto const sample_phase = (phase + s) % samples_per_period;
+							auto const level = get_signal(pixel, sample_phase) / static_cast<float>(samples_per_period);
+							y += level;
+							i += level * carrier_cos[sample_phase] * chroma_gain;
+							q += level * carrier_sin[sample_phase] * chroma_gain;
+						}
+
+						auto& channels = kernels_[pixel][phase_index][position][k];
+						channels[0] = 0;
+						channels[1] = to_fixed(y - 1.108545f * i + 1.709007f * q);
+						channels[2] = to_fixed(y - 0.274788f * i - 0.635691f * q);
+						channels[3] = to_fixed(y + 0.946882f * i + 0.623557f * q);
+					}
+				}
+			}
+		}
+	}
+
+	auto ntsc_filter::filter(
+		pixel_view<u16 const> const source, pixel_view<u32> const target, u64 const frame, u32 const first_row,
+		u32 const row_count) const -> void
+	{
+		NES_ASSERT(source.get_width() == input_width && "unsupported input width");
+		NES_ASSERT(target.get_width() == output_width_ && "unexpected output width");
+
+		for (auto y = first_row; y < first_row + row_count; ++y)
+		{
+			// Each line takes 341 * 8 samples, shifting the phase by 4 samples per line. Frames shift it by either 4 or
+			// 8 samples (if the PPU skips a dot on odd frames while rendering is enabled), so the pattern repeats every
+			// other frame.
+			auto const line_phase = ((frame & 1) * 4 + y * 4) % samples_per_period;
+
+			alignas(16) i16 accumulator[(max_output_width + 2 * padding + kernel_size) * 4]{};
+			auto const row = source.get_row(y);
+			for (auto x = u32{ 0 }; x < input_width; ++x)
+			{
+				auto const position = x % period_input_;
+				auto const phase_index = ((line_phase + x * samples_per_pixel) % samples_per_period) / 4;
+				auto const first_output = static_cast<i32>((x / period_input_) * period_output_) +
+					kernel_offsets_[position] + output_offset_ + static_cast<i32>(padding);
+				auto const& kernel = kernels_[row[x] % color_count][phase_index][position];
+				auto const out = accumulator + first_output * 4;
+
+#if defined(__SSE2__)
+				for (auto k = u32{ 0 }; k < kernel_size; k += 2)
+				{
+					auto const a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(out + k * 4));
+					auto const b = _mm_load_si128(reinterpret_cast<__m128i const*>(kernel[k]));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + k * 4), _mm_add_epi16(a, b));
+				}
+#else
+				for (auto k = u32{ 0 }; k < kernel_size; ++k)
+				{
+					for (auto c = u32{ 0 }; c < 4; ++c) { out[k * 4 + c] = static_cast<i16>(out[k * 4 + c] + kernel[k][c]); }
+				}
+#endif
+			}
+
+			auto const in = accumulator + padding * 4;
+			auto const out = target.get_row(y);
+			auto x = u32{ 0 };
+#if defined(__SSE2__)
+			for (; x + 4 <= output_width_; x += 4)
+			{
+				auto const pixels = reinterpret_cast<__m128i const*>(in + x * 4);
+				auto const a = _mm_srai_epi16(_mm_load_si128(pixels), fraction_bits);
+				auto const b = _mm_srai_epi16(_mm_load_si128(pixels + 1), fraction_bits);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(a, b));
+			}
+#endif
+			for (; x < output_width_; ++x) { out[x] = pack(in + x * 4); }
+		}
+	}
+} // namespace nes::app
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "nes/app/graphics/pixel-view.hh"
+#include "nes/common/types.hh"
+
+namespace nes::app
+{
+	/// Simulates the composite video signal of the console and how a TV decodes it, including the color artifacts
+	/// between neighboring pixels and the dot crawl (in the spirit of blargg's nes_ntsc).
+	///
+	/// The input pixels are what the PPU actually outputs: the palette index (bits 0-5) and the emphasis bits (bits 6-8).
+	/// Each input pixel adds a precomputed kernel (depending on its color, the phase of the color subcarrier and its
+	/// position relative to the output pixels) to the output row, so filtering is just a sequence of vector additions.
+	///
+	/// Output pixels are (r << 24) | (g << 16) | (b << 8), the same format as used by the scalers.
+	class ntsc_filter
+	{
+	public:
+		enum class layout
+		{
+			standard, // 602 pixels per row (7 output pixels per 3 input pixels), similar to nes_ntsc.
+			wide, // 640 pixels per row (5 output pixels per 2 input pixels).
+		};
+
+		static constexpr auto input_width = u32{ 256 };
+		static constexpr auto max_output_width = u32{ 640 };
+		static constexpr auto kernel_size = u32{ 8 };
+
+	private:
+		static constexpr auto color_count = u32{ 512 };
+		static constexpr auto phase_count = u32{ 3 };
+		static constexpr auto max_period = u32{ 3 };
+
+		u32 period_input_; // Input pixels per period.
+		u32 period_output_; // Output pixels per period.
+		u32 output_width_;
+		i32 output_offset_; // Position of the first input pixel in the output row.
+		i32 kernel_offsets_[max_period]{}; // First output pixel of each kernel relative to its period.
+		// Contribution of an input pixel to the kernel_size output pixels, with 4 fixed-point channels (0, b, g, r).
+		alignas(16) i16 kernels_[color_count][phase_count][max_period][kernel_size][4]{};
+
+	public:
+		explicit ntsc_filter(layout);
+
+		ntsc_filter(ntsc_filter const&) = delete;
+		ntsc_filter(ntsc_filter&&) = delete;
+		auto operator=(ntsc_filter const&) -> ntsc_filter& = delete;
+		auto operator=(ntsc_filter&&) -> ntsc_filter& = delete;
+
+		auto get_output_width() const -> u32 { return output_width_; }
+
+		/// Filter the source rows [first_row, first_row + row_count) into the same rows of the target (which needs to be
+		/// get_output_width() pixels wide). The phase of the color subcarrier, and thus the dot crawl, changes with the
+		/// frame number. Bands of rows can be filtered in parallel.
+		auto filter(pixel_view<u16 const> source, pixel_view<u32> target, u64 frame, u32 first_row, u32 row_count) const
+			-> void;
+	};
+} // namespace nes::app
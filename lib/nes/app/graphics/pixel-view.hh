@@ -0,0 +1,33 @@
+#pragma once
+
+#include "nes/common/types.hh"
+
+namespace nes::app
+{
+	/// Non-owning view of a 2-dimensional block of pixels, whose rows are a number of pixels (the pitch) apart.
+	template<typename T>
+	class pixel_view
+	{
+		T* data_{ nullptr };
+		u32 width_{ 0 };
+		u32 height_{ 0 };
+		u32 pitch_{ 0 };
+
+	public:
+		explicit pixel_view() = default;
+
+		explicit pixel_view(T* const data, u32 const width, u32 const height, u32 const pitch)
+			: data_{ data }
+			, width_{ width }
+			, height_{ height }
+			, pitch_{ pitch }
+		{
+		}
+
+		auto get_data() const -> T* { return data_; }
+		auto get_width() const -> u32 { return width_; }
+		auto get_height() const -> u32 { return height_; }
+		auto get_pitch() const -> u32 { return pitch_; }
+		auto get_row(u32 const y) const -> T* { return data_ + y * pitch_; }
+	};
+} // namespace nes::app
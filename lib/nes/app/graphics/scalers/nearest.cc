@@ -0,0 +1,74 @@
+#include "nes/app/graphics/scalers/scalers.hh"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace nes::app
+{
+	namespace
+	{
+		auto scale_row_nearest(u32 const* source, u32* target, u32 const width, u32 const factor) -> void
+		{
+			auto x = u32{ 0 };
+
+#if defined(__SSE2__)
+			if (factor == 2)
+			{
+				for (; x + 4 <= width; x += 4)
+				{
+					auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + x));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(target + 2 * x), _mm_unpacklo_epi32(v, v));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(target + 2 * x + 4), _mm_unpackhi_epi32(v, v));
+				}
+			}
+			else if (factor == 4)
+			{
+				for (; x + 4 <= width; x += 4)
+				{
+					auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + x));
+					auto const out = reinterpret_cast<__m128i*>(target + 4 * x);
+					_mm_storeu_si128(out + 0, _mm_shuffle_epi32(v, 0x00));
+					_mm_storeu_si128(out + 1, _mm_shuffle_epi32(v, 0x55));
+					_mm_storeu_si128(out + 2, _mm_shuffle_epi32(v, 0xAA));
+					_mm_storeu_si128(out + 3, _mm_shuffle_epi32(v, 0xFF));
+				}
+			}
+#endif
+
+			for (; x < width; ++x)
+			{
+				for (auto i = u32{ 0 }; i < factor; ++i) { target[x * factor + i] = source[x]; }
+			}
+		}
+	} // namespace
+
+	auto scale_nearest(
+		pixel_view<u32 const> const source, pixel_view<u32> const target, u32 const factor, u32 const first_row,
+		u32 const row_count) -> void
+	{
+		auto const row_size = source.get_width() * factor * static_cast<u32>(sizeof(u32));
+		for (auto y = first_row; y < first_row + row_count; ++y)
+		{
+			// Only the first row is scaled, the others are copies of it.
+			auto const first_target_row = target.get_row(y * factor);
+			scale_row_nearest(source.get_row(y), first_target_row, source.get_width(), factor);
+			for (auto i = u32{ 1 }; i < factor; ++i)
+			{
+				__builtin_memcpy(target.get_row(y * factor + i), first_target_row, row_size);
+			}
+		}
+	}
+
+	auto expand_indexed(
+		pixel_view<u8 const> const source, u32 const (&palette)[64], pixel_view<u32> const target,
+		u32 const first_row, u32 const row_count) -> void
+	{
+		for (auto y = first_row; y < first_row + row_count; ++y)
+		{
+			auto const in = source.get_row(y);
+			auto const out = target.get_row(y);
+			for (auto x = u32{ 0 }; x < source.get_width(); ++x) { out[x] = palette[in[x] & 0x3F]; }
+		}
+	}
+} // namespace nes::app
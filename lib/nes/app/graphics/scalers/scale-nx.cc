@@ -0,0 +1,166 @@
+#include "nes/app/graphics/scalers/scalers.hh"
+#include "nes/common/utils.hh"
+#include "nes/common/debug.hh"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace nes::app
+{
+	namespace
+	{
+		// Neighbors of the pixel E:
+		//
+		//   A B C
+		//   D E F
+		//   G H I
+		//
+		// Pixels outside of the source are clamped to the edge.
+
+		struct rows
+		{
+			u32 const* above;
+			u32 const* current;
+			u32 const* below;
+			u32 width;
+
+			auto get(u32 const* row, u32 const x, i32 const offset) const -> u32
+			{
+				auto const clamped = static_cast<i32>(x) + offset;
+				if (clamped < 0) { return row[0]; }
+				if (clamped >= static_cast<i32>(width)) { return row[width - 1]; }
+				return row[clamped];
+			}
+		};
+
+		auto get_rows(pixel_view<u32 const> const source, u32 const y) -> rows
+		{
+			return rows
+			{
+				source.get_row(y > 0 ? y - 1 : y),
+				source.get_row(y),
+				source.get_row(min(y + 1, source.get_height() - 1)),
+				source.get_width(),
+			};
+		}
+
+		auto scale2x_pixel(rows const& r, u32 const x, u32* out_0, u32* out_1) -> void
+		{
+			auto const b = r.above[x];
+			auto const d = r.get(r.current, x, -1);
+			auto const e = r.current[x];
+			auto const f = r.get(r.current, x, +1);
+			auto const h = r.below[x];
+
+			if (b != h && d != f)
+			{
+				out_0[0] = d == b ? d : e;
+				out_0[1] = b == f ? f : e;
+				out_1[0] = d == h ? d : e;
+				out_1[1] = h == f ? f : e;
+			}
+			else
+			{
+				out_0[0] = out_0[1] = out_1[0] = out_1[1] = e;
+			}
+		}
+
+#if defined(__SSE2__)
+		auto select(__m128i const mask, __m128i const a, __m128i const b) -> __m128i
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
+
+		/// Scale four pixels at once (x - 1 and x + 4 need to be within the row).
+		auto scale2x_pixels(rows const& r, u32 const x, u32* out_0, u32* out_1) -> void
+		{
+			auto const load = [](u32 const* p) { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p)); };
+			auto const b = load(r.above + x);
+			auto const d = load(r.current + x - 1);
+			auto const e = load(r.current + x);
+			auto const f = load(r.current + x + 1);
+			auto const h = load(r.below + x);
+
+			// Same as the scalar version: corners only change if b != h and d != f.
+			auto const active = _mm_andnot_si128(
+				_mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f)), _mm_set1_epi32(-1));
+			auto const e0 = select(_mm_and_si128(active, _mm_cmpeq_epi32(d, b)), d, e);
+			auto const e1 = select(_mm_and_si128(active, _mm_cmpeq_epi32(b, f)), f, e);
+			auto const e2 = select(_mm_and_si128(active, _mm_cmpeq_epi32(d, h)), d, e);
+			auto const e3 = select(_mm_and_si128(active, _mm_cmpeq_epi32(h, f)), f, e);
+
+			auto const store = [](u32* p, __m128i const v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); };
+			store(out_0 + 2 * x, _mm_unpacklo_epi32(e0, e1));
+			store(out_0 + 2 * x + 4, _mm_unpackhi_epi32(e0, e1));
+			store(out_1 + 2 * x, _mm_unpacklo_epi32(e2, e3));
+			store(out_1 + 2 * x + 4, _mm_unpackhi_epi32(e2, e3));
+		}
+#endif
+
+		auto scale2x_row(rows const& r, u32* out_0, u32* out_1) -> void
+		{
+			auto x = u32{ 0 };
+#if defined(__SSE2__)
+			if (r.width > 5)
+			{
+				scale2x_pixel(r, 0, out_0, out_1);
+				for (x = 1; x + 5 <= r.width; x += 4) { scale2x_pixels(r, x, out_0, out_1); }
+			}
+#endif
+			for (; x < r.width; ++x) { scale2x_pixel(r, x, out_0 + 2 * x, out_1 + 2 * x); }
+		}
+
+		auto scale3x_row(rows const& r, u32* out_0, u32* out_1, u32* out_2) -> void
+		{
+			for (auto x = u32{ 0 }; x < r.width; ++x)
+			{
+				auto const a = r.get(r.above, x, -1);
+				auto const b = r.above[x];
+				auto const c = r.get(r.above, x, +1);
+				auto const d = r.get(r.current, x, -1);
+				auto const e = r.current[x];
+				auto const f = r.get(r.current, x, +1);
+				auto const g = r.get(r.below, x, -1);
+				auto const h = r.below[x];
+				auto const i = r.get(r.below, x, +1);
+
+				auto const o0 = out_0 + 3 * x;
+				auto const o1 = out_1 + 3 * x;
+				auto const o2 = out_2 + 3 * x;
+				if (b != h && d != f)
+				{
+					o0[0] = d == b ? d : e;
+					o0[1] = (d == b && e != c) || (b == f && e != a) ? b : e;
+					o0[2] = b == f ? f : e;
+					o1[0] = (d == b && e != g) || (d == h && e != a) ? d : e;
+					o1[1] = e;
+					o1[2] = (b == f && e != i) || (h == f && e != c) ? f : e;
+					o2[0] = d == h ? d : e;
+					o2[1] = (d == h && e != i) || (h == f && e != g) ? h : e;
+					o2[2] = h == f ? f : e;
+				}
+				else
+				{
+					o0[0] = o0[1] = o0[2] = e;
+					o1[0] = o1[1] = o1[2] = e;
+					o2[0] = o2[1] = o2[2] = e;
+				}
+			}
+		}
+	} // namespace
+
+	auto scale_nx(
+		pixel_view<u32 const> const source, pixel_view<u32> const target, u32 const factor, u32 const first_row,
+		u32 const row_count) -> void
+	{
+		NES_ASSERT((factor == 2 || factor == 3) && "unsupported factor");
+
+		for (auto y = first_row; y < first_row + row_count; ++y)
+		{
+			auto const r = get_rows(source, y);
+			if (factor == 2) { scale2x_row(r, target.get_row(2 * y), target.get_row(2 * y + 1)); }
+			else { scale3x_row(r, target.get_row(3 * y), target.get_row(3 * y + 1), target.get_row(3 * y + 2)); }
+		}
+	}
+} // namespace nes::app
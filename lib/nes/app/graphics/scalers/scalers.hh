@@ -0,0 +1,28 @@
+#pragma once
+
+#include "nes/app/graphics/pixel-view.hh"
+#include "nes/common/types.hh"
+
+namespace nes::app
+{
+	// All scalers write the target rows for the source rows [first_row, first_row + row_count) and read the rows around
+	// them, so bands of rows can be scaled in parallel. The target must be exactly factor times as large as the source.
+	// Pixels are 32-bit values with 8 bits per channel (in any order).
+
+	/// Repeat each pixel factor times in both directions (any factor).
+	auto scale_nearest(
+		pixel_view<u32 const> source, pixel_view<u32> target, u32 factor, u32 first_row, u32 row_count) -> void;
+	/// Scale2x and Scale3x (also known as AdvMAME2x/3x), which round off diagonal edges of pixel art without introducing
+	/// new colors (factor 2 or 3).
+	auto scale_nx(pixel_view<u32 const> source, pixel_view<u32> target, u32 factor, u32 first_row, u32 row_count)
+		-> void;
+	/// A simplified xBR (level 1): corners on diagonal edges, detected using the color distances in a 5x5 neighborhood,
+	/// are cut off at 45 degrees and filled with the neighboring color, with blended pixels along the cut (factor 2-4).
+	auto scale_xbr_lite(
+		pixel_view<u32 const> source, pixel_view<u32> target, u32 factor, u32 first_row, u32 row_count) -> void;
+
+	/// Look up the color of each palette index (e.g. to scale indexed frames).
+	auto expand_indexed(
+		pixel_view<u8 const> source, u32 const (&palette)[64], pixel_view<u32> target, u32 first_row, u32 row_count)
+		-> void;
+} // namespace nes::app
@@ -0,0 +1,159 @@
+#include "nes/app/graphics/scalers/scalers.hh"
+#include "nes/common/utils.hh"
+#include "nes/common/debug.hh"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace nes::app
+{
+	namespace
+	{
+		// Neighborhood of the pixel E, as seen from its bottom right corner (the other corners are mirrored):
+		//
+		//       A1 B1 C1
+		//    A0 A  B  C  C4
+		//    D0 D  E  F  F4
+		//    G0 G  H  I  I4
+		//       G5 H5 I5
+		//
+		// The corner is on an edge if the differences along the diagonal G-E-C/H-F/I are smaller than across it (along
+		// D-H-I5/B-F-I4/E-I). It is then filled with the color of F or H (whichever is closer to E).
+		//
+		// Unlike the original xBR, the color distance is the sum of the differences of all channels (not in YUV) and
+		// there is only one rule (level 1).
+
+		constexpr i32 corner_directions[4][2]{ { 1, 1 }, { -1, 1 }, { 1, -1 }, { -1, -1 } };
+
+		/// Sum of the absolute differences of all channels.
+		auto get_distance(u32 const a, u32 const b) -> u32
+		{
+			if (a == b) { return 0; }
+
+#if defined(__SSE2__)
+			auto const x = _mm_cvtsi32_si128(static_cast<int>(a));
+			auto const y = _mm_cvtsi32_si128(static_cast<int>(b));
+			return static_cast<u32>(_mm_cvtsi128_si32(_mm_sad_epu8(x, y)));
+#else
+			auto result = u32{ 0 };
+			for (auto shift = u32{ 0 }; shift < 32; shift += 8)
+			{
+				auto const x = static_cast<i32>((a >> shift) & 0xFF);
+				auto const y = static_cast<i32>((b >> shift) & 0xFF);
+				result += static_cast<u32>(x > y ? x - y : y - x);
+			}
+			return result;
+#endif
+		}
+
+		/// Average of all channels (without overflowing into the next one).
+		auto blend(u32 const a, u32 const b) -> u32
+		{
+			return (a & b) + (((a ^ b) & 0xFEFEFEFE) >> 1);
+		}
+
+		/// The 5x5 neighborhood, clamped to the edges of the source.
+		struct neighborhood
+		{
+			u32 const* rows[5];
+			u32 columns[5];
+
+			auto get(i32 const dx, i32 const dy) const -> u32 { return rows[2 + dy][columns[2 + dx]]; }
+		};
+
+		/// Color of the corner in the direction (sx, sy) if it should be cut off (or E otherwise).
+		auto get_corner(neighborhood const& n, i32 const sx, i32 const sy) -> u32
+		{
+			auto const at = [&](i32 const dx, i32 const dy) { return n.get(sx * dx, sy * dy); };
+
+			auto const e = at(0, 0);
+			auto const f = at(1, 0);
+			auto const h = at(0, 1);
+			if (f == e || h == e) { return e; }
+
+			auto const i = at(1, 1);
+			auto const along = get_distance(e, at(1, -1)) + get_distance(e, at(-1, 1)) + get_distance(i, at(2, 0)) +
+				get_distance(i, at(0, 2)) + 4 * get_distance(h, f);
+			auto const across = get_distance(h, at(-1, 0)) + get_distance(h, at(1, 2)) + get_distance(f, at(2, 1)) +
+				get_distance(f, at(0, -1)) + 4 * get_distance(e, i);
+			if (along >= across) { return e; }
+
+			return get_distance(e, f) <= get_distance(e, h) ? f : h;
+		}
+
+		template<u32 factor>
+		auto scale_row(pixel_view<u32 const> const source, pixel_view<u32> const target, u32 const y) -> void
+		{
+			auto const width = static_cast<i32>(source.get_width());
+			auto const height = static_cast<i32>(source.get_height());
+
+			auto n = neighborhood{};
+			for (auto dy = i32{ -2 }; dy <= 2; ++dy)
+			{
+				auto const row = min(max(static_cast<i32>(y) + dy, 0), height - 1);
+				n.rows[2 + dy] = source.get_row(static_cast<u32>(row));
+			}
+
+			u32* out[factor];
+			for (auto j = u32{ 0 }; j < factor; ++j) { out[j] = target.get_row(y * factor + j); }
+
+			for (auto x = i32{ 0 }; x < width; ++x)
+			{
+				for (auto dx = i32{ -2 }; dx <= 2; ++dx)
+				{
+					n.columns[2 + dx] = static_cast<u32>(min(max(x + dx, 0), width - 1));
+				}
+
+				auto const e = n.get(0, 0);
+				u32* block[factor];
+				for (auto j = u32{ 0 }; j < factor; ++j)
+				{
+					block[j] = out[j] + static_cast<u32>(x) * factor;
+					for (auto i = u32{ 0 }; i < factor; ++i) { block[j][i] = e; }
+				}
+
+				// Most pixels are part of a flat area, where no corner can be on an edge.
+				if (n.get(-1, 0) == e && n.get(1, 0) == e && n.get(0, -1) == e && n.get(0, 1) == e) { continue; }
+
+				for (auto const& direction : corner_directions)
+				{
+					auto const sx = direction[0];
+					auto const sy = direction[1];
+					auto const corner = get_corner(n, sx, sy);
+					if (corner == e) { continue; }
+
+					// Cut off the corner along the line through the middle of its two edges: sub-pixels behind the line
+					// take over the new color, the ones on the line are blended.
+					for (auto j = u32{ 0 }; j < factor; ++j)
+					{
+						auto const v = sy > 0 ? j : factor - 1 - j;
+						for (auto i = u32{ 0 }; i < factor; ++i)
+						{
+							auto const u = sx > 0 ? i : factor - 1 - i;
+							if (u + v >= factor) { block[j][i] = corner; }
+							else if (u + v == factor - 1) { block[j][i] = blend(block[j][i], corner); }
+						}
+					}
+				}
+			}
+		}
+	} // namespace
+
+	auto scale_xbr_lite(
+		pixel_view<u32 const> const source, pixel_view<u32> const target, u32 const factor, u32 const first_row,
+		u32 const row_count) -> void
+	{
+		NES_ASSERT(factor >= 2 && factor <= 4 && "unsupported factor");
+
+		for (auto y = first_row; y < first_row + row_count; ++y)
+		{
+			switch (factor)
+			{
+				case 2: scale_row<2>(source, target, y); break;
+				case 3: scale_row<3>(source, target, y); break;
+				default: scale_row<4>(source, target, y); break;
+			}
+		}
+	}
+} // namespace nes::app
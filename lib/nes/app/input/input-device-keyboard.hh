@@ -11,6 +11,25 @@ namespace nes::app
 	class input_device_keyboard : public input_device
 	{
 	public:
+		struct button_key
+		{
+			key k;
+			sys::button_mask button;
+		};
+
+		/// Keys used for the controller buttons.
+		static constexpr button_key button_keys[]
+		{
+			{ key::letter_w, sys::buttons::up },
+			{ key::letter_a, sys::buttons::left },
+			{ key::letter_s, sys::buttons::down },
+			{ key::letter_d, sys::buttons::right },
+			{ key::letter_k, sys::buttons::b },
+			{ key::letter_l, sys::buttons::a },
+			{ key::space, sys::buttons::select },
+			{ key::enter, sys::buttons::start },
+		};
+
 		/// Read the current state of a key.
 		virtual auto read_key(key) -> bool = 0;
 
@@ -23,14 +42,10 @@ namespace nes::app
 		auto read_buttons() -> sys::button_mask final
 		{
 			auto res = sys::button_mask{};
-			if (read_key(key::letter_w)) { res.add(sys::buttons::up); }
-			if (read_key(key::letter_a)) { res.add(sys::buttons::left); }
-			if (read_key(key::letter_s)) { res.add(sys::buttons::down); }
-			if (read_key(key::letter_d)) { res.add(sys::buttons::right); }
-			if (read_key(key::letter_k)) { res.add(sys::buttons::b); }
-			if (read_key(key::letter_l)) { res.add(sys::buttons::a); }
-			if (read_key(key::space)) { res.add(sys::buttons::select); }
-			if (read_key(key::enter)) { res.add(sys::buttons::start); }
+			for (auto const& b : button_keys)
+			{
+				if (read_key(b.k)) { res.add(b.button); }
+			}
 			return res;
 		}
 
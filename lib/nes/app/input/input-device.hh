@@ -18,6 +18,9 @@ namespace nes::app
 
 		/// Read the controller button state.
 		virtual auto read_buttons() -> sys::button_mask = 0;
+		/// Read the controller button state while the console is running, when the game latches the controller. Devices
+		/// receiving input asynchronously can return newer state than read_buttons (which only changes between frames).
+		virtual auto read_buttons_now() -> sys::button_mask { return read_buttons(); }
 
 		/// Human-readable name for the device.
 		virtual auto get_name() const -> string_view = 0;
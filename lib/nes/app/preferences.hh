@@ -1,11 +1,14 @@
 #pragma once
 
+#include "nes/common/types.hh"
+
 namespace nes::app
 {
 	/// Manages application preferences.
 	class preferences
 	{
 		bool fps_counter_{ false };
+		u32 run_ahead_frames_{ 0 };
 
 	public:
 		explicit preferences() = default;
@@ -17,5 +20,8 @@ namespace nes::app
 
 		auto get_fps_counter() const -> bool { return fps_counter_; }
 		auto set_fps_counter(bool const v) -> void { fps_counter_ = v; }
+		/// Number of frames emulated ahead of the presented frame to hide a game's input lag (0 to disable).
+		auto get_run_ahead_frames() const -> u32 { return run_ahead_frames_; }
+		auto set_run_ahead_frames(u32 const v) -> void { run_ahead_frames_ = v; }
 	};
 } // namespace nes::app
\ No newline at end of file
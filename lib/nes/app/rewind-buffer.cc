@@ -0,0 +1,275 @@
+#include "nes/app/rewind-buffer.hh"
+#include "nes/common/debug.hh"
+#include "nes/common/utils.hh"
+
+namespace nes::app
+{
+	namespace
+	{
+		auto load_word(u8 const* const p) -> u64
+		{
+			auto res = u64{ 0 };
+			__builtin_memcpy(&res, p, sizeof(res));
+			return res;
+		}
+
+		auto store_word(u8* const p, u64 const value) -> void
+		{
+			__builtin_memcpy(p, &value, sizeof(value));
+		}
+
+		auto load_u16(u8 const* const p) -> u32
+		{
+			return static_cast<u32>(p[0]) | (static_cast<u32>(p[1]) << 8);
+		}
+
+		auto store_u16(u8* const p, u32 const value) -> void
+		{
+			p[0] = static_cast<u8>(value >> 0);
+			p[1] = static_cast<u8>(value >> 8);
+		}
+	} // namespace
+
+	auto rewind_buffer::set_storage(span<u8> const storage, u32 const keyframe_interval) -> void
+	{
+		storage_ = storage;
+		keyframe_interval_ = max(keyframe_interval, u32{ 1 });
+		clear();
+	}
+
+	auto rewind_buffer::clear() -> void
+	{
+		begin_ = 0;
+		end_ = 0;
+		wrap_ = 0;
+		wrapped_ = false;
+		count_ = 0;
+		deltas_since_keyframe_ = 0;
+	}
+
+	auto rewind_buffer::push(sys::nes const& console) -> status
+	{
+		if (auto const s = console.save_state(span{ current_ }); s != status::success) { return s; }
+
+		if (count_ > 0 && deltas_since_keyframe_ + 1 < keyframe_interval_)
+		{
+			auto const size = encode(keyframe_);
+			if (auto* const record = allocate(size + record_overhead, true))
+			{
+				auto const header = record_header{ size, record_type::delta };
+				auto const total = size + record_overhead;
+				__builtin_memcpy(record, &header, sizeof(header));
+				__builtin_memcpy(record + sizeof(header), encoded_, size);
+				__builtin_memcpy(record + sizeof(header) + size, &total, sizeof(total));
+				deltas_since_keyframe_ += 1;
+				return status::success;
+			}
+
+			// Making room would drop the keyframe this delta refers to, so start over with a new keyframe.
+			clear();
+		}
+
+		auto const size = encode(nullptr);
+		auto* const record = allocate(size + record_overhead, false);
+		if (!record) { return status::error_buffer_overflow; }
+
+		auto const header = record_header{ size, record_type::keyframe };
+		auto const total = size + record_overhead;
+		__builtin_memcpy(record, &header, sizeof(header));
+		__builtin_memcpy(record + sizeof(header), encoded_, size);
+		__builtin_memcpy(record + sizeof(header) + size, &total, sizeof(total));
+		__builtin_memcpy(keyframe_, current_, state_capacity);
+		deltas_since_keyframe_ = 0;
+		return status::success;
+	}
+
+	auto rewind_buffer::pop(sys::nes& console) -> bool
+	{
+		if (count_ < 2) { return false; }
+
+		drop_newest();
+		auto const start = get_previous(end_);
+		auto const header = get_header(start);
+		auto const reference = header.type == record_type::keyframe ? nullptr : keyframe_;
+		decode(&storage_[start + sizeof(record_header)], header.size, reference, current_);
+		return console.load_state(span<u8 const>{ current_, sys::nes::state_size }) == status::success;
+	}
+
+	auto rewind_buffer::encode(u8 const* const reference) -> u32
+	{
+		auto const get_difference = [&](u32 const word)
+		{
+			auto const value = load_word(&current_[word * 8]);
+			return reference ? value ^ load_word(&reference[word * 8]) : value;
+		};
+
+		// The state is encoded as a sequence of tokens, each consisting of the number of unchanged words and the number
+		// of changed words, followed by the changed words (XOR-ed with the reference).
+		auto size = u32{ 0 };
+		auto word = u32{ 0 };
+		while (word < word_count)
+		{
+			auto zeros = u32{ 0 };
+			while (word < word_count && zeros < max_run_length && get_difference(word) == 0)
+			{
+				zeros += 1;
+				word += 1;
+			}
+
+			auto const token = size;
+			size += 4;
+
+			auto literals = u32{ 0 };
+			while (word < word_count && literals < max_run_length)
+			{
+				auto const difference = get_difference(word);
+				if (difference == 0) { break; }
+
+				store_word(&encoded_[size], difference);
+				size += 8;
+				literals += 1;
+				word += 1;
+			}
+
+			store_u16(&encoded_[token + 0], zeros);
+			store_u16(&encoded_[token + 2], literals);
+		}
+
+		NES_ASSERT(size <= max_encoded_size && "encoded state exceeds its worst-case size");
+		return size;
+	}
+
+	auto rewind_buffer::decode(u8 const* const encoded, u32 const size, u8 const* const reference, u8* const output) const
+		-> void
+	{
+		auto position = u32{ 0 };
+		auto word = u32{ 0 };
+		while (position < size)
+		{
+			auto const zeros = load_u16(&encoded[position + 0]);
+			auto const literals = load_u16(&encoded[position + 2]);
+			position += 4;
+
+			if (reference) { __builtin_memcpy(&output[word * 8], &reference[word * 8], zeros * 8); }
+			else { __builtin_memset(&output[word * 8], 0, zeros * 8); }
+			word += zeros;
+
+			for (auto i = u32{ 0 }; i < literals; ++i)
+			{
+				auto const difference = load_word(&encoded[position]);
+				auto const value = reference ? difference ^ load_word(&reference[word * 8]) : difference;
+				store_word(&output[word * 8], value);
+				position += 8;
+				word += 1;
+			}
+		}
+
+		NES_ASSERT(word == word_count && "corrupted rewind record");
+	}
+
+	auto rewind_buffer::allocate(u32 const size, bool const keep_newest_keyframe) -> u8*
+	{
+		if (size > storage_.get_length()) { return nullptr; }
+
+		while (true)
+		{
+			if (!wrapped_)
+			{
+				if (count_ == 0)
+				{
+					begin_ = 0;
+					end_ = 0;
+				}
+				if (end_ + size <= storage_.get_length()) { break; }
+
+				// Continue at the start of the storage.
+				wrap_ = end_;
+				end_ = 0;
+				wrapped_ = true;
+			}
+			else
+			{
+				if (end_ + size <= begin_) { break; }
+				if (keep_newest_keyframe && count_ == deltas_since_keyframe_ + 1) { return nullptr; }
+				drop_oldest();
+			}
+		}
+
+		auto* const res = &storage_[end_];
+		end_ += size;
+		count_ += 1;
+		return res;
+	}
+
+	auto rewind_buffer::drop_newest() -> void
+	{
+		auto const start = get_previous(end_);
+		auto const header = get_header(start);
+		end_ = start;
+		count_ -= 1;
+		if (wrapped_ && end_ == 0)
+		{
+			end_ = wrap_;
+			wrapped_ = false;
+		}
+
+		if (count_ == 0)
+		{
+			clear();
+		}
+		else if (header.type == record_type::keyframe)
+		{
+			// The remaining deltas refer to the previous keyframe, which always exists because the oldest record is
+			// a keyframe.
+			auto position = end_;
+			auto deltas = u32{ 0 };
+			while (true)
+			{
+				position = get_previous(position);
+				auto const previous = get_header(position);
+				if (previous.type == record_type::keyframe)
+				{
+					decode(&storage_[position + sizeof(record_header)], previous.size, nullptr, keyframe_);
+					break;
+				}
+				deltas += 1;
+			}
+			deltas_since_keyframe_ = deltas;
+		}
+		else
+		{
+			deltas_since_keyframe_ -= 1;
+		}
+	}
+
+	auto rewind_buffer::drop_oldest() -> void
+	{
+		// Deltas are useless without their keyframe, so they are dropped together.
+		do
+		{
+			begin_ += get_header(begin_).size + record_overhead;
+			count_ -= 1;
+			if (wrapped_ && begin_ == wrap_)
+			{
+				begin_ = 0;
+				wrapped_ = false;
+			}
+		}
+		while (count_ > 0 && get_header(begin_).type == record_type::delta);
+	}
+
+	auto rewind_buffer::get_previous(u32 const start) const -> u32
+	{
+		auto const end = start == 0 && wrapped_ ? wrap_ : start;
+		auto total = u32{ 0 };
+		__builtin_memcpy(&total, &storage_[end - sizeof(total)], sizeof(total));
+		return end - total;
+	}
+
+	auto rewind_buffer::get_header(u32 const start) const -> record_header
+	{
+		auto res = record_header{};
+		__builtin_memcpy(&res, &storage_[start], sizeof(res));
+		return res;
+	}
+} // namespace nes::app
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "nes/sys/nes.hh"
+#include "nes/common/containers/span.hh"
+#include "nes/common/types.hh"
+
+namespace nes::app
+{
+	/// Stores a history of console states in a fixed amount of memory, which allows stepping back frame by frame.
+	///
+	/// Every keyframe_interval states, a keyframe is stored. The other states are XOR-ed with the last keyframe and
+	/// only the differing 8 byte words are kept, which typically reduces a state to a few hundred bytes. The records
+	/// are stored in a ring buffer, and the oldest keyframe (together with its deltas) is dropped when running out of
+	/// space.
+	class rewind_buffer
+	{
+	public:
+		static constexpr auto default_keyframe_interval = u32{ 60 };
+
+	private:
+		static constexpr auto word_count = (sys::nes::state_size + 7) / 8;
+		static constexpr auto state_capacity = word_count * 8;
+		static constexpr auto max_run_length = u32{ 0xFFFF };
+		// Each token consists of two 16 bit run lengths (zero words and literal words).
+		static constexpr auto max_encoded_size = state_capacity + 4 * (word_count / max_run_length + 2);
+
+		enum class record_type : u32
+		{
+			keyframe,
+			delta,
+		};
+
+		/// Records are stored as a header, the encoded state and the total record size (for walking backwards).
+		struct record_header
+		{
+			u32 size;
+			record_type type;
+		};
+
+		static constexpr auto record_overhead = u32{ sizeof(record_header) + sizeof(u32) };
+
+		span<u8> storage_{};
+		u32 keyframe_interval_{ default_keyframe_interval };
+		// The stored records are [begin_, end_) if not wrapped, otherwise [begin_, wrap_) followed by [0, end_).
+		u32 begin_{ 0 };
+		u32 end_{ 0 };
+		u32 wrap_{ 0 };
+		bool wrapped_{ false };
+		u32 count_{ 0 };
+		u32 deltas_since_keyframe_{ 0 };
+		alignas(8) u8 keyframe_[state_capacity]{};
+		alignas(8) u8 current_[state_capacity]{};
+		alignas(8) u8 encoded_[max_encoded_size]{};
+
+	public:
+		explicit rewind_buffer() = default;
+
+		rewind_buffer(rewind_buffer const&) = delete;
+		rewind_buffer(rewind_buffer&&) = delete;
+		auto operator=(rewind_buffer const&) -> rewind_buffer& = delete;
+		auto operator=(rewind_buffer&&) -> rewind_buffer& = delete;
+
+		/// Size of the largest possible record, the storage should be much larger than that.
+		static constexpr auto max_record_size = max_encoded_size + record_overhead;
+
+		auto get_storage() const -> span<u8> { return storage_; }
+		auto get_count() const -> u32 { return count_; }
+		auto is_empty() const -> bool { return count_ == 0; }
+
+		/// Use the given memory for storing states (which must outlive the buffer), dropping all stored states.
+		auto set_storage(span<u8> storage, u32 keyframe_interval = default_keyframe_interval) -> void;
+		/// Drop all stored states.
+		auto clear() -> void;
+		/// Store the current state of the console.
+		auto push(sys::nes const&) -> status;
+		/// Remove the most recent state and load the one before it (which stays stored) into the console. States are
+		/// stored before each frame, so replaying a frame from there leaves the console one frame earlier than before.
+		/// Returns false if there are less than two stored states.
+		auto pop(sys::nes&) -> bool;
+
+	private:
+		auto encode(u8 const* reference) -> u32;
+		auto decode(u8 const* encoded, u32 size, u8 const* reference, u8* output) const -> void;
+		auto allocate(u32 size, bool keep_newest_keyframe) -> u8*;
+		auto drop_newest() -> void;
+		auto drop_oldest() -> void;
+		auto get_previous(u32 start) const -> u32;
+		auto get_header(u32 start) const -> record_header;
+	};
+} // namespace nes::app
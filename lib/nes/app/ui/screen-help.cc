@@ -93,6 +93,7 @@ namespace nes::app
 		render_list_item(y_offset, "Action A", "L", false, false);
 		render_list_item(y_offset, "Start", "<Enter>");
 		render_list_item(y_offset, "Select", "<Space>");
+		render_list_item(y_offset, "Rewind", "<Backspace>");
 	}
 
 	auto screen_help::process_events() -> action
@@ -4,6 +4,12 @@
 
 namespace nes::app
 {
+	namespace
+	{
+		constexpr auto max_run_ahead_frames = u32{ 3 };
+		constexpr char const* run_ahead_labels[max_run_ahead_frames + 1] = { "Off", "1 Frame", "2 Frames", "3 Frames" };
+	} // namespace
+
 	auto screen_settings::selection_impl::render_item(
 		renderer& renderer, item const& item, i32 const x, i32 const y, u32 const width, color const c) const -> void
 	{
@@ -27,6 +33,9 @@ namespace nes::app
 			case item::fps_counter:
 				render("FPS Counter:", preferences_.get_fps_counter() ? "Yes" : "No");
 				break;
+			case item::run_ahead:
+				render("Run-Ahead:", run_ahead_labels[preferences_.get_run_ahead_frames()]);
+				break;
 		}
 	}
 
@@ -35,7 +44,8 @@ namespace nes::app
 		items[0] = item::controller_1;
 		items[1] = item::controller_2;
 		items[2] = item::fps_counter;
-		return 3;
+		items[3] = item::run_ahead;
+		return 4;
 	}
 
 	screen_settings::screen_settings(input_manager& input_manager, preferences& preferences)
@@ -89,6 +99,9 @@ namespace nes::app
 					case item::controller_1: input_manager_.toggle_input_1(); break;
 					case item::controller_2: input_manager_.toggle_input_2(); break;
 					case item::fps_counter: preferences_.set_fps_counter(!preferences_.get_fps_counter()); break;
+					case item::run_ahead:
+						preferences_.set_run_ahead_frames((preferences_.get_run_ahead_frames() + 1) % (max_run_ahead_frames + 1));
+						break;
 				}
 			}
 		}
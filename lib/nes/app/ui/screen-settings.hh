@@ -18,6 +18,7 @@ namespace nes::app
 			controller_1,
 			controller_2,
 			fps_counter,
+			run_ahead,
 		};
 
 		class selection_impl final : public selection<item, page_size>
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "nes/common/types.hh"
+
+namespace nes
+{
+	namespace detail
+	{
+		// The pulse channels and the triangle/noise/DMC channels are mixed by two separate resistor networks, so each
+		// group can be precomputed as a single table. See: https://www.nesdev.org/wiki/APU_Mixer
+
+		inline constexpr auto mixer_pulse_table_size = u32{ 31 };
+		inline constexpr auto mixer_tnd_table_size = u32{ 203 };
+		inline constexpr auto mixer_scale = 30000.0; // Leaves headroom for the overshoot of band-limited steps.
+
+		struct mixer_tables
+		{
+			i16 pulse[mixer_pulse_table_size]{};
+			i16 tnd[mixer_tnd_table_size]{};
+		};
+
+		constexpr auto make_mixer_tables() -> mixer_tables
+		{
+			auto res = mixer_tables{};
+			for (auto i = u32{ 1 }; i < mixer_pulse_table_size; ++i)
+			{
+				res.pulse[i] = static_cast<i16>(mixer_scale * 95.52 / (8128.0 / i + 100.0));
+			}
+			for (auto i = u32{ 1 }; i < mixer_tnd_table_size; ++i)
+			{
+				res.tnd[i] = static_cast<i16>(mixer_scale * 163.67 / (24329.0 / i + 100.0));
+			}
+			return res;
+		}
+
+		inline constexpr auto mixer_tables_value = make_mixer_tables();
+	} // namespace detail
+
+	/// Combines the channel levels of an NES-style sound chip, including the non-linearity of the console's DAC.
+	class audio_mixer
+	{
+	public:
+		/// The amplitude produced when all channels are at their maximum level.
+		static constexpr auto max_output = i32{ detail::mixer_tables_value.pulse[detail::mixer_pulse_table_size - 1] } +
+			i32{ detail::mixer_tables_value.tnd[detail::mixer_tnd_table_size - 1] };
+
+		/// Mix the given levels (0-15 for all channels except for the DMC, which uses 0-127).
+		static constexpr auto mix(u32 const pulse_1, u32 const pulse_2, u32 const triangle, u32 const noise, u32 const dmc) -> i32
+		{
+			return detail::mixer_tables_value.pulse[pulse_1 + pulse_2] +
+				detail::mixer_tables_value.tnd[3 * triangle + 2 * noise + dmc];
+		}
+	};
+} // namespace nes
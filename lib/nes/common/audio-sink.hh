@@ -0,0 +1,30 @@
+#pragma once
+
+#include "nes/common/containers/span.hh"
+#include "nes/common/types.hh"
+
+namespace nes
+{
+	/// Abstraction of the audio output (mono, signed 16 bit samples).
+	class audio_sink
+	{
+	public:
+		virtual ~audio_sink() = default;
+
+		audio_sink(audio_sink const&) = delete;
+		audio_sink(audio_sink&&) = delete;
+		auto operator=(audio_sink const&) -> audio_sink& = delete;
+		auto operator=(audio_sink&&) -> audio_sink& = delete;
+
+		/// The nominal output sample rate.
+		virtual auto get_sample_rate() const -> u32 = 0;
+		/// Adjustment of the sample rate (in parts per million) which the producer should apply to keep the sink's
+		/// buffer at its target fill level, compensating for the difference between the emulation and audio clocks.
+		virtual auto get_rate_adjustment() const -> i32 { return 0; }
+		/// Queue samples for playback. This must not block, samples which don't fit are dropped.
+		virtual auto write(span<i16 const> samples) -> void = 0;
+
+	protected:
+		explicit audio_sink() = default;
+	};
+} // namespace nes
@@ -0,0 +1,163 @@
+#include "nes/common/band-limited-buffer.hh"
+#include "nes/common/debug.hh"
+#include "nes/common/utils.hh"
+
+namespace nes
+{
+	namespace
+	{
+		constexpr auto pi = 3.14159265358979323846;
+		constexpr auto cutoff = 0.9; // Relative to the Nyquist frequency of the output.
+		constexpr auto half_width = static_cast<i32>(band_limited_buffer::kernel_width / 2);
+
+		// There is no constexpr std::sin, so the kernel is computed using a Taylor series instead.
+		constexpr auto sine(double x) -> double
+		{
+			while (x > pi) { x -= 2 * pi; }
+			while (x < -pi) { x += 2 * pi; }
+
+			auto term = x;
+			auto res = x;
+			for (auto i = 1; i < 12; ++i)
+			{
+				term *= -x * x / ((2 * i) * (2 * i + 1));
+				res += term;
+			}
+			return res;
+		}
+
+		constexpr auto cosine(double const x) -> double
+		{
+			return sine(x + pi / 2);
+		}
+
+		struct kernel_table
+		{
+			i16 value[band_limited_buffer::kernel_phases][band_limited_buffer::kernel_width]{};
+		};
+
+		// Blackman-windowed sinc impulses for each fractional offset, normalized such that each phase sums up to
+		// exactly 1 << kernel_bits.
+		constexpr auto make_kernel_table() -> kernel_table
+		{
+			auto res = kernel_table{};
+			constexpr auto unity = i32{ 1 } << band_limited_buffer::kernel_bits;
+
+			for (auto phase = u32{ 0 }; phase < band_limited_buffer::kernel_phases; ++phase)
+			{
+				double taps[band_limited_buffer::kernel_width]{};
+				auto sum = 0.0;
+				for (auto tap = u32{ 0 }; tap < band_limited_buffer::kernel_width; ++tap)
+				{
+					auto const x = static_cast<double>(static_cast<i32>(tap) - half_width) -
+						static_cast<double>(phase) / band_limited_buffer::kernel_phases;
+					if (x <= -half_width || x >= half_width) { continue; }
+
+					auto const sinc = x == 0.0 ? 1.0 : sine(pi * cutoff * x) / (pi * cutoff * x);
+					auto const window = 0.42 + 0.5 * cosine(pi * x / half_width) + 0.08 * cosine(2 * pi * x / half_width);
+					taps[tap] = sinc * window;
+					sum += taps[tap];
+				}
+
+				auto total = i32{ 0 };
+				for (auto tap = u32{ 0 }; tap < band_limited_buffer::kernel_width; ++tap)
+				{
+					auto const scaled = taps[tap] / sum * unity;
+					auto const rounded = static_cast<i32>(scaled + (scaled >= 0.0 ? 0.5 : -0.5));
+					res.value[phase][tap] = static_cast<i16>(rounded);
+					total += rounded;
+				}
+				res.value[phase][half_width] = static_cast<i16>(res.value[phase][half_width] + unity - total);
+			}
+
+			return res;
+		}
+
+		constexpr auto kernel = make_kernel_table();
+	} // namespace
+
+	band_limited_buffer::band_limited_buffer(u64 const clock_rate, u32 const sample_rate)
+		: clock_rate_{ clock_rate }
+		, sample_rate_{ sample_rate }
+	{
+		set_rates(clock_rate, sample_rate);
+	}
+
+	auto band_limited_buffer::set_rates(u64 const clock_rate, u32 const sample_rate) -> void
+	{
+		NES_ASSERT(sample_rate < clock_rate && "the buffer can only downsample");
+		clock_rate_ = clock_rate;
+		sample_rate_ = sample_rate;
+		set_rate_adjustment(rate_adjustment_);
+	}
+
+	auto band_limited_buffer::set_rate_adjustment(i32 const ppm) -> void
+	{
+		rate_adjustment_ = ppm;
+		auto const factor = (u64{ sample_rate_ } << fraction_bits) / clock_rate_;
+		factor_ = static_cast<u64>(static_cast<i64>(factor) + static_cast<i64>(factor) * ppm / 1000000);
+	}
+
+	auto band_limited_buffer::reset(u64 const time) -> void
+	{
+		frame_time_ = time;
+		frame_position_ = 0;
+		samples_available_ = 0;
+		integrator_ = 0;
+		for (auto& sample : buffer_) { sample = 0; }
+	}
+
+	auto band_limited_buffer::add_delta(u64 const time, i32 const delta) -> void
+	{
+		if (delta == 0) { return; }
+
+		// Changes before the end of the last frame may have been read already, so this is the best we can do.
+		auto const position = frame_position_ + (time > frame_time_ ? (time - frame_time_) * factor_ : 0);
+		auto const index = position >> fraction_bits;
+		auto const phase = (position >> (fraction_bits - kernel_phase_bits)) & (kernel_phases - 1);
+		if (index >= max_samples) { return; }
+
+		// The kernel taps are truncated individually, the center tap absorbs the error so that the step amplitude
+		// after integrating is exact.
+		auto const& taps = kernel.value[phase];
+		auto* out = &buffer_[index];
+		auto total = i32{ 0 };
+		for (auto tap = u32{ 0 }; tap < kernel_width; ++tap)
+		{
+			auto const value = (delta * taps[tap]) >> (kernel_bits - accumulator_bits);
+			out[tap] += value;
+			total += value;
+		}
+		out[half_width] += delta * (1 << accumulator_bits) - total;
+	}
+
+	auto band_limited_buffer::end_frame(u64 const time) -> void
+	{
+		NES_ASSERT(time >= frame_time_ && "frames must not go back in time");
+
+		frame_position_ += (time - frame_time_) * factor_;
+		frame_time_ = time;
+		samples_available_ = static_cast<u32>(min(frame_position_ >> fraction_bits, u64{ max_samples }));
+	}
+
+	auto band_limited_buffer::read_samples(span<i16> const output) -> u32
+	{
+		auto const count = min(output.get_length(), samples_available_);
+		for (auto i = u32{ 0 }; i < count; ++i)
+		{
+			integrator_ += buffer_[i];
+			auto const value = integrator_ >> accumulator_bits;
+			output[i] = static_cast<i16>(max(min(value, i32{ 32767 }), i32{ -32768 }));
+			integrator_ -= integrator_ >> high_pass_shift;
+		}
+
+		// Move the remaining deltas (including those past the end of the frame) to the front.
+		auto const remaining = max_samples + kernel_width - count;
+		copy(&buffer_[count], &buffer_[0], remaining);
+		for (auto i = remaining; i < max_samples + kernel_width; ++i) { buffer_[i] = 0; }
+
+		samples_available_ -= count;
+		frame_position_ -= u64{ count } << fraction_bits;
+		return count;
+	}
+} // namespace nes
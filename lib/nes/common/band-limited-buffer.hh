@@ -0,0 +1,66 @@
+#pragma once
+
+#include "nes/common/containers/span.hh"
+#include "nes/common/types.hh"
+
+namespace nes
+{
+	/// Converts a signal given as amplitude changes at clock timestamps to output samples.
+	///
+	/// Instead of sampling the signal at the output rate (which aliases) or for every clock tick (which is expensive),
+	/// each amplitude change is added as a band-limited step using a precomputed windowed sinc kernel. The steps are
+	/// integrated when reading, which also applies a high-pass filter to remove the DC offset.
+	///
+	/// Timestamps are absolute clock ticks (e.g. CPU cycles) and must not decrease across calls to end_frame. The
+	/// sample rate can be adjusted slightly at any time, which allows following the speed of the audio device.
+	class band_limited_buffer
+	{
+	public:
+		static constexpr auto kernel_width = u32{ 16 };
+		static constexpr auto kernel_phase_bits = u32{ 6 };
+		static constexpr auto kernel_phases = u32{ 1 } << kernel_phase_bits;
+		static constexpr auto kernel_bits = u32{ 15 };
+		static constexpr auto max_samples = u32{ 4096 };
+
+	private:
+		static constexpr auto accumulator_bits = u32{ 8 }; // Extra precision of the buffered deltas.
+		static constexpr auto high_pass_shift = u32{ 9 };
+		static constexpr auto fraction_bits = u32{ 32 }; // Precision of sample positions.
+
+		u64 clock_rate_;
+		u32 sample_rate_;
+		i32 rate_adjustment_{ 0 };
+		u64 factor_{ 0 }; // Output samples per clock tick (fixed point).
+		u64 frame_time_{ 0 }; // Clock time at the end of the last frame.
+		u64 frame_position_{ 0 }; // Sample position of frame_time_ relative to the start of the buffer (fixed point).
+		u32 samples_available_{ 0 };
+		i32 integrator_{ 0 };
+		i32 buffer_[max_samples + kernel_width]{};
+
+	public:
+		explicit band_limited_buffer(u64 clock_rate, u32 sample_rate);
+
+		band_limited_buffer(band_limited_buffer const&) = delete;
+		band_limited_buffer(band_limited_buffer&&) = delete;
+		auto operator=(band_limited_buffer const&) -> band_limited_buffer& = delete;
+		auto operator=(band_limited_buffer&&) -> band_limited_buffer& = delete;
+
+		auto get_clock_rate() const -> u64 { return clock_rate_; }
+		auto get_sample_rate() const -> u32 { return sample_rate_; }
+		auto get_rate_adjustment() const -> i32 { return rate_adjustment_; }
+		auto get_samples_available() const -> u32 { return samples_available_; }
+
+		/// Change the clock and output sample rates, taking effect at the end of the last frame.
+		auto set_rates(u64 clock_rate, u32 sample_rate) -> void;
+		/// Speed up (positive) or slow down (negative) the output sample rate, in parts per million.
+		auto set_rate_adjustment(i32 ppm) -> void;
+		/// Drop all buffered samples and restart at the given clock time.
+		auto reset(u64 time) -> void;
+		/// Add an amplitude change at the given clock time. Changes beyond the buffer's capacity are dropped.
+		auto add_delta(u64 time, i32 delta) -> void;
+		/// Make all samples up to the given clock time available for reading.
+		auto end_frame(u64 time) -> void;
+		/// Read and remove up to output.get_length() samples, returning the number of samples read.
+		auto read_samples(span<i16> output) -> u32;
+	};
+} // namespace nes
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "nes/common/containers/span.hh"
+#include "nes/common/types.hh"
+#include "nes/common/utils.hh"
+
+namespace nes
+{
+	/// A fixed-size queue for passing values from one producer thread to one consumer thread.
+	///
+	/// Both sides are wait-free: writing and reading never block and only transfer as many elements as possible.
+	template<typename T, u32 Capacity>
+	class spsc_ring_buffer
+	{
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+		// The positions increase monotonically (wrapping around at 2^32) and are only masked when accessing the
+		// storage, which allows using the full capacity.
+		alignas(64) u32 write_position_{ 0 };
+		alignas(64) u32 read_position_{ 0 };
+		T storage_[Capacity]{};
+
+	public:
+		static constexpr auto capacity = Capacity;
+
+		explicit spsc_ring_buffer() = default;
+
+		spsc_ring_buffer(spsc_ring_buffer const&) = delete;
+		spsc_ring_buffer(spsc_ring_buffer&&) = delete;
+		auto operator=(spsc_ring_buffer const&) -> spsc_ring_buffer& = delete;
+		auto operator=(spsc_ring_buffer&&) -> spsc_ring_buffer& = delete;
+
+		/// Number of elements which can currently be read (only a snapshot if called from the producer).
+		auto get_size() const -> u32
+		{
+			auto const write = __atomic_load_n(&write_position_, __ATOMIC_ACQUIRE);
+			auto const read = __atomic_load_n(&read_position_, __ATOMIC_ACQUIRE);
+			return write - read;
+		}
+
+		/// Producer: append as many elements as fit, returning the number of elements written.
+		auto write(span<T const> const values) -> u32
+		{
+			auto const write = __atomic_load_n(&write_position_, __ATOMIC_RELAXED);
+			auto const read = __atomic_load_n(&read_position_, __ATOMIC_ACQUIRE);
+			auto const count = min(values.get_length(), Capacity - (write - read));
+			for (auto i = u32{ 0 }; i < count; ++i)
+			{
+				storage_[(write + i) & (Capacity - 1)] = values[i];
+			}
+			__atomic_store_n(&write_position_, write + count, __ATOMIC_RELEASE);
+			return count;
+		}
+
+		/// Producer: append a single element, returning false if the buffer is full.
+		auto push(T const& value) -> bool
+		{
+			return write(span<T const>{ &value, 1 }) == 1;
+		}
+
+		/// Consumer: remove as many elements as available, returning the number of elements read.
+		auto read(span<T> const values) -> u32
+		{
+			auto const read = __atomic_load_n(&read_position_, __ATOMIC_RELAXED);
+			auto const write = __atomic_load_n(&write_position_, __ATOMIC_ACQUIRE);
+			auto const count = min(values.get_length(), write - read);
+			for (auto i = u32{ 0 }; i < count; ++i)
+			{
+				values[i] = storage_[(read + i) & (Capacity - 1)];
+			}
+			__atomic_store_n(&read_position_, read + count, __ATOMIC_RELEASE);
+			return count;
+		}
+
+		/// Consumer: remove a single element, returning false if the buffer is empty.
+		auto pop(T& value) -> bool
+		{
+			return read(span<T>{ &value, 1 }) == 1;
+		}
+	};
+} // namespace nes
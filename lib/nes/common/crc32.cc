@@ -0,0 +1,75 @@
+#include "nes/common/crc32.hh"
+
+namespace nes
+{
+	namespace
+	{
+		constexpr auto polynomial = u32{ 0xEDB88320 };
+		constexpr auto slice_count = u32{ 8 };
+
+		struct lookup_tables
+		{
+			u32 value[slice_count][256]{};
+
+			constexpr lookup_tables()
+			{
+				for (auto i = u32{ 0 }; i < 256; ++i)
+				{
+					auto crc = i;
+					for (auto bit = u32{ 0 }; bit < 8; ++bit) { crc = (crc >> 1) ^ ((crc & 1) ? polynomial : 0); }
+					value[0][i] = crc;
+				}
+
+				// Table n advances the CRC of a byte followed by n zero bytes.
+				for (auto n = u32{ 1 }; n < slice_count; ++n)
+				{
+					for (auto i = u32{ 0 }; i < 256; ++i)
+					{
+						value[n][i] = (value[n - 1][i] >> 8) ^ value[0][value[n - 1][i] & 0xFF];
+					}
+				}
+			}
+		};
+
+		constexpr auto tables = lookup_tables{};
+	} // namespace
+
+	auto crc32::hash(span<u8 const> const data) -> u32
+	{
+		auto res = crc32{};
+		res.update(data);
+		return res.get_value();
+	}
+
+	auto crc32::update(span<u8 const> const data) -> void
+	{
+		// Slicing-by-8: process 8 bytes per iteration using one table lookup per byte, without a dependency chain
+		// between the lookups.
+		// See: https://create.stephan-brumme.com/crc32/#slicing-by-8-overview
+
+		auto const t = tables.value;
+		auto crc = state_;
+		auto p = data.get_data();
+		auto length = data.get_length();
+
+		while (length >= slice_count)
+		{
+			auto const low = crc ^ static_cast<u32>(p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24));
+			auto const high = static_cast<u32>(p[4] | (p[5] << 8) | (p[6] << 16) | (p[7] << 24));
+			crc =
+				t[7][(low >> 0) & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][(low >> 24) & 0xFF] ^
+				t[3][(high >> 0) & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][(high >> 24) & 0xFF];
+			p += slice_count;
+			length -= slice_count;
+		}
+
+		while (length > 0)
+		{
+			crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xFF];
+			p += 1;
+			length -= 1;
+		}
+
+		state_ = crc;
+	}
+} // namespace nes
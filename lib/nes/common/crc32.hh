@@ -0,0 +1,21 @@
+#pragma once
+
+#include "nes/common/containers/span.hh"
+#include "nes/common/types.hh"
+
+namespace nes
+{
+	/// Streaming CRC-32 (IEEE 802.3, as used by zip and most ROM databases).
+	class crc32
+	{
+		u32 state_{ 0xFFFFFFFF };
+
+	public:
+		explicit crc32() = default;
+
+		static auto hash(span<u8 const>) -> u32;
+
+		auto update(span<u8 const>) -> void;
+		auto get_value() const -> u32 { return ~state_; }
+	};
+} // namespace nes
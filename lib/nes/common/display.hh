@@ -23,10 +23,25 @@ namespace nes
 
 		/// Switch between front and back buffers.
 		virtual auto switch_buffers() -> void = 0;
+		/// Called after the last pixel of a visible line (0-239) has been drawn (even while rendering is disabled), so that
+		/// completed lines can be presented before the whole frame is complete.
+		virtual auto end_scanline(u32) -> void {}
 		/// Update the pixel at the given position in the back buffer.
 		virtual auto set(u32 x, u32 y, rgb value) -> void = 0;
+		/// Update the pixel at the given position in the back buffer using its index (0-63) in the console's palette
+		/// (bits 0-5) and the emphasis bits of PPUMASK (bits 6-8). This is called instead of set for indexed displays.
+		virtual auto set_index(u32, u32, u16) -> void {}
+
+		/// Whether the console passes palette indices (set_index) instead of RGB values (set).
+		auto is_indexed() const -> bool { return indexed_; }
 
 	protected:
-		explicit display() = default;
+		explicit display(bool const indexed = false)
+			: indexed_{ indexed }
+		{
+		}
+
+	private:
+		bool indexed_;
 	};
 } // namespace nes
\ No newline at end of file
@@ -0,0 +1,406 @@
+#include "nes/common/frame-codec.hh"
+#include "nes/common/utils.hh"
+
+namespace nes::frame_codec
+{
+	namespace
+	{
+		enum class command : u8
+		{
+			skip = 0,
+			repeat = 1,
+			literal = 2,
+			copy = 3,
+		};
+
+		constexpr auto short_length_count = u32{ 63 };
+		// Shorter runs of equal pixels are cheaper as part of a literal.
+		constexpr auto min_repeat_length = u32{ 3 };
+		constexpr auto min_copy_length = u32{ 4 };
+		// Largest motion (in pixels per frame, in both directions) found by the search. Most games scroll by a few
+		// pixels per frame at most.
+		constexpr auto max_motion = u32{ 8 };
+		constexpr auto motion_range = 2 * max_motion + 1;
+		// Only every few pixels are compared while searching, which finds the motion of all but very small areas.
+		constexpr auto search_row_step = u32{ 8 };
+		constexpr auto search_column_step = u32{ 4 };
+		// Number of motions (besides none) each row can choose from, e.g. for a playfield and a status bar scrolling
+		// separately.
+		constexpr auto motion_candidate_count = u32{ 2 };
+
+		constexpr auto width = display::width;
+		constexpr auto height = display::height;
+
+		static_assert(pixel_count <= 0xFFFF);
+		static_assert(sizeof(file_header) == 20);
+		static_assert(sizeof(frame_header) == 8);
+
+		/// Offset of the pixels in the previous frame which are copied.
+		struct motion
+		{
+			i32 x{ 0 };
+			i32 y{ 0 };
+
+			auto is_none() const -> bool { return x == 0 && y == 0; }
+
+			/// Whether the source of the pixel at the given position is within the frame.
+			auto is_in_frame(u32 const px, u32 const py) const -> bool
+			{
+				auto const sx = static_cast<i32>(px) + x;
+				auto const sy = static_cast<i32>(py) + y;
+				return sx >= 0 && sx < static_cast<i32>(width) && sy >= 0 && sy < static_cast<i32>(height);
+			}
+
+			/// Index of the source of the pixel with the given index (which must be in the frame).
+			auto get_source(u32 const i) const -> u32
+			{
+				return static_cast<u32>(static_cast<i32>(i) + y * static_cast<i32>(width) + x);
+			}
+		};
+
+		class writer
+		{
+			u8* target_;
+			u32 position_{ 0 };
+
+		public:
+			explicit writer(u8* target)
+				: target_{ target }
+			{
+			}
+
+			auto get_position() const -> u32 { return position_; }
+
+			auto write_command(command const c, u32 const length) -> void
+			{
+				auto const kind = static_cast<u32>(c) << 6;
+				if (length <= short_length_count)
+				{
+					target_[position_++] = static_cast<u8>(kind | (length - 1));
+				}
+				else
+				{
+					target_[position_++] = static_cast<u8>(kind | short_length_count);
+					target_[position_++] = static_cast<u8>(length);
+					target_[position_++] = static_cast<u8>(length >> 8);
+				}
+			}
+
+			auto write_motion(motion const m) -> void
+			{
+				target_[position_++] = static_cast<u8>(m.x);
+				target_[position_++] = static_cast<u8>(m.y);
+			}
+
+			auto write_pixel(u16 const pixel) -> void
+			{
+				if (pixel < 0x80)
+				{
+					target_[position_++] = static_cast<u8>(pixel);
+				}
+				else
+				{
+					target_[position_++] = static_cast<u8>(0x80 | (pixel >> 8));
+					target_[position_++] = static_cast<u8>(pixel);
+				}
+			}
+		};
+
+		class reader
+		{
+			u8 const* data_;
+			u32 size_;
+			u32 position_{ 0 };
+
+		public:
+			explicit reader(u8 const* data, u32 const size)
+				: data_{ data }
+				, size_{ size }
+			{
+			}
+
+			auto is_done() const -> bool { return position_ == size_; }
+
+			auto read_byte(u8& result) -> bool
+			{
+				if (position_ == size_) { return false; }
+
+				result = data_[position_++];
+				return true;
+			}
+
+			auto read_command(u8& kind, u32& length) -> bool
+			{
+				auto first = u8{};
+				if (!read_byte(first)) { return false; }
+
+				kind = static_cast<u8>(first >> 6);
+				length = (first & 0x3F) + u32{ 1 };
+				if (length <= short_length_count) { return true; }
+
+				auto low = u8{};
+				auto high = u8{};
+				if (!read_byte(low) || !read_byte(high)) { return false; }
+
+				length = low | (high << 8);
+				return length > short_length_count;
+			}
+
+			auto read_motion(motion& result) -> bool
+			{
+				auto x = u8{};
+				auto y = u8{};
+				if (!read_byte(x) || !read_byte(y)) { return false; }
+
+				result = motion{ static_cast<i8>(x), static_cast<i8>(y) };
+				return true;
+			}
+
+			auto read_pixel(u16& result) -> bool
+			{
+				auto first = u8{};
+				if (!read_byte(first)) { return false; }
+				if (first < 0x80)
+				{
+					result = first;
+					return true;
+				}
+
+				auto second = u8{};
+				if (!read_byte(second)) { return false; }
+
+				result = static_cast<u16>(((first & 0x7F) << 8) | second);
+				return true;
+			}
+		};
+
+		/// Find the motions which match the most samples of the frame against the previous one, ordered by the number of
+		/// matches (unused candidates are none).
+		auto find_motions(u16 const* current, u16 const* last, motion (&result)[motion_candidate_count]) -> void
+		{
+			u32 matches[motion_range][motion_range]{};
+			auto static_frame = true;
+			for (auto y = max_motion; y < height - max_motion; y += search_row_step)
+			{
+				for (auto x = max_motion; x < width - max_motion; x += search_column_step)
+				{
+					auto const pixel = current[y * width + x];
+					static_frame = static_frame && pixel == last[y * width + x];
+					for (auto my = u32{ 0 }; my < motion_range; ++my)
+					{
+						auto const* row = last + (y + my - max_motion) * width + x - max_motion;
+						for (auto mx = u32{ 0 }; mx < motion_range; ++mx) { matches[my][mx] += row[mx] == pixel; }
+					}
+				}
+			}
+
+			for (auto& m : result) { m = motion{}; }
+			if (static_frame) { return; }
+
+			u32 best[motion_candidate_count]{};
+			auto const offset = static_cast<i32>(max_motion);
+			for (auto my = u32{ 0 }; my < motion_range; ++my)
+			{
+				for (auto mx = u32{ 0 }; mx < motion_range; ++mx)
+				{
+					auto const m = motion{ static_cast<i32>(mx) - offset, static_cast<i32>(my) - offset };
+					auto count = matches[my][mx];
+					if (m.is_none() || count == 0) { continue; }
+
+					// Insert into the sorted candidates.
+					for (auto i = u32{ 0 }; i < motion_candidate_count; ++i)
+					{
+						if (count <= best[i]) { continue; }
+
+						auto candidate = m;
+						swap(best[i], count);
+						swap(result[i], candidate);
+						for (auto j = i + 1; j < motion_candidate_count; ++j)
+						{
+							swap(best[j], count);
+							swap(result[j], candidate);
+						}
+						break;
+					}
+				}
+			}
+		}
+
+		/// Choose the candidate (or none) which matches the most pixels of the row.
+		auto choose_row_motion(
+			u16 const* current, u16 const* last, u32 const y, motion const (&candidates)[motion_candidate_count])
+			-> motion
+		{
+			auto const count_matches = [&](motion const m)
+			{
+				auto res = u32{ 0 };
+				for (auto x = u32{ 0 }; x < width; ++x)
+				{
+					auto const i = y * width + x;
+					res += m.is_in_frame(x, y) && current[i] == last[m.get_source(i)];
+				}
+				return res;
+			};
+
+			auto res = motion{};
+			auto best = count_matches(res);
+			for (auto const& m : candidates)
+			{
+				if (m.is_none()) { continue; }
+
+				if (auto const count = count_matches(m); count > best)
+				{
+					res = m;
+					best = count;
+				}
+			}
+			return res;
+		}
+	} // namespace
+
+	auto encode(span<u16 const, pixel_count> const frame, span<u16 const, pixel_count> const previous, u8* const target)
+		-> u32
+	{
+		auto const* const current = frame.get_data();
+		auto const* const last = previous.get_data();
+		auto w = writer{ target };
+
+		// Scrolling moves most pixels without changing them, which is coded by copying them from the previous frame
+		// (with the motion chosen for each row).
+		motion candidates[motion_candidate_count]{};
+		find_motions(current, last, candidates);
+		motion row_motions[height]{};
+		if (!candidates[0].is_none())
+		{
+			for (auto y = u32{ 0 }; y < height; ++y)
+			{
+				row_motions[y] = choose_row_motion(current, last, y, candidates);
+			}
+		}
+
+		auto const starts_repeat = [&](u32 const i)
+		{
+			return i + min_repeat_length <= pixel_count && current[i] == current[i + 1] && current[i] == current[i + 2];
+		};
+		auto const is_copied = [&](u32 const i)
+		{
+			auto const m = row_motions[i / width];
+			return !m.is_none() && m.is_in_frame(i % width, i / width) && current[i] == last[m.get_source(i)];
+		};
+		// Copies stay within their row.
+		auto const get_copy_length = [&](u32 const i)
+		{
+			auto const row_end = (i / width + 1) * width;
+			auto end = i;
+			while (end < row_end && is_copied(end)) { ++end; }
+			return end - i;
+		};
+		auto const get_skip_length = [&](u32 const i)
+		{
+			auto end = i;
+			while (end < pixel_count && current[end] == last[end]) { ++end; }
+			return end - i;
+		};
+
+		auto i = u32{ 0 };
+		while (i < pixel_count)
+		{
+			auto end = i + 1;
+			auto const skip_length = get_skip_length(i);
+			auto const copy_length = get_copy_length(i);
+			if (copy_length >= min_copy_length && copy_length > skip_length)
+			{
+				end = i + copy_length;
+				w.write_command(command::copy, copy_length);
+				w.write_motion(row_motions[i / width]);
+			}
+			else if (skip_length > 0)
+			{
+				end = i + skip_length;
+				// Unchanged pixels at the end of the frame are implied.
+				if (end == pixel_count) { break; }
+
+				w.write_command(command::skip, skip_length);
+			}
+			else if (starts_repeat(i))
+			{
+				// The run may also cover unchanged pixels, e.g. when a plain background scrolls.
+				while (end < pixel_count && current[end] == current[i]) { ++end; }
+				w.write_command(command::repeat, end - i);
+				w.write_pixel(current[i]);
+			}
+			else
+			{
+				while (end < pixel_count && current[end] != last[end] && !starts_repeat(end) &&
+					get_copy_length(end) < min_copy_length)
+				{
+					++end;
+				}
+				w.write_command(command::literal, end - i);
+				for (auto j = i; j < end; ++j) { w.write_pixel(current[j]); }
+			}
+
+			i = end;
+		}
+
+		NES_ASSERT(w.get_position() <= max_encoded_size && "encoded frame exceeds the size limit");
+		return w.get_position();
+	}
+
+	auto decode(
+		u8 const* const data, u32 const size, span<u16 const, pixel_count> const previous,
+		span<u16, pixel_count> const frame) -> status
+	{
+		NES_ASSERT(previous.get_data() != frame.get_data() && "frames must not overlap");
+
+		auto const* const last = previous.get_data();
+		auto* const pixels = frame.get_data();
+		auto r = reader{ data, size };
+		auto i = u32{ 0 };
+		while (!r.is_done())
+		{
+			auto kind = u8{};
+			auto length = u32{};
+			if (!r.read_command(kind, length) || length > pixel_count - i) { return status::error_invalid_capture; }
+
+			auto pixel = u16{};
+			auto m = motion{};
+			switch (kind)
+			{
+				case static_cast<u8>(command::skip):
+					for (auto j = i; j < i + length; ++j) { pixels[j] = last[j]; }
+					break;
+
+				case static_cast<u8>(command::repeat):
+					if (!r.read_pixel(pixel)) { return status::error_invalid_capture; }
+					for (auto j = i; j < i + length; ++j) { pixels[j] = pixel; }
+					break;
+
+				case static_cast<u8>(command::literal):
+					for (auto j = i; j < i + length; ++j)
+					{
+						if (!r.read_pixel(pixel)) { return status::error_invalid_capture; }
+						pixels[j] = pixel;
+					}
+					break;
+
+				case static_cast<u8>(command::copy):
+					if (!r.read_motion(m)) { return status::error_invalid_capture; }
+					for (auto j = i; j < i + length; ++j)
+					{
+						if (!m.is_in_frame(j % width, j / width)) { return status::error_invalid_capture; }
+						pixels[j] = last[m.get_source(j)];
+					}
+					break;
+
+				default:
+					return status::error_invalid_capture;
+			}
+
+			i += length;
+		}
+
+		for (; i < pixel_count; ++i) { pixels[i] = last[i]; }
+		return status::success;
+	}
+} // namespace nes::frame_codec
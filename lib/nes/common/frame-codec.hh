@@ -0,0 +1,53 @@
+#pragma once
+
+#include "nes/common/containers/span.hh"
+#include "nes/common/display.hh"
+#include "nes/common/status.hh"
+#include "nes/common/types.hh"
+
+namespace nes
+{
+	/// Lossless compression for recording the video output of the console, using the raw pixels of indexed displays
+	/// (palette index and emphasis bits, see display::set_index).
+	///
+	/// Each frame is coded against the previous one as a sequence of commands. A command starts with a byte containing
+	/// its kind (bits 6-7) and its length in pixels minus one (bits 0-5), where 63 means that the length follows as u16.
+	/// Commands either skip pixels which did not change, repeat a single pixel, contain literal pixels or copy pixels
+	/// from the previous frame at an offset (following as two i8, x and y), which codes scrolling. Pixels take one byte
+	/// if they are below 0x80 and two bytes (big endian, with bit 7 set) otherwise. Pixels after the last command did
+	/// not change. Key frames are coded against a frame of zeros (palette entry $00, which is grey, without emphasis),
+	/// so decoding can start there.
+	///
+	/// A capture file consists of a header followed by the frames, each with its own header. Like save states, the
+	/// format is specific to the host.
+	namespace frame_codec
+	{
+		inline constexpr auto pixel_count = u32{ display::width * display::height };
+		/// Upper bound for the size of an encoded frame.
+		inline constexpr auto max_encoded_size = u32{ 3 * pixel_count };
+		inline constexpr auto file_magic = u32{ 0x5645534E }; // "NESV"
+		inline constexpr auto file_version = u32{ 2 };
+		inline constexpr auto key_frame_flag = u32{ 1 << 0 };
+
+		struct file_header
+		{
+			u32 magic;
+			u32 version;
+			u32 width;
+			u32 height;
+			u32 frame_count; // Only written when the capture is closed, 0 otherwise.
+		};
+
+		struct frame_header
+		{
+			u32 size; // Size of the encoded frame following the header.
+			u32 flags;
+		};
+
+		/// Encode a frame into the target (which must hold max_encoded_size bytes) and return the encoded size.
+		auto encode(span<u16 const, pixel_count> frame, span<u16 const, pixel_count> previous, u8* target) -> u32;
+		/// Decode a frame by applying it to the previous frame (or zeros for key frames) in a separate buffer.
+		auto decode(u8 const* data, u32 size, span<u16 const, pixel_count> previous, span<u16, pixel_count> frame)
+			-> status;
+	} // namespace frame_codec
+} // namespace nes
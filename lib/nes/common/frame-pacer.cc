@@ -0,0 +1,68 @@
+#include "nes/common/frame-pacer.hh"
+#include "nes/common/utils.hh"
+
+namespace nes
+{
+	frame_pacer::frame_pacer(u32 const max_frames_behind)
+		: max_frames_behind_{ max(max_frames_behind, u32{ 1 }) }
+	{
+	}
+
+	auto frame_pacer::sync_to_display(u64 const refresh_period_ns) -> bool
+	{
+		auto const difference = refresh_period_ns > console_period_ns
+			? refresh_period_ns - console_period_ns
+			: console_period_ns - refresh_period_ns;
+		period_ns_ = difference * 1000000 <= console_period_ns * display_tolerance_ppm
+			? refresh_period_ns
+			: console_period_ns;
+		return is_synced_to_display();
+	}
+
+	auto frame_pacer::advance(u64 const elapsed_ns) -> u32
+	{
+		auto const bucket = min(static_cast<u32>(elapsed_ns / histogram_bucket_ns), histogram_bucket_count - 1);
+		histogram_[bucket] += 1;
+		histogram_count_ += 1;
+		max_frame_time_ns_ = max(max_frame_time_ns_, elapsed_ns);
+
+		auto const period = static_cast<i64>(period_ns_);
+		auto const max_pending = static_cast<i64>(max_frames_behind_) * period;
+		pending_ns_ += static_cast<i64>(min(elapsed_ns, u64{ 1000000000 }));
+		if (pending_ns_ > max_pending)
+		{
+			dropped_frames_ += static_cast<u64>((pending_ns_ - max_pending) / period);
+			pending_ns_ = max_pending;
+		}
+
+		// When synchronized to the display, calls are expected once per period, so rounding absorbs the jitter.
+		auto const threshold = is_synced_to_display() ? period / 2 : i64{ 0 };
+		auto const frames = pending_ns_ + threshold >= period ? (pending_ns_ + threshold) / period : i64{ 0 };
+		pending_ns_ -= frames * period;
+
+		// Each frame emulates a frame of the console, even if the display's period is used.
+		auto const emulation_ns = static_cast<u64>(frames) * console_period_ns + remainder_ns_;
+		remainder_ns_ = emulation_ns % 1000;
+		return static_cast<u32>(emulation_ns / 1000);
+	}
+
+	auto frame_pacer::get_time_until_next_frame_ns() const -> u64
+	{
+		auto const period = static_cast<i64>(period_ns_);
+		auto const threshold = is_synced_to_display() ? period - period / 2 : period;
+		return pending_ns_ >= threshold ? 0 : static_cast<u64>(threshold - pending_ns_);
+	}
+
+	auto frame_pacer::get_frame_time_percentile_ns(u32 const percent) const -> u64
+	{
+		auto const target = (histogram_count_ * min(percent, u32{ 100 }) + 99) / 100;
+		auto count = u64{ 0 };
+		for (auto i = u32{ 0 }; i < histogram_bucket_count; ++i)
+		{
+			count += histogram_[i];
+			if (count >= target && count > 0) { return (i + 1) * histogram_bucket_ns; }
+		}
+
+		return 0;
+	}
+} // namespace nes
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "nes/common/types.hh"
+
+namespace nes
+{
+	/// Converts the host's elapsed time into emulation time, advancing in whole frames at the console's rate.
+	///
+	/// Time which has not been emulated yet (including fractions of a microsecond) is carried over to the next call, so
+	/// the emulation does not drift from the host clock. After a stall, at most a few frames are caught up and the rest
+	/// is dropped, so that a slow host does not fall further behind with every frame.
+	class frame_pacer
+	{
+	public:
+		/// One frame of the NTSC console (60.0988 Hz).
+		static constexpr auto console_period_ns = u64{ 16639267 };
+		/// Displays with a refresh period within this tolerance (in ppm) of the console's can be synchronized to.
+		static constexpr auto display_tolerance_ppm = u64{ 5000 };
+		static constexpr auto histogram_bucket_count = u32{ 64 };
+		static constexpr auto histogram_bucket_ns = u64{ 500000 };
+
+	private:
+		u64 period_ns_{ console_period_ns };
+		u32 max_frames_behind_;
+		i64 pending_ns_{ 0 }; // Host time not emulated yet (negative if ahead when synchronized to the display).
+		u64 remainder_ns_{ 0 }; // Emulation time below one microsecond.
+		u64 dropped_frames_{ 0 };
+		u32 histogram_[histogram_bucket_count]{};
+		u64 histogram_count_{ 0 };
+		u64 max_frame_time_ns_{ 0 };
+
+	public:
+		explicit frame_pacer(u32 max_frames_behind = 4);
+
+		/// Run one frame per refresh of the display if its refresh period is close enough to the console's, which
+		/// avoids regularly repeated or skipped frames at the cost of running slightly too fast or slow. Returns whether
+		/// the display is used, in which case advance needs to be called on each refresh (e.g. after presenting with
+		/// vsync) instead of after get_time_until_next_frame_ns.
+		auto sync_to_display(u64 refresh_period_ns) -> bool;
+		auto is_synced_to_display() const -> bool { return period_ns_ != console_period_ns; }
+
+		/// Account for the host time elapsed since the last call and return the time to emulate (in microseconds).
+		auto advance(u64 elapsed_ns) -> u32;
+		/// Host time until the next frame is due.
+		auto get_time_until_next_frame_ns() const -> u64;
+
+		/// Number of frames which were not emulated because the host could not keep up.
+		auto get_dropped_frames() const -> u64 { return dropped_frames_; }
+		/// Number of calls to advance recorded in the frame time histogram.
+		auto get_frame_count() const -> u64 { return histogram_count_; }
+		auto get_max_frame_time_ns() const -> u64 { return max_frame_time_ns_; }
+		/// Upper bound of the given percentile of the time between calls to advance (at histogram resolution).
+		auto get_frame_time_percentile_ns(u32 percent) const -> u64;
+	};
+} // namespace nes
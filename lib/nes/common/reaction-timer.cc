@@ -0,0 +1,49 @@
+#include "nes/common/reaction-timer.hh"
+
+namespace nes
+{
+	auto reaction_timer::input(u32 const buttons) -> void
+	{
+		if (buttons == input_) { return; }
+
+		input_ = buttons;
+		if (!measuring_ && still_frames_ >= still_frames_needed)
+		{
+			measuring_ = true;
+			elapsed_us_ = 0;
+		}
+	}
+
+	auto reaction_timer::elapse(u32 const elapsed_time_us) -> void
+	{
+		if (!measuring_) { return; }
+
+		elapsed_us_ += elapsed_time_us;
+		if (elapsed_us_ >= timeout_us) { measuring_ = false; }
+	}
+
+	auto reaction_timer::present(u64 const picture) -> void
+	{
+		if (picture == last_picture_)
+		{
+			still_frames_ += 1;
+			return;
+		}
+
+		if (measuring_)
+		{
+			reactions_ += 1;
+			reaction_time_us_ += elapsed_us_;
+			measuring_ = false;
+		}
+		last_picture_ = picture;
+		still_frames_ = 0;
+	}
+
+	auto reaction_timer::reset() -> void
+	{
+		last_picture_ = 0;
+		still_frames_ = 0;
+		measuring_ = false;
+	}
+} // namespace nes
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "nes/common/types.hh"
+
+namespace nes
+{
+	/// Measures the time from a change of the input until the presented picture changes (the game's reaction).
+	///
+	/// Only changes of the input while the picture is still are measured, otherwise an animation would be taken for
+	/// the reaction. Inputs without a visible reaction are dropped after a timeout.
+	class reaction_timer
+	{
+		static constexpr auto still_frames_needed = u32{ 2 };
+		static constexpr auto timeout_us = u32{ 500000 };
+
+		u64 last_picture_{ 0 }; // Hash of the last presented picture.
+		u32 still_frames_{ 0 }; // Number of presented frames since the picture last changed.
+		u32 input_{ 0 };
+		bool measuring_{ false };
+		u32 elapsed_us_{ 0 }; // Time since the input changed while measuring.
+		u64 reactions_{ 0 };
+		u64 reaction_time_us_{ 0 };
+
+	public:
+		explicit reaction_timer() = default;
+
+		/// Starts a measurement if the input changed.
+		auto input(u32 buttons) -> void;
+		auto elapse(u32 elapsed_time_us) -> void;
+		/// Ends a measurement if the picture (given as a hash) changed.
+		auto present(u64 picture) -> void;
+		/// Forgets the picture and any measurement in progress (e.g. when the game changes).
+		auto reset() -> void;
+
+		auto get_reactions() const -> u64 { return reactions_; }
+		auto get_reaction_time_us() const -> u64 { return reaction_time_us_; }
+	};
+} // namespace nes
@@ -14,6 +14,9 @@ namespace nes
 		error_invalid_path,
 		error_invalid_format_string,
 		error_unknown_file_type,
+		error_invalid_save_state,
+		error_invalid_movie,
+		error_invalid_capture,
 	};
 
 	constexpr auto to_string(status const status) -> char const*
@@ -38,6 +41,12 @@ namespace nes
 				return "Invalid format string";
 			case status::error_unknown_file_type:
 				return "Unknown file type";
+			case status::error_invalid_save_state:
+				return "Invalid save state";
+			case status::error_invalid_movie:
+				return "Invalid movie";
+			case status::error_invalid_capture:
+				return "Invalid capture";
 		}
 
 		return "(invalid)";
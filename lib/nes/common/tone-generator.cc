@@ -0,0 +1,22 @@
+#include "nes/common/tone-generator.hh"
+
+namespace nes
+{
+	tone_generator::tone_generator(u32 const sample_rate, u32 const frequency, i16 const amplitude)
+		: increment_{ static_cast<u32>((u64{ frequency } << 32) / sample_rate) }
+		, amplitude_{ amplitude }
+	{
+	}
+
+	auto tone_generator::generate(span<i16> const output) -> void
+	{
+		for (auto& sample : output)
+		{
+			// Map the phase to a triangle between -amplitude and amplitude.
+			auto const position = static_cast<i64>(phase_ >> 16); // 0 - 65535
+			auto const triangle = position < 32768 ? position * 2 - 32768 : 98303 - position * 2;
+			sample = static_cast<i16>(triangle * amplitude_ / 32768);
+			phase_ += increment_;
+		}
+	}
+} // namespace nes
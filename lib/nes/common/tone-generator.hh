@@ -0,0 +1,20 @@
+#pragma once
+
+#include "nes/common/containers/span.hh"
+#include "nes/common/types.hh"
+
+namespace nes
+{
+	/// Generates a triangle wave, useful for testing audio outputs without running a game.
+	class tone_generator
+	{
+		u32 phase_{ 0 };
+		u32 increment_;
+		i16 amplitude_;
+
+	public:
+		explicit tone_generator(u32 sample_rate, u32 frequency, i16 amplitude);
+
+		auto generate(span<i16> output) -> void;
+	};
+} // namespace nes
@@ -0,0 +1,322 @@
+#include "nes/common/xxh3.hh"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace nes
+{
+	namespace
+	{
+		// See: https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+
+		constexpr auto prime32_1 = u64{ 0x9E3779B1 };
+		constexpr auto prime32_2 = u64{ 0x85EBCA77 };
+		constexpr auto prime32_3 = u64{ 0xC2B2AE3D };
+		constexpr auto prime64_1 = u64{ 0x9E3779B185EBCA87 };
+		constexpr auto prime64_2 = u64{ 0xC2B2AE3D27D4EB4F };
+		constexpr auto prime64_3 = u64{ 0x165667B19E3779F9 };
+		constexpr auto prime64_4 = u64{ 0x85EBCA77C2B2AE63 };
+		constexpr auto prime64_5 = u64{ 0x27D4EB2F165667C5 };
+		constexpr auto prime_mx1 = u64{ 0x165667919E3779F9 };
+		constexpr auto prime_mx2 = u64{ 0x9FB21C651E98DF25 };
+
+		constexpr auto stripe_size = u32{ 64 };
+		constexpr auto secret_size = u32{ 192 };
+		constexpr auto stripes_per_block = (secret_size - stripe_size) / 8;
+		constexpr auto max_midsize_length = u32{ 240 };
+
+		alignas(8) constexpr u8 secret[secret_size]
+		{
+			0xB8, 0xFE, 0x6C, 0x39, 0x23, 0xA4, 0x4B, 0xBE, 0x7C, 0x01, 0x81, 0x2C, 0xF7, 0x21, 0xAD, 0x1C,
+			0xDE, 0xD4, 0x6D, 0xE9, 0x83, 0x90, 0x97, 0xDB, 0x72, 0x40, 0xA4, 0xA4, 0xB7, 0xB3, 0x67, 0x1F,
+			0xCB, 0x79, 0xE6, 0x4E, 0xCC, 0xC0, 0xE5, 0x78, 0x82, 0x5A, 0xD0, 0x7D, 0xCC, 0xFF, 0x72, 0x21,
+			0xB8, 0x08, 0x46, 0x74, 0xF7, 0x43, 0x24, 0x8E, 0xE0, 0x35, 0x90, 0xE6, 0x81, 0x3A, 0x26, 0x4C,
+			0x3C, 0x28, 0x52, 0xBB, 0x91, 0xC3, 0x00, 0xCB, 0x88, 0xD0, 0x65, 0x8B, 0x1B, 0x53, 0x2E, 0xA3,
+			0x71, 0x64, 0x48, 0x97, 0xA2, 0x0D, 0xF9, 0x4E, 0x38, 0x19, 0xEF, 0x46, 0xA9, 0xDE, 0xAC, 0xD8,
+			0xA8, 0xFA, 0x76, 0x3F, 0xE3, 0x9C, 0x34, 0x3F, 0xF9, 0xDC, 0xBB, 0xC7, 0xC7, 0x0B, 0x4F, 0x1D,
+			0x8A, 0x51, 0xE0, 0x4B, 0xCD, 0xB4, 0x59, 0x31, 0xC8, 0x9F, 0x7E, 0xC9, 0xD9, 0x78, 0x73, 0x64,
+			0xEA, 0xC5, 0xAC, 0x83, 0x34, 0xD3, 0xEB, 0xC3, 0xC5, 0x81, 0xA0, 0xFF, 0xFA, 0x13, 0x63, 0xEB,
+			0x17, 0x0D, 0xDD, 0x51, 0xB7, 0xF0, 0xDA, 0x49, 0xD3, 0x16, 0x55, 0x26, 0x29, 0xD4, 0x68, 0x9E,
+			0x2B, 0x16, 0xBE, 0x58, 0x7D, 0x47, 0xA1, 0xFC, 0x8F, 0xF8, 0xB8, 0xD1, 0x7A, 0xD0, 0x31, 0xCE,
+			0x45, 0xCB, 0x3A, 0x8F, 0x95, 0x16, 0x04, 0x28, 0xAF, 0xD7, 0xFB, 0xCA, 0xBB, 0x4B, 0x40, 0x7E,
+		};
+
+		// The hash is defined on little endian words, independent of the host.
+		auto read_u64(u8 const* const p) -> u64
+		{
+			auto res = u64{ 0 };
+			__builtin_memcpy(&res, p, sizeof(res));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			res = __builtin_bswap64(res);
+#endif
+			return res;
+		}
+
+		auto read_u32(u8 const* const p) -> u64
+		{
+			auto res = u32{ 0 };
+			__builtin_memcpy(&res, p, sizeof(res));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			res = __builtin_bswap32(res);
+#endif
+			return res;
+		}
+
+		auto rotate_left(u64 const value, u32 const amount) -> u64
+		{
+			return (value << amount) | (value >> (64 - amount));
+		}
+
+		/// Multiply into 128 bits and XOR the halves.
+		auto multiply_fold(u64 const a, u64 const b) -> u64
+		{
+#if defined(__SIZEOF_INT128__)
+			__extension__ using u128 = unsigned __int128;
+			auto const product = static_cast<u128>(a) * b;
+			return static_cast<u64>(product) ^ static_cast<u64>(product >> 64);
+#else
+			// 32-bit targets have no 128-bit integers, so the product is assembled from 32-bit halves.
+			auto const a_low = a & 0xFFFFFFFF;
+			auto const a_high = a >> 32;
+			auto const b_low = b & 0xFFFFFFFF;
+			auto const b_high = b >> 32;
+			auto const low_low = a_low * b_low;
+			auto const high_low = a_high * b_low;
+			auto const low_high = a_low * b_high;
+			auto const high_high = a_high * b_high;
+			auto const cross = (low_low >> 32) + (high_low & 0xFFFFFFFF) + low_high;
+			auto const upper = (high_low >> 32) + (cross >> 32) + high_high;
+			auto const lower = (cross << 32) | (low_low & 0xFFFFFFFF);
+			return lower ^ upper;
+#endif
+		}
+
+		auto avalanche(u64 value) -> u64
+		{
+			value ^= value >> 37;
+			value *= prime_mx1;
+			return value ^ (value >> 32);
+		}
+
+		auto avalanche_xxh64(u64 value) -> u64
+		{
+			value ^= value >> 33;
+			value *= prime64_2;
+			value ^= value >> 29;
+			value *= prime64_3;
+			return value ^ (value >> 32);
+		}
+
+		auto mix_16(u8 const* const p, u8 const* const s) -> u64
+		{
+			return multiply_fold(read_u64(p) ^ read_u64(s), read_u64(p + 8) ^ read_u64(s + 8));
+		}
+
+		auto hash_short(u8 const* const p, u32 const length) -> u64
+		{
+			if (length == 0) { return avalanche_xxh64(read_u64(secret + 56) ^ read_u64(secret + 64)); }
+
+			if (length <= 3)
+			{
+				auto const combined = (u64{ p[0] } << 16) | (u64{ p[length >> 1] } << 24) | u64{ p[length - 1] } |
+					(u64{ length } << 8);
+				return avalanche_xxh64(combined ^ (read_u32(secret) ^ read_u32(secret + 4)));
+			}
+
+			if (length <= 8)
+			{
+				auto value = (read_u32(p + length - 4) + (read_u32(p) << 32)) ^
+					(read_u64(secret + 8) ^ read_u64(secret + 16));
+				value ^= rotate_left(value, 49) ^ rotate_left(value, 24);
+				value *= prime_mx2;
+				value ^= (value >> 35) + length;
+				value *= prime_mx2;
+				return value ^ (value >> 28);
+			}
+
+			if (length <= 16)
+			{
+				auto const low = read_u64(p) ^ (read_u64(secret + 24) ^ read_u64(secret + 32));
+				auto const high = read_u64(p + length - 8) ^ (read_u64(secret + 40) ^ read_u64(secret + 48));
+				return avalanche(length + __builtin_bswap64(low) + high + multiply_fold(low, high));
+			}
+
+			auto res = length * prime64_1;
+			if (length <= 128)
+			{
+				if (length > 32)
+				{
+					if (length > 64)
+					{
+						if (length > 96)
+						{
+							res += mix_16(p + 48, secret + 96);
+							res += mix_16(p + length - 64, secret + 112);
+						}
+						res += mix_16(p + 32, secret + 64);
+						res += mix_16(p + length - 48, secret + 80);
+					}
+					res += mix_16(p + 16, secret + 32);
+					res += mix_16(p + length - 32, secret + 48);
+				}
+				res += mix_16(p + 0, secret + 0);
+				res += mix_16(p + length - 16, secret + 16);
+				return avalanche(res);
+			}
+
+			for (auto i = u32{ 0 }; i < 8; ++i) { res += mix_16(p + 16 * i, secret + 16 * i); }
+			res = avalanche(res);
+			for (auto i = u32{ 8 }; i < length / 16; ++i) { res += mix_16(p + 16 * i, secret + 16 * (i - 8) + 3); }
+			return avalanche(res + mix_16(p + length - 16, secret + 136 - 17));
+		}
+
+		auto accumulate(u64 (&accumulators)[8], u8 const* const p, u8 const* const s) -> void
+		{
+			for (auto i = u32{ 0 }; i < 8; ++i)
+			{
+				auto const value = read_u64(p + 8 * i);
+				auto const key = value ^ read_u64(s + 8 * i);
+				accumulators[i ^ 1] += value;
+				accumulators[i] += (key & 0xFFFFFFFF) * (key >> 32);
+			}
+		}
+
+#if defined(__SSE2__)
+		/// Accumulate whole stripes, which must be followed by more input.
+		///
+		/// Each 128 bit register holds two accumulators (the compiler does not vectorize the scalar version by itself).
+		auto consume_stripes(u64 (&accumulators)[8], u32& stripes_in_block, u8 const* p, u32 count) -> void
+		{
+			__m128i a[4];
+			__builtin_memcpy(a, accumulators, sizeof(a));
+
+			for (; count > 0; --count, p += stripe_size)
+			{
+				auto const* const s = secret + 8 * stripes_in_block;
+				for (auto i = u32{ 0 }; i < 4; ++i)
+				{
+					auto const value = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p) + i);
+					auto const key = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<__m128i const*>(s) + i));
+					auto const product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+					auto const swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+					a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+				}
+
+				stripes_in_block += 1;
+				if (stripes_in_block == stripes_per_block)
+				{
+					auto const prime = _mm_set1_epi32(static_cast<int>(prime32_1));
+					auto const* const key = secret + secret_size - stripe_size;
+					for (auto i = u32{ 0 }; i < 4; ++i)
+					{
+						auto value = _mm_xor_si128(a[i], _mm_srli_epi64(a[i], 47));
+						value = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<__m128i const*>(key) + i));
+						auto const high = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+						a[i] = _mm_add_epi64(_mm_mul_epu32(value, prime), _mm_slli_epi64(high, 32));
+					}
+					stripes_in_block = 0;
+				}
+			}
+
+			__builtin_memcpy(accumulators, a, sizeof(a));
+		}
+#else
+		auto scramble(u64 (&accumulators)[8]) -> void
+		{
+			for (auto i = u32{ 0 }; i < 8; ++i)
+			{
+				auto value = accumulators[i];
+				value ^= value >> 47;
+				value ^= read_u64(secret + secret_size - stripe_size + 8 * i);
+				accumulators[i] = value * prime32_1;
+			}
+		}
+
+		/// Accumulate whole stripes, which must be followed by more input.
+		auto consume_stripes(u64 (&accumulators)[8], u32& stripes_in_block, u8 const* p, u32 count) -> void
+		{
+			for (; count > 0; --count, p += stripe_size)
+			{
+				accumulate(accumulators, p, secret + 8 * stripes_in_block);
+				stripes_in_block += 1;
+				if (stripes_in_block == stripes_per_block)
+				{
+					scramble(accumulators);
+					stripes_in_block = 0;
+				}
+			}
+		}
+#endif
+	} // namespace
+
+	xxh3::xxh3()
+		: accumulators_{ prime32_3, prime64_1, prime64_2, prime64_3, prime64_4, prime32_2, prime64_5, prime32_1 }
+	{
+	}
+
+	auto xxh3::hash(span<u8 const> const data) -> u64
+	{
+		auto res = xxh3{};
+		res.update(data);
+		return res.get_value();
+	}
+
+	auto xxh3::update(span<u8 const> const data) -> void
+	{
+		auto p = data.get_data();
+		auto length = data.get_length();
+		total_length_ += length;
+
+		// Input is only consumed once more input follows it, because the last stripe is processed differently.
+		if (buffer_length_ + length <= buffer_size)
+		{
+			if (length > 0) { __builtin_memcpy(buffer_ + stripe_size + buffer_length_, p, length); }
+			buffer_length_ += length;
+			return;
+		}
+
+		auto const* last = p;
+		if (buffer_length_ > 0)
+		{
+			auto const count = buffer_size - buffer_length_;
+			__builtin_memcpy(buffer_ + stripe_size + buffer_length_, p, count);
+			consume_stripes(accumulators_, stripes_in_block_, buffer_ + stripe_size, buffer_size / stripe_size);
+			last = buffer_ + stripe_size;
+			p += count;
+			length -= count;
+		}
+
+		for (; length > buffer_size; p += buffer_size, length -= buffer_size)
+		{
+			consume_stripes(accumulators_, stripes_in_block_, p, buffer_size / stripe_size);
+			last = p;
+		}
+
+		// Keep the last consumed stripe in front of the buffered input.
+		__builtin_memcpy(buffer_, last + buffer_size - stripe_size, stripe_size);
+		__builtin_memcpy(buffer_ + stripe_size, p, length);
+		buffer_length_ = length;
+	}
+
+	auto xxh3::get_value() const -> u64
+	{
+		if (total_length_ <= max_midsize_length) { return hash_short(buffer_ + stripe_size, buffer_length_); }
+
+		u64 accumulators[8];
+		__builtin_memcpy(accumulators, accumulators_, sizeof(accumulators));
+		auto stripes_in_block = stripes_in_block_;
+		consume_stripes(accumulators, stripes_in_block, buffer_ + stripe_size, (buffer_length_ - 1) / stripe_size);
+		// The last stripe may overlap with the previous one (and with consumed input).
+		accumulate(accumulators, buffer_ + buffer_length_, secret + secret_size - stripe_size - 7);
+
+		auto res = total_length_ * prime64_1;
+		for (auto i = u32{ 0 }; i < 4; ++i)
+		{
+			res += multiply_fold(
+				accumulators[2 * i + 0] ^ read_u64(secret + 11 + 16 * i),
+				accumulators[2 * i + 1] ^ read_u64(secret + 11 + 16 * i + 8));
+		}
+		return avalanche(res);
+	}
+} // namespace nes
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "nes/common/containers/span.hh"
+#include "nes/common/types.hh"
+
+namespace nes
+{
+	/// Streaming 64-bit XXH3 hash (using the default secret), a fast non-cryptographic hash.
+	///
+	/// Large inputs are processed in 64 byte stripes by eight independent accumulators using 32x32 bit multiplications,
+	/// which the compiler maps to SIMD instructions where available. The result does not depend on how the input is
+	/// split between calls to update and matches the reference implementation (XXH3_64bits).
+	class xxh3
+	{
+		static constexpr auto stripe_size = u32{ 64 };
+		static constexpr auto buffer_size = 4 * stripe_size;
+
+		u64 accumulators_[8]{};
+		u64 total_length_{ 0 };
+		u32 stripes_in_block_{ 0 };
+		u32 buffer_length_{ 0 };
+		// The buffered input starts after one stripe, which holds the preceding (already consumed) input.
+		alignas(8) u8 buffer_[stripe_size + buffer_size]{};
+
+	public:
+		explicit xxh3();
+
+		static auto hash(span<u8 const>) -> u64;
+
+		auto update(span<u8 const>) -> void;
+		auto get_value() const -> u64;
+	};
+} // namespace nes
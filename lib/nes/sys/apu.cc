@@ -0,0 +1,575 @@
+#include "nes/sys/apu.hh"
+#include "nes/sys/cpu.hh"
+#include "nes/common/audio-mixer.hh"
+#include "nes/common/band-limited-buffer.hh"
+#include "nes/common/utils.hh"
+
+namespace nes::sys
+{
+	namespace
+	{
+		constexpr u8 length_table[32] =
+		{
+			10, 254, 20, 2, 40, 4, 80, 6, 160, 8, 60, 10, 14, 12, 26, 14,
+			12, 16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30,
+		};
+
+		constexpr u8 duty_table[4][8] =
+		{
+			{ 0, 1, 0, 0, 0, 0, 0, 0 },
+			{ 0, 1, 1, 0, 0, 0, 0, 0 },
+			{ 0, 1, 1, 1, 1, 0, 0, 0 },
+			{ 1, 0, 0, 1, 1, 1, 1, 1 },
+		};
+
+		// Timer periods in CPU cycles (NTSC).
+		constexpr u16 noise_period_table[16] =
+		{
+			4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068,
+		};
+
+		// Timer periods in CPU cycles (NTSC).
+		constexpr u16 dmc_period_table[16] =
+		{
+			428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54,
+		};
+
+		// Frame counter steps in CPU cycles since the start of the sequence (NTSC).
+		constexpr u64 frame_step_table[5] = { 7457, 14913, 22371, 29829, 37281 };
+		constexpr u64 four_step_length = 29830;
+		constexpr u64 five_step_length = 37282;
+	} // namespace
+
+	// -----------------------------------------------------------------------------------------------------------------
+	// Channels
+	// -----------------------------------------------------------------------------------------------------------------
+
+	//
+	// See: https://www.nesdev.org/wiki/APU_Envelope
+	//
+
+	auto apu::envelope_generator::clock() -> void
+	{
+		if (start)
+		{
+			start = false;
+			decay = 15;
+			divider = volume;
+		}
+		else if (divider == 0)
+		{
+			divider = volume;
+			if (decay > 0) { decay -= 1; }
+			else if (loop) { decay = 15; }
+		}
+		else
+		{
+			divider -= 1;
+		}
+	}
+
+	//
+	// See: https://www.nesdev.org/wiki/APU_Pulse and https://www.nesdev.org/wiki/APU_Sweep
+	//
+
+	auto apu::pulse_channel::get_target_period() const -> u16
+	{
+		auto const change = static_cast<i32>(period >> sweep_shift);
+		if (!sweep_negate) { return static_cast<u16>(period + change); }
+		return static_cast<u16>(max(static_cast<i32>(period) - change - (ones_complement ? 1 : 0), i32{ 0 }));
+	}
+
+	auto apu::pulse_channel::is_muted() const -> bool
+	{
+		return period < 8 || get_target_period() > 0x7FF;
+	}
+
+	auto apu::pulse_channel::clock_sweep() -> void
+	{
+		if (sweep_divider == 0 && sweep_enabled && sweep_shift > 0 && !is_muted())
+		{
+			period = get_target_period();
+		}
+
+		if (sweep_divider == 0 || sweep_reload)
+		{
+			sweep_divider = sweep_period;
+			sweep_reload = false;
+		}
+		else
+		{
+			sweep_divider -= 1;
+		}
+	}
+
+	auto apu::pulse_channel::get_output() const -> u8
+	{
+		if (length == 0 || is_muted() || duty_table[duty][sequence] == 0) { return 0; }
+		return envelope.get_output();
+	}
+
+	//
+	// See: https://www.nesdev.org/wiki/APU_Triangle
+	//
+
+	auto apu::triangle_channel::clock_linear() -> void
+	{
+		if (linear_reload) { linear = linear_reload_value; }
+		else if (linear > 0) { linear -= 1; }
+		if (!control) { linear_reload = false; }
+	}
+
+	auto apu::triangle_channel::get_output() const -> u8
+	{
+		return static_cast<u8>(sequence < 16 ? 15 - sequence : sequence - 16);
+	}
+
+	//
+	// See: https://www.nesdev.org/wiki/APU_Noise
+	//
+
+	auto apu::noise_channel::get_output() const -> u8
+	{
+		if (length == 0 || (shift & 1) != 0) { return 0; }
+		return envelope.get_output();
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	// APU
+	// -----------------------------------------------------------------------------------------------------------------
+
+	apu::apu(cpu& cpu)
+		: cpu_{ cpu }
+	{
+		state_.pulse_1.ones_complement = true;
+	}
+
+	auto apu::get_next_event() const -> cycle_count
+	{
+		auto next = get_next_frame_event();
+		// Samples are fetched when the output unit empties the buffer, which reads memory, stalls the CPU and raises
+		// the IRQ after the last byte. This has to happen in time, not whenever the APU is observed next.
+		if (state_.dmc.bytes_remaining > 0 && !state_.dmc.buffer_empty)
+		{
+			auto const fetch = state_.cycles + state_.dmc.countdown +
+				(state_.dmc.bits_remaining - u64{ 1 }) * state_.dmc.period;
+			next = min(next, fetch);
+		}
+		return cycle_count::from_cpu(next);
+	}
+
+	auto apu::run_until(cycle_count const target) -> void
+	{
+		auto const target_cycles = target.to_cpu();
+		while (state_.cycles < target_cycles)
+		{
+			auto const frame_event = get_next_frame_event();
+			auto const next = min(frame_event, target_cycles);
+			run_channels(next - state_.cycles);
+			state_.cycles = next;
+			if (next == frame_event)
+			{
+				run_frame_event();
+				update_output(state_.cycles);
+			}
+		}
+	}
+
+	auto apu::set_state(state const& value) -> void
+	{
+		// The output continues where it left off, just with the levels of the new state.
+		state_ = value;
+		output_time_offset_ = output_time_ - state_.cycles;
+		update_output(state_.cycles);
+	}
+
+	auto apu::set_output(band_limited_buffer* const output) -> void
+	{
+		run_until(cpu_.get_cycles());
+		output_ = output;
+		output_level_ = 0;
+		output_time_ = state_.cycles + output_time_offset_;
+		if (output_ != nullptr)
+		{
+			output_->reset(output_time_);
+			update_output(state_.cycles);
+		}
+	}
+
+	auto apu::set_output_muted(bool const muted) -> void
+	{
+		run_until(cpu_.get_cycles());
+		output_muted_ = muted;
+		update_output(state_.cycles);
+	}
+
+	auto apu::end_frame() -> void
+	{
+		run_until(cpu_.get_cycles());
+		if (output_ == nullptr || output_muted_) { return; }
+
+		output_time_ = state_.cycles + output_time_offset_;
+		output_->end_frame(output_time_);
+	}
+
+	auto apu::sample() -> levels
+	{
+		run_until(cpu_.get_cycles());
+
+		auto res = levels{};
+		res.pulse_1 = state_.pulse_1.get_output();
+		res.pulse_2 = state_.pulse_2.get_output();
+		res.triangle = state_.triangle.get_output();
+		res.noise = state_.noise.get_output();
+		res.dmc = state_.dmc.get_output();
+		return res;
+	}
+
+	auto apu::get_next_frame_event() const -> u64
+	{
+		return state_.frame_start + frame_step_table[state_.frame_step];
+	}
+
+	auto apu::run_channels(u64 const cycles) -> void
+	{
+		// The triangle sequencer only advances while both counters are non-zero. Ultrasonic periods are not played
+		// back at all (like most emulators do) to avoid stepping every cycle and producing popping noises. None of
+		// these can change in between frame counter events and register writes.
+		auto const triangle_active = state_.triangle.length > 0 && state_.triangle.linear > 0 && state_.triangle.period >= 2;
+		constexpr auto inactive = ~u32{ 0 };
+
+		// Jump from one timer reload to the next, in order, so that the output changes can be recorded in time.
+		auto remaining = cycles;
+		auto time = state_.cycles;
+		while (true)
+		{
+			auto const next = min(
+				min(min(state_.pulse_1.countdown, state_.pulse_2.countdown), triangle_active ? state_.triangle.countdown : inactive),
+				min(state_.noise.countdown, state_.dmc.countdown));
+			if (next > remaining) { break; }
+
+			remaining -= next;
+			time += next;
+			state_.pulse_1.countdown -= next;
+			state_.pulse_2.countdown -= next;
+			if (triangle_active) { state_.triangle.countdown -= next; }
+			state_.noise.countdown -= next;
+			state_.dmc.countdown -= next;
+
+			// The pulse timers are clocked every other CPU cycle.
+			if (state_.pulse_1.countdown == 0)
+			{
+				state_.pulse_1.countdown = (state_.pulse_1.period + 1u) * 2;
+				state_.pulse_1.sequence = (state_.pulse_1.sequence + 1) % 8;
+			}
+			if (state_.pulse_2.countdown == 0)
+			{
+				state_.pulse_2.countdown = (state_.pulse_2.period + 1u) * 2;
+				state_.pulse_2.sequence = (state_.pulse_2.sequence + 1) % 8;
+			}
+			if (triangle_active && state_.triangle.countdown == 0)
+			{
+				state_.triangle.countdown = state_.triangle.period + 1u;
+				state_.triangle.sequence = (state_.triangle.sequence + 1) % 32;
+			}
+			if (state_.noise.countdown == 0)
+			{
+				state_.noise.countdown = state_.noise.period;
+				auto const tap = state_.noise.mode ? 6 : 1;
+				auto const feedback = (state_.noise.shift ^ (state_.noise.shift >> tap)) & 1;
+				state_.noise.shift = static_cast<u16>((state_.noise.shift >> 1) | (feedback << 14));
+			}
+			if (state_.dmc.countdown == 0)
+			{
+				state_.dmc.countdown = state_.dmc.period;
+				clock_dmc();
+			}
+
+			update_output(time);
+		}
+
+		auto const rest = static_cast<u32>(remaining);
+		state_.pulse_1.countdown -= rest;
+		state_.pulse_2.countdown -= rest;
+		if (triangle_active) { state_.triangle.countdown -= rest; }
+		state_.noise.countdown -= rest;
+		state_.dmc.countdown -= rest;
+	}
+
+	auto apu::update_output(u64 const time) -> void
+	{
+		if (output_ == nullptr || output_muted_) { return; }
+
+		auto const level = audio_mixer::mix(
+			state_.pulse_1.get_output(),
+			state_.pulse_2.get_output(),
+			state_.triangle.get_output(),
+			state_.noise.get_output(),
+			state_.dmc.get_output());
+		output_time_ = time + output_time_offset_;
+		output_->add_delta(output_time_, level - output_level_);
+		output_level_ = level;
+	}
+
+	//
+	// See: https://www.nesdev.org/wiki/APU_Frame_Counter
+	//
+
+	auto apu::run_frame_event() -> void
+	{
+		switch (state_.frame_mode)
+		{
+			case frame_counter_mode::four_step:
+				clock_quarter_frame();
+				if (state_.frame_step == 1 || state_.frame_step == 3) { clock_half_frame(); }
+				if (state_.frame_step == 3 && !state_.frame_irq_inhibit) { state_.frame_irq = true; }
+				state_.frame_step += 1;
+				if (state_.frame_step == 4)
+				{
+					state_.frame_step = 0;
+					state_.frame_start += four_step_length;
+				}
+				break;
+			case frame_counter_mode::five_step:
+				if (state_.frame_step != 3) { clock_quarter_frame(); }
+				if (state_.frame_step == 1 || state_.frame_step == 4) { clock_half_frame(); }
+				state_.frame_step += 1;
+				if (state_.frame_step == 5)
+				{
+					state_.frame_step = 0;
+					state_.frame_start += five_step_length;
+				}
+				break;
+		}
+	}
+
+	auto apu::clock_quarter_frame() -> void
+	{
+		state_.pulse_1.envelope.clock();
+		state_.pulse_2.envelope.clock();
+		state_.triangle.clock_linear();
+		state_.noise.envelope.clock();
+	}
+
+	auto apu::clock_half_frame() -> void
+	{
+		// The envelope loop flag doubles as the length counter halt flag.
+		if (state_.pulse_1.length > 0 && !state_.pulse_1.envelope.loop) { state_.pulse_1.length -= 1; }
+		if (state_.pulse_2.length > 0 && !state_.pulse_2.envelope.loop) { state_.pulse_2.length -= 1; }
+		if (state_.triangle.length > 0 && !state_.triangle.control) { state_.triangle.length -= 1; }
+		if (state_.noise.length > 0 && !state_.noise.envelope.loop) { state_.noise.length -= 1; }
+		state_.pulse_1.clock_sweep();
+		state_.pulse_2.clock_sweep();
+	}
+
+	//
+	// See: https://www.nesdev.org/wiki/APU_DMC
+	//
+
+	auto apu::clock_dmc() -> void
+	{
+		if (!state_.dmc.silence)
+		{
+			if ((state_.dmc.shift & 1) != 0) { if (state_.dmc.level <= 125) { state_.dmc.level += 2; } }
+			else { if (state_.dmc.level >= 2) { state_.dmc.level -= 2; } }
+			state_.dmc.shift >>= 1;
+		}
+
+		state_.dmc.bits_remaining -= 1;
+		if (state_.dmc.bits_remaining == 0)
+		{
+			state_.dmc.bits_remaining = 8;
+			state_.dmc.silence = state_.dmc.buffer_empty;
+			if (!state_.dmc.buffer_empty)
+			{
+				state_.dmc.shift = state_.dmc.buffer;
+				state_.dmc.buffer_empty = true;
+				fill_dmc_buffer();
+			}
+		}
+	}
+
+	auto apu::restart_dmc() -> void
+	{
+		state_.dmc.current_address = state_.dmc.sample_address;
+		state_.dmc.bytes_remaining = state_.dmc.sample_length;
+	}
+
+	auto apu::fill_dmc_buffer() -> void
+	{
+		if (!state_.dmc.buffer_empty || state_.dmc.bytes_remaining == 0) { return; }
+
+		// The sample is fetched by stalling the CPU.
+		state_.dmc.buffer = cpu_.read8(address{ state_.dmc.current_address });
+		state_.dmc.buffer_empty = false;
+		cpu_.stall_cycles(cycle_count::from_cpu(4));
+		state_.dmc.current_address = state_.dmc.current_address == 0xFFFF ? 0x8000 : static_cast<u16>(state_.dmc.current_address + 1);
+		state_.dmc.bytes_remaining -= 1;
+
+		if (state_.dmc.bytes_remaining == 0)
+		{
+			if (state_.dmc.loop) { restart_dmc(); }
+			else if (state_.dmc.irq_enabled) { state_.dmc.irq = true; }
+		}
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	// IO registers
+	// -----------------------------------------------------------------------------------------------------------------
+
+	//
+	// See: https://www.nesdev.org/wiki/APU_registers
+	//
+
+	auto apu::read_status() -> u8
+	{
+		run_until(cpu_.get_cycles());
+
+		auto const res = static_cast<u8>(
+			(state_.pulse_1.length > 0 ? 0b00000001 : 0) |
+			(state_.pulse_2.length > 0 ? 0b00000010 : 0) |
+			(state_.triangle.length > 0 ? 0b00000100 : 0) |
+			(state_.noise.length > 0 ? 0b00001000 : 0) |
+			(state_.dmc.bytes_remaining > 0 ? 0b00010000 : 0) |
+			(state_.frame_irq ? 0b01000000 : 0) |
+			(state_.dmc.irq ? 0b10000000 : 0));
+		state_.frame_irq = false;
+		return res;
+	}
+
+	auto apu::write_register(address const addr, u8 const value) -> void
+	{
+		run_until(cpu_.get_cycles());
+		apply_register(addr, value);
+		update_output(state_.cycles);
+	}
+
+	auto apu::apply_register(address const addr, u8 const value) -> void
+	{
+
+		auto const reg = addr.get_absolute() - 0x4000u;
+		if (reg < 8)
+		{
+			auto& pulse = reg < 4 ? state_.pulse_1 : state_.pulse_2;
+			switch (reg % 4)
+			{
+				case 0:
+					pulse.duty = static_cast<u8>(value >> 6);
+					pulse.envelope.loop = (value & 0b00100000) != 0;
+					pulse.envelope.constant = (value & 0b00010000) != 0;
+					pulse.envelope.volume = value & 0b00001111;
+					return;
+				case 1:
+					pulse.sweep_enabled = (value & 0b10000000) != 0;
+					pulse.sweep_period = (value & 0b01110000) >> 4;
+					pulse.sweep_negate = (value & 0b00001000) != 0;
+					pulse.sweep_shift = value & 0b00000111;
+					pulse.sweep_reload = true;
+					return;
+				case 2:
+					pulse.period = static_cast<u16>((pulse.period & 0x700) | value);
+					return;
+				case 3:
+					pulse.period = static_cast<u16>((pulse.period & 0xFF) | ((value & 0b111) << 8));
+					if (pulse.enabled) { pulse.length = length_table[value >> 3]; }
+					pulse.sequence = 0;
+					pulse.envelope.start = true;
+					return;
+				default:
+					return;
+			}
+		}
+
+		switch (reg)
+		{
+			case 0x8:
+				state_.triangle.control = (value & 0b10000000) != 0;
+				state_.triangle.linear_reload_value = value & 0b01111111;
+				return;
+			case 0xA:
+				state_.triangle.period = static_cast<u16>((state_.triangle.period & 0x700) | value);
+				return;
+			case 0xB:
+				state_.triangle.period = static_cast<u16>((state_.triangle.period & 0xFF) | ((value & 0b111) << 8));
+				if (state_.triangle.enabled) { state_.triangle.length = length_table[value >> 3]; }
+				state_.triangle.linear_reload = true;
+				return;
+			case 0xC:
+				state_.noise.envelope.loop = (value & 0b00100000) != 0;
+				state_.noise.envelope.constant = (value & 0b00010000) != 0;
+				state_.noise.envelope.volume = value & 0b00001111;
+				return;
+			case 0xE:
+				state_.noise.mode = (value & 0b10000000) != 0;
+				state_.noise.period = noise_period_table[value & 0b00001111];
+				return;
+			case 0xF:
+				if (state_.noise.enabled) { state_.noise.length = length_table[value >> 3]; }
+				state_.noise.envelope.start = true;
+				return;
+			case 0x10:
+				state_.dmc.irq_enabled = (value & 0b10000000) != 0;
+				state_.dmc.loop = (value & 0b01000000) != 0;
+				state_.dmc.period = dmc_period_table[value & 0b00001111];
+				if (!state_.dmc.irq_enabled) { state_.dmc.irq = false; }
+				return;
+			case 0x11:
+				state_.dmc.level = value & 0b01111111;
+				return;
+			case 0x12:
+				state_.dmc.sample_address = static_cast<u16>(0xC000 + value * 64);
+				return;
+			case 0x13:
+				state_.dmc.sample_length = static_cast<u16>(value * 16 + 1);
+				return;
+			default:
+				return;
+		}
+	}
+
+	auto apu::write_status(u8 const value) -> void
+	{
+		run_until(cpu_.get_cycles());
+
+		state_.pulse_1.enabled = (value & 0b00000001) != 0;
+		state_.pulse_2.enabled = (value & 0b00000010) != 0;
+		state_.triangle.enabled = (value & 0b00000100) != 0;
+		state_.noise.enabled = (value & 0b00001000) != 0;
+		if (!state_.pulse_1.enabled) { state_.pulse_1.length = 0; }
+		if (!state_.pulse_2.enabled) { state_.pulse_2.length = 0; }
+		if (!state_.triangle.enabled) { state_.triangle.length = 0; }
+		if (!state_.noise.enabled) { state_.noise.length = 0; }
+
+		state_.dmc.irq = false;
+		if ((value & 0b00010000) == 0)
+		{
+			state_.dmc.bytes_remaining = 0;
+		}
+		else if (state_.dmc.bytes_remaining == 0)
+		{
+			restart_dmc();
+			fill_dmc_buffer();
+		}
+
+		update_output(state_.cycles);
+	}
+
+	auto apu::write_frame_counter(u8 const value) -> void
+	{
+		run_until(cpu_.get_cycles());
+
+		state_.frame_mode = (value & 0b10000000) != 0 ? frame_counter_mode::five_step : frame_counter_mode::four_step;
+		state_.frame_irq_inhibit = (value & 0b01000000) != 0;
+		if (state_.frame_irq_inhibit) { state_.frame_irq = false; }
+
+		// Writing resets the sequence, the five step mode additionally clocks all units immediately.
+		state_.frame_step = 0;
+		state_.frame_start = state_.cycles;
+		if (state_.frame_mode == frame_counter_mode::five_step)
+		{
+			clock_quarter_frame();
+			clock_half_frame();
+			update_output(state_.cycles);
+		}
+	}
+} // namespace nes::sys
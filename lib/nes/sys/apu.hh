@@ -0,0 +1,211 @@
+#pragma once
+
+#include "nes/sys/types/cycle-count.hh"
+#include "nes/sys/types/address.hh"
+#include "nes/common/types.hh"
+
+namespace nes
+{
+	class band_limited_buffer;
+} // namespace nes
+
+namespace nes::sys
+{
+	class cpu;
+
+	/// The audio processing unit.
+	///
+	/// Instead of ticking every CPU cycle, the APU is only advanced when it is observed: on register accesses, when
+	/// sampling its output and when the console reaches the next event which could raise an interrupt (see
+	/// get_next_event). Between these points, each channel skips directly from one timer reload to the next.
+	///
+	/// See: https://www.nesdev.org/wiki/APU
+	class apu
+	{
+		// Envelope generator shared by the pulse and noise channels.
+		struct envelope_generator
+		{
+			bool start{ false };
+			bool loop{ false };
+			bool constant{ false };
+			u8 volume{ 0 }; // Constant volume or divider period.
+			u8 divider{ 0 };
+			u8 decay{ 0 };
+
+			auto clock() -> void;
+			auto get_output() const -> u8 { return constant ? volume : decay; }
+		};
+
+		struct pulse_channel
+		{
+			bool enabled{ false };
+			bool ones_complement{ false }; // The first pulse channel negates using one's complement.
+			u8 duty{ 0 };
+			u8 sequence{ 0 };
+			u16 period{ 0 };
+			u8 padding_1[2]{};
+			u32 countdown{ 2 }; // CPU cycles until the next sequencer step.
+			u8 length{ 0 };
+			envelope_generator envelope{};
+			bool sweep_enabled{ false };
+			bool sweep_negate{ false };
+			bool sweep_reload{ false };
+			u8 sweep_period{ 0 };
+			u8 sweep_shift{ 0 };
+			u8 sweep_divider{ 0 };
+			u8 padding_2[3]{};
+
+			auto get_target_period() const -> u16;
+			auto is_muted() const -> bool;
+			auto clock_sweep() -> void;
+			auto get_output() const -> u8;
+		};
+
+		struct triangle_channel
+		{
+			bool enabled{ false };
+			bool control{ false }; // Also halts the length counter.
+			bool linear_reload{ false };
+			u8 linear_reload_value{ 0 };
+			u8 linear{ 0 };
+			u8 sequence{ 0 };
+			u16 period{ 0 };
+			u32 countdown{ 1 };
+			u8 length{ 0 };
+			u8 padding[3]{};
+
+			auto clock_linear() -> void;
+			auto get_output() const -> u8;
+		};
+
+		struct noise_channel
+		{
+			bool enabled{ false };
+			bool mode{ false };
+			u16 shift{ 1 };
+			u16 period{ 4 };
+			u8 padding_1[2]{};
+			u32 countdown{ 4 };
+			u8 length{ 0 };
+			envelope_generator envelope{};
+			u8 padding_2{ 0 };
+
+			auto get_output() const -> u8;
+		};
+
+		struct dmc_channel
+		{
+			bool irq_enabled{ false };
+			bool loop{ false };
+			bool irq{ false };
+			u8 padding_1{ 0 };
+			u16 period{ 428 };
+			u8 padding_2[2]{};
+			u32 countdown{ 428 };
+			u8 level{ 0 };
+			u8 padding_3{ 0 };
+			u16 sample_address{ 0xC000 };
+			u16 sample_length{ 1 };
+			u16 current_address{ 0xC000 };
+			u16 bytes_remaining{ 0 };
+			u8 buffer{ 0 };
+			bool buffer_empty{ true };
+			u8 shift{ 0 };
+			u8 bits_remaining{ 8 };
+			bool silence{ true };
+			u8 padding_4{ 0 };
+
+			auto get_output() const -> u8 { return level; }
+		};
+
+		enum class frame_counter_mode
+		{
+			four_step,
+			five_step,
+		};
+
+	public:
+		/// All mutable state of the APU, which can be saved and restored as a whole.
+		struct state
+		{
+			u64 cycles{ 0 }; // In CPU cycles.
+			pulse_channel pulse_1{};
+			pulse_channel pulse_2{};
+			triangle_channel triangle{};
+			noise_channel noise{};
+			dmc_channel dmc{};
+			frame_counter_mode frame_mode{ frame_counter_mode::four_step };
+			bool frame_irq_inhibit{ false };
+			bool frame_irq{ false };
+			u8 padding_1[2]{};
+			u32 frame_step{ 0 };
+			u8 padding_2[4]{};
+			u64 frame_start{ 0 }; // CPU cycle at which the current frame counter sequence started.
+		};
+
+	private:
+		state state_{};
+		cpu& cpu_;
+		band_limited_buffer* output_{ nullptr };
+		i32 output_level_{ 0 };
+		u64 output_time_{ 0 }; // Latest point in time passed to the output (in output time).
+		u64 output_time_offset_{ 0 }; // Keeps the output timestamps monotonic when restoring an earlier state.
+		bool output_muted_{ false };
+
+	public:
+		/// Output levels of the individual channels, before mixing.
+		struct levels
+		{
+			u8 pulse_1{ 0 };    // 0-15
+			u8 pulse_2{ 0 };    // 0-15
+			u8 triangle{ 0 };   // 0-15
+			u8 noise{ 0 };      // 0-15
+			u8 dmc{ 0 };        // 0-127
+		};
+
+		explicit apu(cpu&);
+
+		apu(apu const&) = delete;
+		apu(apu&&) = delete;
+		auto operator=(apu const&) -> apu& = delete;
+		auto operator=(apu&&) -> apu& = delete;
+
+		auto get_cycles() const -> cycle_count { return cycle_count::from_cpu(state_.cycles); }
+		auto get_state() const -> state const& { return state_; }
+		auto set_state(state const&) -> void;
+		/// The earliest point at which the APU needs to run again to raise interrupts in time.
+		auto get_next_event() const -> cycle_count;
+		auto is_irq_asserted() const -> bool { return state_.frame_irq || state_.dmc.irq; }
+
+		/// Catch up to the given point in time.
+		auto run_until(cycle_count) -> void;
+		/// Catch up to the CPU and get the current output levels.
+		auto sample() -> levels;
+		/// Record the mixed output into the given buffer, using CPU cycles as its clock (nullptr to disable).
+		auto set_output(band_limited_buffer*) -> void;
+		/// While muted, nothing is recorded and the output time does not advance, so restoring a state saved before
+		/// muting (before unmuting again) continues the output seamlessly. This is used for speculative emulation.
+		auto set_output_muted(bool) -> void;
+		/// Catch up to the CPU and make the recorded output available for reading.
+		auto end_frame() -> void;
+
+		// IO registers
+
+		auto read_status() -> u8;
+		auto write_register(address, u8) -> void;
+		auto write_status(u8) -> void;
+		auto write_frame_counter(u8) -> void;
+
+	private:
+		auto get_next_frame_event() const -> u64;
+		auto run_channels(u64 cycles) -> void;
+		auto update_output(u64 time) -> void;
+		auto apply_register(address, u8) -> void;
+		auto run_frame_event() -> void;
+		auto clock_quarter_frame() -> void;
+		auto clock_half_frame() -> void;
+		auto clock_dmc() -> void;
+		auto restart_dmc() -> void;
+		auto fill_dmc_buffer() -> void;
+	};
+} // namespace nes::sys
@@ -1,76 +1,65 @@
 #pragma once
 
+#include "nes/sys/rom-image.hh"
 #include "nes/sys/mapper.hh"
+#include "nes/sys/types/paged-memory.hh"
 #include "nes/common/containers/span.hh"
 #include "nes/common/status.hh"
 #include "nes/common/types.hh"
 
 namespace nes::sys
 {
-	enum class name_table_arrangement
-	{
-		horizontal,
-		vertical,
-	};
-
+	/// The per-console state of a cartridge.
+	///
+	/// The ROM contents are referenced from a shared rom_image, the cartridge itself only stores the mutable parts
+	/// (RAM and mapper registers).
 	class cartridge
 	{
-		static constexpr auto prg_rom_bank_size = u32{ 16 * 1024 };
-		static constexpr auto chr_rom_bank_size = u32{ 8 * 1024 };
-		static constexpr auto ram_bank_size = u32{ 8 * 1024 };
-		static constexpr auto max_prg_rom_size = u32{ 4 * prg_rom_bank_size };
-		static constexpr auto max_chr_rom_size = u32{ 4 * chr_rom_bank_size };
-		static constexpr auto max_ram_size = u32{ 4 * ram_bank_size };
-		static constexpr auto header_length = u32{ 16 };
+		static constexpr auto mapper_register_count = u32{ 8 };
 
-		struct header
-		{
-			auto get_magic_0() const -> u8 { return value[0]; }
-			auto get_magic_1() const -> u8 { return value[1]; }
-			auto get_magic_2() const -> u8 { return value[2]; }
-			auto get_magic_3() const -> u8 { return value[3]; }
-			auto get_prg_rom_banks() const -> u32 { return value[4]; }
-			auto get_chr_rom_banks() const -> u32 { return value[5]; }
-			auto get_control_1() const -> u8 { return value[6]; }
-			auto get_control_2() const -> u8 { return value[7]; }
-			auto get_ram_banks() const -> u32 { return value[8]; }
-			auto get_has_trainer() const -> bool { return get_control_1() & 0b00000100; }
-			auto get_mapper_low() const -> u32 { return (get_control_1() & 0b11110000) >> 4; }
-			auto get_mapper_high() const -> u32 { return (get_control_2() & 0b11110000) >> 0; }
-			auto get_name_table_arrangement() const -> name_table_arrangement { return static_cast<name_table_arrangement>((get_control_1() & 0b00000001) >> 0); }
-
-			u8 value[header_length]{};
+	public:
+		using ram = paged_memory<rom_image::max_ram_size>;
+		using chr_ram = paged_memory<8 * 1024>;
 
-			explicit header(span<u8 const, header_length> const v)
-			{
-				for (auto i = u32{ 0 }; i < header_length; ++i)
-				{
-					value[i] = v[i];
-				}
-			}
+		/// All mutable state of the cartridge except for its memory, which can be saved and restored as a whole.
+		struct state
+		{
+			u8 mapper_registers[mapper_register_count]{};
 		};
 
-		status status_{ status::error_invalid_ines_data };
-		u8 prg_rom_[max_prg_rom_size]{};
-		u8 chr_rom_[max_chr_rom_size]{};
-		u8 ram_[max_ram_size]{};
-		u32 prg_rom_size_{};
-		u32 chr_rom_size_{};
-		u32 ram_size_{};
-		name_table_arrangement name_table_arrangement_{};
-		mapper* mapper_{ &mapper::invalid() };
+	private:
+		rom_image const& rom_;
+		state state_{};
+		ram ram_{};
+		chr_ram chr_ram_{};
 
 	public:
-		static constexpr auto max_file_size = u32{ max_prg_rom_size + max_chr_rom_size + 512 + header_length };
+		explicit cartridge(rom_image const&);
+		~cartridge();
 
-		explicit cartridge(span<u8 const>);
+		cartridge(cartridge const&) = delete;
+		cartridge(cartridge&&) = delete;
+		auto operator=(cartridge const&) -> cartridge& = delete;
+		auto operator=(cartridge&&) -> cartridge& = delete;
 
-		auto get_status() const -> status { return status_; }
-		auto get_prg_rom() const -> span<u8 const> { return span{ prg_rom_, prg_rom_size_ }; }
-		auto get_chr_rom() const -> span<u8 const> { return span{ chr_rom_, chr_rom_size_ }; }
-		auto get_ram() const -> span<u8 const> { return span{ ram_, ram_size_ }; }
-		auto ref_ram() -> span<u8> { return span{ ram_, ram_size_ }; }
-		auto get_mapper() const -> mapper& { return *mapper_; }
-		auto get_name_table_arrangement() const -> name_table_arrangement { return name_table_arrangement_; }
+		auto get_status() const -> status { return rom_.get_status(); }
+		auto get_state() const -> state const& { return state_; }
+		auto set_state(state const& value) -> void { state_ = value; }
+		auto get_rom() const -> rom_image const& { return rom_; }
+		auto get_prg_rom() const -> span<u8 const> { return rom_.get_prg_rom(); }
+		auto get_chr_rom() const -> span<u8 const> { return rom_.get_chr_rom(); }
+		auto get_ram() const -> span<u8 const> { return ram_.get_data().subspan(0, rom_.get_ram_size()); }
+		auto write_ram(u32 const index, u8 const value) -> void { ram_.write(index, value); }
+		auto get_chr_ram() const -> span<u8 const> { return chr_ram_.get_data(); }
+		auto write_chr_ram(u32 const index, u8 const value) -> void { chr_ram_.write(index, value); }
+		/// The complete memory blocks, including unused parts.
+		auto get_ram_memory() const -> ram const& { return ram_; }
+		auto ref_ram_memory() -> ram& { return ram_; }
+		auto get_chr_ram_memory() const -> chr_ram const& { return chr_ram_; }
+		auto ref_chr_ram_memory() -> chr_ram& { return chr_ram_; }
+		/// Scratch registers available to the mapper for storing bank selections and similar state.
+		auto ref_mapper_registers() -> span<u8> { return state_.mapper_registers; }
+		auto get_mapper() const -> mapper& { return rom_.get_mapper(); }
+		auto get_name_table_arrangement() const -> name_table_arrangement { return rom_.get_name_table_arrangement(); }
 	};
-} // namespace nes::sys
\ No newline at end of file
+} // namespace nes::sys
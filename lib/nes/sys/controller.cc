@@ -4,15 +4,18 @@ namespace nes::sys
 {
 	auto controller::read() -> u8
 	{
-		auto const res = index_ < 8 ? (pressed_.get_raw_value() >> index_) & 1 : 0;
-		index_ += 1;
-		if (strobing_) { index_ = 0; }
+		auto const res = state_.index < 8 ? (state_.pressed.get_raw_value() >> state_.index) & 1 : 0;
+		state_.index += 1;
+		if (state_.strobing) { state_.index = 0; }
 		return static_cast<u8>(res);
 	}
 
 	auto controller::write(u8 const value) -> void
 	{
-		strobing_ = value & 1;
-		if (strobing_) { index_ = 0; }
+		// The buttons are reloaded while the strobe bit is set and latched when it is cleared.
+		if (input_ && (state_.strobing || (value & 1))) { state_.pressed = input_->latch(); }
+
+		state_.strobing = value & 1;
+		if (state_.strobing) { state_.index = 0; }
 	}
 } // namespace nes::sys
\ No newline at end of file
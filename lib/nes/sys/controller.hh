@@ -5,11 +5,40 @@
 
 namespace nes::sys
 {
+	/// Source of the buttons latched by a controller.
+	class controller_input
+	{
+	public:
+		virtual ~controller_input() = default;
+
+		controller_input(controller_input const&) = delete;
+		controller_input(controller_input&&) = delete;
+		auto operator=(controller_input const&) -> controller_input& = delete;
+		auto operator=(controller_input&&) -> controller_input& = delete;
+
+		/// Called when the game latches the buttons (by writing to the strobe bit).
+		virtual auto latch() -> button_mask = 0;
+
+	protected:
+		explicit controller_input() = default;
+	};
+
 	class controller
 	{
-		button_mask pressed_;
-		u32 index_{ 0 };
-		bool strobing_{ false };
+	public:
+		/// All mutable state of the controller, which can be saved and restored as a whole.
+		struct state
+		{
+			button_mask pressed{};
+			u8 padding_1[3]{};
+			u32 index{ 0 };
+			bool strobing{ false };
+			u8 padding_2[3]{};
+		};
+
+	private:
+		state state_{};
+		controller_input* input_{ nullptr };
 
 	public:
 		explicit controller() = default;
@@ -19,9 +48,14 @@ namespace nes::sys
 		auto operator=(controller const&) -> controller& = delete;
 		auto operator=(controller&&) -> controller& = delete;
 
-		auto get_pressed() const -> button_mask { return pressed_;}
-		auto ref_pressed() -> button_mask& { return pressed_; }
-		auto set_pressed(button_mask const value) -> void { pressed_ = value; }
+		auto get_state() const -> state const& { return state_; }
+		auto set_state(state const& value) -> void { state_ = value; }
+		auto get_pressed() const -> button_mask { return state_.pressed;}
+		auto ref_pressed() -> button_mask& { return state_.pressed; }
+		auto set_pressed(button_mask const value) -> void { state_.pressed = value; }
+		/// While set, the pressed buttons are sampled from the input whenever the game latches them, which avoids
+		/// passing input that is up to a frame old.
+		auto set_input(controller_input* const value) -> void { input_ = value; }
 
 		// IO register
 
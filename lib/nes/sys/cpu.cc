@@ -1,59 +1,65 @@
 #include "nes/sys/cpu.hh"
 #include "nes/sys/ppu.hh"
+#include "nes/sys/apu.hh"
 #include "nes/sys/controller.hh"
 #include "nes/sys/cartridge.hh"
 #include "nes/sys/types/snapshot.hh"
 
 namespace nes::sys
 {
-	cpu::cpu(ppu& ppu, cartridge& cartridge, controller& controller_1, controller& controller_2)
+	cpu::cpu(ppu& ppu, apu& apu, cartridge& cartridge, controller& controller_1, controller& controller_2)
 		: ppu_{ ppu }
+		, apu_{ apu }
 		, cartridge_{ cartridge }
 		, controller_1_{ controller_1 }
 		, controller_2_{ controller_2 }
 	{
-		registers_.pc = read16(address{ 0xFFFC });
+		state_.registers.pc = read16(address{ 0xFFFC });
 	}
 
 #ifdef NES_ENABLE_SNAPSHOTS
 	auto cpu::build_snapshot(snapshot& snapshot) -> void
 	{
-		snapshot.cpu_cycle = current_cycles_;
-		snapshot.ram = std::vector(std::begin(ram_), std::end(ram_));
-		snapshot.registers.pc = registers_.pc;
-		snapshot.registers.sp = registers_.sp;
-		snapshot.registers.a = registers_.a;
-		snapshot.registers.x = registers_.x;
-		snapshot.registers.y = registers_.y;
-		snapshot.registers.p = registers_.p.value;
-		snapshot.registers.c = registers_.p.get_c();
-		snapshot.registers.z = registers_.p.get_z();
-		snapshot.registers.i = registers_.p.get_i();
-		snapshot.registers.d = registers_.p.get_d();
-		snapshot.registers.b = registers_.p.get_b();
-		snapshot.registers.v = registers_.p.get_v();
-		snapshot.registers.n = registers_.p.get_n();
+		snapshot.cpu_cycle = state_.cycles;
+		snapshot.ram = std::vector(ram_.get_data().begin(), ram_.get_data().end());
+		snapshot.registers.pc = state_.registers.pc;
+		snapshot.registers.sp = state_.registers.sp;
+		snapshot.registers.a = state_.registers.a;
+		snapshot.registers.x = state_.registers.x;
+		snapshot.registers.y = state_.registers.y;
+		snapshot.registers.p = state_.registers.p.value;
+		snapshot.registers.c = state_.registers.p.get_c();
+		snapshot.registers.z = state_.registers.p.get_z();
+		snapshot.registers.i = state_.registers.p.get_i();
+		snapshot.registers.d = state_.registers.p.get_d();
+		snapshot.registers.b = state_.registers.p.get_b();
+		snapshot.registers.v = state_.registers.p.get_v();
+		snapshot.registers.n = state_.registers.p.get_n();
 	}
 #endif
 
 	auto cpu::stall_cycles(cycle_count const count) -> void
 	{
-		current_cycles_ += count;
+		state_.cycles += count;
 	}
 
 	auto cpu::trigger_nmi() -> void
 	{
-		nmi_pending_ = true;
+		state_.nmi_pending = true;
 	}
 
 	auto cpu::step() -> status
 	{
 		// See https://www.nesdev.org/wiki/CPU_unofficial_opcodes
 
-		if (nmi_pending_)
+		if (state_.nmi_pending)
 		{
-			execute_interrupt(address{ 0xFFFA });
-			nmi_pending_ = false;
+			execute_interrupt(address{ 0xFFFA }, detail::interrupt_source::hardware);
+			state_.nmi_pending = false;
+		}
+		else if (!state_.registers.p.get_i() && apu_.is_irq_asserted())
+		{
+			execute_interrupt(address{ 0xFFFE }, detail::interrupt_source::hardware);
 		}
 
 		auto const opcode = advance_pc8();
@@ -328,7 +334,7 @@ namespace nes::sys
 	{
 		// BRK: Break
 		detail::fetch_operand<Mode>(*this);
-		execute_interrupt(address{ 0xFFFE });
+		execute_interrupt(address{ 0xFFFE }, detail::interrupt_source::brk);
 		return status::success;
 	}
 
@@ -338,7 +344,7 @@ namespace nes::sys
 		// ORA: Logical Inclusive OR
 		auto operand = detail::fetch_operand<Mode>(*this);
 		eval_ora(operand.read());
-		current_cycles_ += operand.get_cycles();
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -355,7 +361,7 @@ namespace nes::sys
 		auto const tmp = eval_asl(operand.read());
 		operand.write(tmp);
 		eval_ora(tmp);
-		current_cycles_ += operand.get_cycles() + cycle_count::from_cpu(2);
+		state_.cycles += operand.get_cycles() + cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -364,14 +370,14 @@ namespace nes::sys
 	{
 		// NOP: NOP
 		auto operand = detail::fetch_operand<Mode>(*this);
-		current_cycles_ += operand.get_cycles();
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
 	auto cpu::run_nop() -> status
 	{
 		// NOP: NOP
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -379,7 +385,7 @@ namespace nes::sys
 	{
 		// PHP: Push Processor Status
 		eval_php();
-		current_cycles_ += cycle_count::from_cpu(3);
+		state_.cycles += cycle_count::from_cpu(3);
 		return status::success;
 	}
 
@@ -389,7 +395,7 @@ namespace nes::sys
 		// ASL: Arithmetic Shift Left
 		auto operand = detail::fetch_operand<Mode>(*this);
 		operand.write(eval_asl(operand.read()));
-		current_cycles_ += detail::shift_cycle_count<Mode>();
+		state_.cycles += detail::shift_cycle_count<Mode>();
 		return status::success;
 	}
 
@@ -399,8 +405,8 @@ namespace nes::sys
 		// ANC: AND #i + copy N to C
 		auto operand = detail::fetch_operand<Mode>(*this);
 		eval_and(operand.read());
-		registers_.p.set_c(registers_.p.get_n());
-		current_cycles_ += operand.get_cycles();
+		state_.registers.p.set_c(state_.registers.p.get_n());
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -408,15 +414,15 @@ namespace nes::sys
 	auto cpu::run_bpl() -> status
 	{
 		// BPL: Break If Positive
-		branch<Mode>(!registers_.p.get_n());
+		branch<Mode>(!state_.registers.p.get_n());
 		return status::success;
 	}
 
 	auto cpu::run_clc() -> status
 	{
 		// CLC: Clear Carry Flag
-		registers_.p.set_c(false);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.p.set_c(false);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -426,11 +432,11 @@ namespace nes::sys
 		// JSR: Jump to Subroutine
 		static_assert(Mode == detail::addressing_mode::absolute, "JSR only supports absolute addressing.");
 
-		push_stack16(registers_.pc + 1);
+		push_stack16(state_.registers.pc + 1);
 
 		auto operand = detail::fetch_operand<Mode>(*this);
-		registers_.pc = operand.get_address().get_absolute();
-		current_cycles_ += cycle_count::from_cpu(6);
+		state_.registers.pc = operand.get_address().get_absolute();
+		state_.cycles += cycle_count::from_cpu(6);
 		return status::success;
 	}
 
@@ -440,7 +446,7 @@ namespace nes::sys
 		// AND: Logical AND
 		auto operand = detail::fetch_operand<Mode>(*this);
 		eval_and(operand.read());
-		current_cycles_ += operand.get_cycles();
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -452,7 +458,7 @@ namespace nes::sys
 		auto const tmp = eval_rol(operand.read());
 		operand.write(tmp);
 		eval_and(tmp);
-		current_cycles_ += operand.get_cycles() + cycle_count::from_cpu(2);
+		state_.cycles += operand.get_cycles() + cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -462,11 +468,11 @@ namespace nes::sys
 		// BIT: Bit Test
 		auto operand = detail::fetch_operand<Mode>(*this);
 		auto const arg = operand.read();
-		auto const res = (registers_.a & arg) != 0;
-		registers_.p.set_z(res == 0);
-		registers_.p.set_v((arg & 0x40) != 0);
-		registers_.p.set_n((arg & 0x80) != 0);
-		current_cycles_ += operand.get_cycles();
+		auto const res = (state_.registers.a & arg) != 0;
+		state_.registers.p.set_z(res == 0);
+		state_.registers.p.set_v((arg & 0x40) != 0);
+		state_.registers.p.set_n((arg & 0x80) != 0);
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -477,7 +483,7 @@ namespace nes::sys
 		auto operand = detail::fetch_operand<Mode>(*this);
 		auto const result = eval_rol(operand.read());
 		operand.write(result);
-		current_cycles_ += detail::shift_cycle_count<Mode>();
+		state_.cycles += detail::shift_cycle_count<Mode>();
 		return status::success;
 	}
 
@@ -485,22 +491,22 @@ namespace nes::sys
 	{
 		// PLP: Pull Processor Status
 		eval_plp();
-		current_cycles_ += cycle_count::from_cpu(4);
+		state_.cycles += cycle_count::from_cpu(4);
 		return status::success;
 	}
 
 	template<detail::addressing_mode Mode>
 	auto cpu::run_bmi() -> status
 	{
-		branch<Mode>(registers_.p.get_n());
+		branch<Mode>(state_.registers.p.get_n());
 		return status::success;
 	}
 
 	auto cpu::run_sec() -> status
 	{
 		// SEC: Set Carry Flag
-		registers_.p.set_c(true);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.p.set_c(true);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -508,8 +514,8 @@ namespace nes::sys
 	{
 		// RTI: Return From Interrupt
 		eval_plp();
-		registers_.pc = pop_stack16();
-		current_cycles_ += cycle_count::from_cpu(6);
+		state_.registers.pc = pop_stack16();
+		state_.cycles += cycle_count::from_cpu(6);
 		return status::success;
 	}
 
@@ -519,7 +525,7 @@ namespace nes::sys
 		// EOR: Exclusive OR
 		auto operand = detail::fetch_operand<Mode>(*this);
 		eval_eor(operand.read());
-		current_cycles_ += operand.get_cycles();
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -531,7 +537,7 @@ namespace nes::sys
 		auto const tmp = eval_lsr(operand.read());
 		operand.write(tmp);
 		eval_eor(tmp);
-		current_cycles_ += operand.get_cycles() + cycle_count::from_cpu(2);
+		state_.cycles += operand.get_cycles() + cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -543,9 +549,9 @@ namespace nes::sys
 		auto const old_val = operand.read();
 		auto const new_val = static_cast<u8>(old_val >> 1);
 		operand.write(new_val);
-		registers_.p.set_c((old_val & 0x1) != 0);
+		state_.registers.p.set_c((old_val & 0x1) != 0);
 		update_zn(new_val);
-		current_cycles_ += detail::shift_cycle_count<Mode>();
+		state_.cycles += detail::shift_cycle_count<Mode>();
 		return status::success;
 	}
 
@@ -555,16 +561,16 @@ namespace nes::sys
 		// ALR: AND #i + LSR A
 		auto operand = detail::fetch_operand<Mode>(*this);
 		eval_and(operand.read());
-		registers_.a = eval_lsr(registers_.a);
-		current_cycles_ += operand.get_cycles();
+		state_.registers.a = eval_lsr(state_.registers.a);
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
 	auto cpu::run_pha() -> status
 	{
 		// PHA: Push Accumulator
-		push_stack8(registers_.a);
-		current_cycles_ += cycle_count::from_cpu(3);
+		push_stack8(state_.registers.a);
+		state_.cycles += cycle_count::from_cpu(3);
 		return status::success;
 	}
 
@@ -573,8 +579,8 @@ namespace nes::sys
 	{
 		// JMP: Jump
 		auto operand = detail::fetch_operand<Mode>(*this);
-		registers_.pc = operand.get_address().get_absolute();
-		current_cycles_ += detail::jump_cycle_count<Mode>();
+		state_.registers.pc = operand.get_address().get_absolute();
+		state_.cycles += detail::jump_cycle_count<Mode>();
 		return status::success;
 	}
 
@@ -582,15 +588,15 @@ namespace nes::sys
 	auto cpu::run_bvc() -> status
 	{
 		// BVC: Branch If Overflow Clear
-		branch<Mode>(!registers_.p.get_v());
+		branch<Mode>(!state_.registers.p.get_v());
 		return status::success;
 	}
 
 	auto cpu::run_cli() -> status
 	{
 		// CLI: Clear Interrupt Disable
-		registers_.p.set_i(false);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.p.set_i(false);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -598,8 +604,8 @@ namespace nes::sys
 	{
 		// RTS: Return from Subroutine
 		auto const addr = address{ pop_stack16() } + 1;
-		registers_.pc = addr.get_absolute();
-		current_cycles_ += cycle_count::from_cpu(6);
+		state_.registers.pc = addr.get_absolute();
+		state_.cycles += cycle_count::from_cpu(6);
 		return status::success;
 	}
 
@@ -609,7 +615,7 @@ namespace nes::sys
 		// ADC: Add With Carry
 		auto operand = detail::fetch_operand<Mode>(*this);
 		eval_adc(operand.read());
-		current_cycles_ += operand.get_cycles();
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -621,7 +627,7 @@ namespace nes::sys
 		auto const tmp = eval_ror(operand.read());
 		operand.write(tmp);
 		eval_adc(tmp);
-		current_cycles_ += operand.get_cycles() + cycle_count::from_cpu(2);
+		state_.cycles += operand.get_cycles() + cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -632,7 +638,7 @@ namespace nes::sys
 		auto operand = detail::fetch_operand<Mode>(*this);
 		auto const result = eval_ror(operand.read());
 		operand.write(result);
-		current_cycles_ += detail::shift_cycle_count<Mode>();
+		state_.cycles += detail::shift_cycle_count<Mode>();
 		return status::success;
 	}
 
@@ -647,9 +653,9 @@ namespace nes::sys
 	auto cpu::run_pla() -> status
 	{
 		// PLA: Pull Accumulator
-		registers_.a = pop_stack8();
-		update_zn(registers_.a);
-		current_cycles_ += cycle_count::from_cpu(4);
+		state_.registers.a = pop_stack8();
+		update_zn(state_.registers.a);
+		state_.cycles += cycle_count::from_cpu(4);
 		return status::success;
 	}
 
@@ -657,15 +663,15 @@ namespace nes::sys
 	auto cpu::run_bvs() -> status
 	{
 		// BVS: Branch If Overflow Set
-		branch<Mode>(registers_.p.get_v());
+		branch<Mode>(state_.registers.p.get_v());
 		return status::success;
 	}
 
 	auto cpu::run_sei() -> status
 	{
 		// SEI: Set Interrupt Disable
-		registers_.p.set_i(true);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.p.set_i(true);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -674,8 +680,8 @@ namespace nes::sys
 	{
 		// STA: Store Accumulator
 		auto operand = detail::fetch_operand<Mode>(*this, detail::force_page_crossing::yes);
-		operand.write(registers_.a);
-		current_cycles_ += operand.get_cycles();
+		operand.write(state_.registers.a);
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -692,9 +698,9 @@ namespace nes::sys
 	{
 		// SAX: AND A X
 		auto operand = detail::fetch_operand<Mode>(*this);
-		auto const result = static_cast<u8>(registers_.a & registers_.x);
+		auto const result = static_cast<u8>(state_.registers.a & state_.registers.x);
 		operand.write(result);
-		current_cycles_ += operand.get_cycles();
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -703,8 +709,8 @@ namespace nes::sys
 	{
 		// STX: Store Y
 		auto operand = detail::fetch_operand<Mode>(*this);
-		operand.write(registers_.y);
-		current_cycles_ += operand.get_cycles();
+		operand.write(state_.registers.y);
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -713,26 +719,26 @@ namespace nes::sys
 	{
 		// STX: Store X
 		auto operand = detail::fetch_operand<Mode>(*this);
-		operand.write(registers_.x);
-		current_cycles_ += operand.get_cycles();
+		operand.write(state_.registers.x);
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
 	auto cpu::run_dey() -> status
 	{
 		// DEY: Decrement Y Register
-		registers_.y -= 1;
-		update_zn(registers_.y);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.y -= 1;
+		update_zn(state_.registers.y);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
 	auto cpu::run_txa() -> status
 	{
 		// TXA: Transfer X to Accumulator
-		registers_.a = registers_.x;
-		update_zn(registers_.a);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.a = state_.registers.x;
+		update_zn(state_.registers.a);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -748,24 +754,24 @@ namespace nes::sys
 	auto cpu::run_bcc() -> status
 	{
 		// BCC: Branch If Carry Clear
-		branch<Mode>(!registers_.p.get_c());
+		branch<Mode>(!state_.registers.p.get_c());
 		return status::success;
 	}
 
 	auto cpu::run_tya() -> status
 	{
 		// TYA: Transfer Y to Accumulator
-		registers_.a = registers_.y;
-		update_zn(registers_.a);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.a = state_.registers.y;
+		update_zn(state_.registers.a);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
 	auto cpu::run_txs() -> status
 	{
 		// TXS: Transfer X to Stack Pointer
-		registers_.sp = registers_.x;
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.sp = state_.registers.x;
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -798,9 +804,9 @@ namespace nes::sys
 	{
 		// LDY: Load Y Register
 		auto operand = detail::fetch_operand<Mode>(*this);
-		registers_.y = operand.read();
-		update_zn(registers_.y);
-		current_cycles_ += operand.get_cycles();
+		state_.registers.y = operand.read();
+		update_zn(state_.registers.y);
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -809,9 +815,9 @@ namespace nes::sys
 	{
 		// LDA: Load Accumulator
 		auto operand = detail::fetch_operand<Mode>(*this);
-		registers_.a = operand.read();
-		update_zn(registers_.a);
-		current_cycles_ += operand.get_cycles();
+		state_.registers.a = operand.read();
+		update_zn(state_.registers.a);
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -820,9 +826,9 @@ namespace nes::sys
 	{
 		// LDX: Load X Register
 		auto operand = detail::fetch_operand<Mode>(*this);
-		registers_.x = operand.read();
-		update_zn(registers_.x);
-		current_cycles_ += operand.get_cycles();
+		state_.registers.x = operand.read();
+		update_zn(state_.registers.x);
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -831,27 +837,27 @@ namespace nes::sys
 	{
 		// LAX: LDA + TAX
 		auto operand = detail::fetch_operand<Mode>(*this);
-		registers_.x = registers_.a = operand.read();
-		update_zn(registers_.a);
-		current_cycles_ += operand.get_cycles();
+		state_.registers.x = state_.registers.a = operand.read();
+		update_zn(state_.registers.a);
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
 	auto cpu::run_tay() -> status
 	{
 		// TAY: Transfer Accumulator to Y
-		registers_.y = registers_.a;
-		update_zn(registers_.y);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.y = state_.registers.a;
+		update_zn(state_.registers.y);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
 	auto cpu::run_tax() -> status
 	{
 		// TAX: Transfer Accumulator to X
-		registers_.x = registers_.a;
-		update_zn(registers_.x);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.x = state_.registers.a;
+		update_zn(state_.registers.x);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -859,24 +865,24 @@ namespace nes::sys
 	auto cpu::run_bcs() -> status
 	{
 		// BCS: Branch If Carry Set
-		branch<Mode>(registers_.p.get_c());
+		branch<Mode>(state_.registers.p.get_c());
 		return status::success;
 	}
 
 	auto cpu::run_clv() -> status
 	{
 		// CLV: Clear Overflow Flag
-		registers_.p.set_v(false);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.p.set_v(false);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
 	auto cpu::run_tsx() -> status
 	{
 		// TSX: Transfer Stack Pointer to X
-		registers_.x = registers_.sp;
-		update_zn(registers_.x);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.x = state_.registers.sp;
+		update_zn(state_.registers.x);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -893,8 +899,8 @@ namespace nes::sys
 	{
 		// CPY: Compare Y Register
 		auto operand = detail::fetch_operand<Mode>(*this);
-		eval_cmp(registers_.y, operand.read());
-		current_cycles_ += operand.get_cycles();
+		eval_cmp(state_.registers.y, operand.read());
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -911,8 +917,8 @@ namespace nes::sys
 	{
 		// CMP: Compare
 		auto operand = detail::fetch_operand<Mode>(*this);
-		eval_cmp(registers_.a, operand.read());
-		current_cycles_ += operand.get_cycles();
+		eval_cmp(state_.registers.a, operand.read());
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -923,8 +929,8 @@ namespace nes::sys
 		auto operand = detail::fetch_operand<Mode>(*this, detail::force_page_crossing::yes);
 		auto const tmp = static_cast<u8>(operand.read() - 1);
 		operand.write(tmp);
-		eval_cmp(registers_.a, tmp);
-		current_cycles_ += operand.get_cycles() + cycle_count::from_cpu(2);
+		eval_cmp(state_.registers.a, tmp);
+		state_.cycles += operand.get_cycles() + cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -937,25 +943,25 @@ namespace nes::sys
 		auto const new_val = static_cast<u8>(old_val - 1);
 		write8(operand.get_address(), new_val);
 		update_zn(new_val);
-		current_cycles_ += detail::inc_dec_cycle_count<Mode>();
+		state_.cycles += detail::inc_dec_cycle_count<Mode>();
 		return status::success;
 	}
 
 	auto cpu::run_iny() -> status
 	{
 		// INY: Increment Y
-		registers_.y += 1;
-		update_zn(registers_.y);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.y += 1;
+		update_zn(state_.registers.y);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
 	auto cpu::run_dex() -> status
 	{
 		// DEX: Decrement X Register
-		registers_.x -= 1;
-		update_zn(registers_.x);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.x -= 1;
+		update_zn(state_.registers.x);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -963,15 +969,15 @@ namespace nes::sys
 	auto cpu::run_bne() -> status
 	{
 		// BNE: Branch If Not Equal
-		branch<Mode>(!registers_.p.get_z());
+		branch<Mode>(!state_.registers.p.get_z());
 		return status::success;
 	}
 
 	auto cpu::run_cld() -> status
 	{
 		// CLD: Clear Decimal Mode
-		registers_.p.set_d(false);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.p.set_d(false);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -980,8 +986,8 @@ namespace nes::sys
 	{
 		// CPX: Compare X Register
 		auto operand = detail::fetch_operand<Mode>(*this);
-		eval_cmp(registers_.x, operand.read());
-		current_cycles_ += operand.get_cycles();
+		eval_cmp(state_.registers.x, operand.read());
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -991,7 +997,7 @@ namespace nes::sys
 		// SBC: Subtract With Carry
 		auto operand = detail::fetch_operand<Mode>(*this);
 		eval_adc(~operand.read());
-		current_cycles_ += operand.get_cycles();
+		state_.cycles += operand.get_cycles();
 		return status::success;
 	}
 
@@ -1003,7 +1009,7 @@ namespace nes::sys
 		auto const tmp = static_cast<u8>(operand.read() + 1);
 		operand.write(tmp);
 		eval_adc(~tmp);
-		current_cycles_ += operand.get_cycles() + cycle_count::from_cpu(2);
+		state_.cycles += operand.get_cycles() + cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -1016,16 +1022,16 @@ namespace nes::sys
 		auto const new_val = static_cast<u8>(old_val + 1);
 		write8(operand.get_address(), new_val);
 		update_zn(new_val);
-		current_cycles_ += detail::inc_dec_cycle_count<Mode>();
+		state_.cycles += detail::inc_dec_cycle_count<Mode>();
 		return status::success;
 	}
 
 	auto cpu::run_inx() -> status
 	{
 		// INX: Increment X
-		registers_.x += 1;
-		update_zn(registers_.x);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.x += 1;
+		update_zn(state_.registers.x);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 
@@ -1033,15 +1039,15 @@ namespace nes::sys
 	auto cpu::run_beq() -> status
 	{
 		// BEQ: Branch If Equal
-		branch<Mode>(registers_.p.get_z());
+		branch<Mode>(state_.registers.p.get_z());
 		return status::success;
 	}
 
 	auto cpu::run_sed() -> status
 	{
 		// SED: Set Decimal Flag
-		registers_.p.set_d(true);
-		current_cycles_ += cycle_count::from_cpu(2);
+		state_.registers.p.set_d(true);
+		state_.cycles += cycle_count::from_cpu(2);
 		return status::success;
 	}
 	
@@ -1051,22 +1057,22 @@ namespace nes::sys
 
 	auto cpu::advance_pc8() -> u8
 	{
-		auto const val = read8(address{ registers_.pc });
-		registers_.pc += 1;
+		auto const val = read8(address{ state_.registers.pc });
+		state_.registers.pc += 1;
 		return val;
 	}
 
 	auto cpu::advance_pc16() -> u16
 	{
-		auto const val = read16(address{ registers_.pc });
-		registers_.pc += 2;
+		auto const val = read16(address{ state_.registers.pc });
+		state_.registers.pc += 2;
 		return val;
 	}
 
 	auto cpu::push_stack8(u8 const value) -> void
 	{
-		write8(stack_offset + registers_.sp, value);
-		registers_.sp -= 1;
+		write8(stack_offset + state_.registers.sp, value);
+		state_.registers.sp -= 1;
 	}
 
 	auto cpu::push_stack16(u16 const value) -> void
@@ -1079,8 +1085,8 @@ namespace nes::sys
 
 	auto cpu::pop_stack8() -> u8
 	{
-		registers_.sp += 1;
-		return read8(stack_offset + registers_.sp);
+		state_.registers.sp += 1;
+		return read8(stack_offset + state_.registers.sp);
 	}
 
 	auto cpu::pop_stack16() -> u16
@@ -1092,8 +1098,8 @@ namespace nes::sys
 
 	auto cpu::update_zn(u8 const value) -> void
 	{
-		registers_.p.set_z(value == 0);
-		registers_.p.set_n((value & 0x80) != 0);
+		state_.registers.p.set_z(value == 0);
+		state_.registers.p.set_n((value & 0x80) != 0);
 	}
 
 	template<detail::addressing_mode Mode>
@@ -1104,36 +1110,41 @@ namespace nes::sys
 		auto operand = detail::fetch_operand<Mode>(*this);
 		if (condition)
 		{
-			registers_.pc = operand.get_address().get_absolute();
-			current_cycles_ += operand.get_cycles();
+			state_.registers.pc = operand.get_address().get_absolute();
+			state_.cycles += operand.get_cycles();
 		}
 		else
 		{
-			current_cycles_ += cycle_count::from_cpu(2);
+			state_.cycles += cycle_count::from_cpu(2);
 		}
 	}
 
-	auto cpu::execute_interrupt(address const vector) -> void
+	auto cpu::execute_interrupt(address const vector, detail::interrupt_source const source) -> void
 	{
-		push_stack16(registers_.pc);
-		eval_php();
-		registers_.pc = read16(vector);
-		registers_.p.set_i(true);
-		current_cycles_ += cycle_count::from_cpu(7);
+		push_stack16(state_.registers.pc);
+		// The break flag only distinguishes BRK from IRQ/NMI on the stack.
+		switch (source)
+		{
+			case detail::interrupt_source::brk: eval_php(); break;
+			case detail::interrupt_source::hardware: push_stack8(static_cast<u8>((state_.registers.p.value & 0b11101111) | 0b00100000)); break;
+		}
+		state_.registers.pc = read16(vector);
+		state_.registers.p.set_i(true);
+		state_.cycles += cycle_count::from_cpu(7);
 	}
 
 	auto cpu::eval_ror(u8 const arg) -> u8
 	{
-		auto const res = static_cast<u8>(((registers_.p.get_c() ? 1 :0) << 7) | (arg >> 1));
-		registers_.p.set_c((arg & 0x1) != 0);
+		auto const res = static_cast<u8>(((state_.registers.p.get_c() ? 1 :0) << 7) | (arg >> 1));
+		state_.registers.p.set_c((arg & 0x1) != 0);
 		update_zn(res);
 		return res;
 	}
 
 	auto cpu::eval_rol(u8 const arg) -> u8
 	{
-		auto const res = static_cast<u8>((arg << 1) | (registers_.p.get_c() ? 1 : 0));
-		registers_.p.set_c((arg & 0x80) != 0);
+		auto const res = static_cast<u8>((arg << 1) | (state_.registers.p.get_c() ? 1 : 0));
+		state_.registers.p.set_c((arg & 0x80) != 0);
 		update_zn(res);
 		return res;
 	}
@@ -1141,7 +1152,7 @@ namespace nes::sys
 	auto cpu::eval_asl(u8 const arg) -> u8
 	{
 		auto const new_val = static_cast<u8>(arg << 1);
-		registers_.p.set_c((arg & 0x80) != 0);
+		state_.registers.p.set_c((arg & 0x80) != 0);
 		update_zn(new_val);
 		return new_val;
 	}
@@ -1149,59 +1160,59 @@ namespace nes::sys
 	auto cpu::eval_lsr(u8 const arg) -> u8
 	{
 		auto const new_val = static_cast<u8>(arg >> 1);
-		registers_.p.set_c((arg & 0x01) != 0);
+		state_.registers.p.set_c((arg & 0x01) != 0);
 		update_zn(new_val);
 		return new_val;
 	}
 
 	auto cpu::eval_adc(u8 const arg) -> void
 	{
-		auto const old_val = registers_.a;
-		auto const tmp = old_val + arg + (registers_.p.get_c() ? 1 : 0);
+		auto const old_val = state_.registers.a;
+		auto const tmp = old_val + arg + (state_.registers.p.get_c() ? 1 : 0);
 		auto const new_val = static_cast<u8>(tmp);
 
-		registers_.a = new_val;
-		registers_.p.set_c(tmp > 0xFF);
-		registers_.p.set_v(((old_val ^ arg) & 0x80) == 0 && ((old_val ^ new_val) & 0x80) != 0);
-		update_zn(registers_.a);
+		state_.registers.a = new_val;
+		state_.registers.p.set_c(tmp > 0xFF);
+		state_.registers.p.set_v(((old_val ^ arg) & 0x80) == 0 && ((old_val ^ new_val) & 0x80) != 0);
+		update_zn(state_.registers.a);
 	}
 
 	auto cpu::eval_and(u8 const arg) -> void
 	{
-		registers_.a &= arg;
-		update_zn(registers_.a);
+		state_.registers.a &= arg;
+		update_zn(state_.registers.a);
 	}
 
 	auto cpu::eval_ora(u8 const arg) -> void
 	{
-		registers_.a |= arg;
-		update_zn(registers_.a);
+		state_.registers.a |= arg;
+		update_zn(state_.registers.a);
 	}
 
 	auto cpu::eval_eor(u8 const arg) -> void
 	{
-		registers_.a ^= arg;
-		update_zn(registers_.a);
+		state_.registers.a ^= arg;
+		update_zn(state_.registers.a);
 	}
 
 	auto cpu::eval_cmp(u8 const a, u8 const b) -> void
 	{
 		update_zn(a - b);
-		registers_.p.set_c(a >= b);
+		state_.registers.p.set_c(a >= b);
 	}
 
 	auto cpu::eval_plp() -> void
 	{
 		// Ignore bits 4 and 5
-		registers_.p.value =
+		state_.registers.p.value =
 			(pop_stack8() & 0b11001111) |
-			(registers_.p.value & 0b00110000);
+			(state_.registers.p.value & 0b00110000);
 	}
 
 	auto cpu::eval_php() -> void
 	{
 		// Always set bits 4 and 5.
-		push_stack8(registers_.p.value | 0b00110000);
+		push_stack8(state_.registers.p.value | 0b00110000);
 	}
 
 	// -----------------------------------------------------------------------------------------------------------------
@@ -1240,8 +1251,8 @@ namespace nes::sys
 				case addressing_mode::relative:
 				{
 					auto const offset = static_cast<i8>(cpu.advance_pc8());
-					auto const base = address{ cpu.registers_.pc };
-					addr = address{ static_cast<u16>(cpu.registers_.pc + offset) };
+					auto const base = address{ cpu.state_.registers.pc };
+					addr = address{ static_cast<u16>(cpu.state_.registers.pc + offset) };
 					auto const page_crossing =
 						base.get_page() != addr.get_page() || force_page_crossing == force_page_crossing::yes;
 					cycles = cycle_count::from_cpu(page_crossing ? 4 : 3);
@@ -1260,14 +1271,14 @@ namespace nes::sys
 				case addressing_mode::zero_page_indexed_x:
 				{
 					// PEEK((arg + X) % 256)
-					addr = address{ 0x00, static_cast<u8>(cpu.advance_pc8() + cpu.registers_.x) };
+					addr = address{ 0x00, static_cast<u8>(cpu.advance_pc8() + cpu.state_.registers.x) };
 					cycles = cycle_count::from_cpu(4);
 					break;
 				}
 				case addressing_mode::zero_page_indexed_y:
 				{
 					// PEEK((arg + Y) % 256)
-					addr = address{ 0x00, static_cast<u8>(cpu.advance_pc8() + cpu.registers_.y) };
+					addr = address{ 0x00, static_cast<u8>(cpu.advance_pc8() + cpu.state_.registers.y) };
 					cycles = cycle_count::from_cpu(4);
 					break;
 				}
@@ -1275,7 +1286,7 @@ namespace nes::sys
 				{
 					// PEEK(arg + X)
 					auto const arg = address{ cpu.advance_pc16() };
-					addr = arg + cpu.registers_.x;
+					addr = arg + cpu.state_.registers.x;
 					auto const page_crossing =
 						addr.get_page() != arg.get_page() || force_page_crossing == force_page_crossing::yes;
 					cycles = cycle_count::from_cpu(page_crossing ? 5 : 4);
@@ -1285,7 +1296,7 @@ namespace nes::sys
 				{
 					// PEEK(arg + Y)
 					auto const arg = address{ cpu.advance_pc16() };
-					addr = arg + cpu.registers_.y;
+					addr = arg + cpu.state_.registers.y;
 					auto const page_crossing =
 						addr.get_page() != arg.get_page() || force_page_crossing == force_page_crossing::yes;
 					cycles = cycle_count::from_cpu(page_crossing ? 5 : 4);
@@ -1295,8 +1306,8 @@ namespace nes::sys
 				{
 					// PEEK(PEEK((arg + X) % 256) + PEEK((arg + X + 1) % 256) * 256)
 					auto const arg = cpu.advance_pc8();
-					auto const page = cpu.read8(address{ 0x00, static_cast<u8>(arg + cpu.registers_.x + 1) });
-					auto const offset = cpu.read8(address{ 0x00, static_cast<u8>(arg + cpu.registers_.x) });
+					auto const page = cpu.read8(address{ 0x00, static_cast<u8>(arg + cpu.state_.registers.x + 1) });
+					auto const offset = cpu.read8(address{ 0x00, static_cast<u8>(arg + cpu.state_.registers.x) });
 					addr = address{ page, offset };
 					cycles = cycle_count::from_cpu(6);
 					break;
@@ -1308,7 +1319,7 @@ namespace nes::sys
 					auto const page = cpu.read8(address{ 0x00, static_cast<u8>(arg + 1) });
 					auto const offset = cpu.read8(address{ 0x00, static_cast<u8>(arg) });
 					auto const base = address{ page, offset };
-					addr = base + cpu.registers_.y;
+					addr = base + cpu.state_.registers.y;
 					auto const page_crossing =
 						addr.get_page() != base.get_page() || force_page_crossing == force_page_crossing::yes;
 					cycles = cycle_count::from_cpu(page_crossing ? 6 : 5);
@@ -1344,7 +1355,7 @@ namespace nes::sys
 
 	auto cpu::read8(address const addr) -> u8
 	{
-		if (addr <= address{ 0x1FFF }) { return ram_[addr.get_absolute() % ram_size]; }
+		if (addr <= address{ 0x1FFF }) { return ram_[addr.get_absolute() % ram::size]; }
 		if (addr <= address{ 0x3FFF })
 		{
 			switch (addr.get_absolute() % 8)
@@ -1361,9 +1372,9 @@ namespace nes::sys
 		
 			}
 		}
-		if (addr <= address{ 0x4013 }) { return 0x0; } // TODO: APU registers
+		if (addr <= address{ 0x4013 }) { return 0x0; }
 		if (addr == address{ 0x4014 }) { return ppu_.read_latch(); }
-		if (addr == address{ 0x4015 }) { return 0x0; } // TODO: APU registers
+		if (addr == address{ 0x4015 }) { return apu_.read_status(); }
 		if (addr == address{ 0x4016 }) { return controller_1_.read(); }
 		if (addr == address{ 0x4017 }) { return controller_2_.read(); }
 		if (addr <= address{ 0x401F }) { return 0x0; }
@@ -1379,7 +1390,7 @@ namespace nes::sys
 
 	auto cpu::write8(address const addr, u8 const value) -> void
 	{
-		if (addr <= address{ 0x1FFF }) { ram_[addr.get_absolute() % ram_size] = value; return; }
+		if (addr <= address{ 0x1FFF }) { ram_.write(addr.get_absolute() % ram::size, value); return; }
 		if (addr <= address{ 0x3FFF })
 		{
 			switch (addr.get_absolute() % 8)
@@ -1395,11 +1406,11 @@ namespace nes::sys
 				default: return;
 			}
 		}
-		if (addr <= address{ 0x4013 }) { return; } // TODO: APU registers
+		if (addr <= address{ 0x4013 }) { apu_.write_register(addr, value); return; }
 		if (addr == address{ 0x4014 }) { ppu_.write_oamdma(value); return; }
-		if (addr == address{ 0x4015 }) { return; } // TODO: APU registers
-		if (addr == address{ 0x4016 }) { controller_1_.write(value); return; }
-		if (addr == address{ 0x4017 }) { controller_2_.write(value); return; }
+		if (addr == address{ 0x4015 }) { apu_.write_status(value); return; }
+		if (addr == address{ 0x4016 }) { controller_1_.write(value); controller_2_.write(value); return; }
+		if (addr == address{ 0x4017 }) { apu_.write_frame_counter(value); return; }
 		if (addr <= address{ 0x401F }) { return; }
 		cartridge_.get_mapper().write_cpu(addr, value, cartridge_);
 	}
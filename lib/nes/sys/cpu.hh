@@ -3,12 +3,14 @@
 #include "nes/sys/types/cycle-count.hh"
 #include "nes/sys/types/address.hh"
 #include "nes/sys/types/snapshot.hh"
+#include "nes/sys/types/paged-memory.hh"
 #include "nes/common/status.hh"
 #include "nes/common/types.hh"
 
 namespace nes::sys
 {
 	class ppu;
+	class apu;
 	class cpu;
 	class controller;
 	class cartridge;
@@ -37,6 +39,12 @@ namespace nes::sys
 			yes,
 		};
 
+		enum class interrupt_source
+		{
+			brk,
+			hardware,
+		};
+
 		template<detail::addressing_mode Mode>
 		class operand;
 		template<detail::addressing_mode Mode>
@@ -50,63 +58,77 @@ namespace nes::sys
 		template<detail::addressing_mode Mode>
 		friend auto detail::fetch_operand(cpu&, detail::force_page_crossing) -> detail::operand<Mode>;
 
-		static constexpr auto ram_size = u32{ 0x800 };
 		static constexpr auto stack_offset = address{ 0x100 };
 
-		cycle_count current_cycles_;
-		ppu& ppu_;
-		cartridge& cartridge_;
-		controller& controller_1_;
-		controller& controller_2_;
-		u8 ram_[ram_size]{};
-		bool nmi_pending_{ false };
+	public:
+		using ram = paged_memory<0x800>;
 
-		// Registers
-		struct
+		/// All mutable state of the CPU except for its RAM, which can be saved and restored as a whole.
+		struct state
 		{
-			u16 pc{ 0 };
-			u8 sp{ 0xFD };
-			u8 a{ 0 };
-			u8 x{ 0 };
-			u8 y{ 0 };
+			cycle_count cycles{};
+			bool nmi_pending{ false };
+			u8 padding_1{ 0 };
 			struct
 			{
-				auto get_c() const -> bool { return value & 0b00000001; } // carry
-				auto get_z() const -> bool { return value & 0b00000010; } // zero
-				auto get_i() const -> bool { return value & 0b00000100; } // interrupt inhibit
-				auto get_d() const -> bool { return value & 0b00001000; } // decimal
-				auto get_b() const -> bool { return value & 0b00010000; } // break
-				auto get_v() const -> bool { return value & 0b01000000; } // overflow
-				auto get_n() const -> bool { return value & 0b10000000; } // negative
-
-				auto set_c(bool const v) -> void { value = (value & ~0b00000001) | (v ? 0b00000001 : 0); }
-				auto set_z(bool const v) -> void { value = (value & ~0b00000010) | (v ? 0b00000010 : 0); }
-				auto set_i(bool const v) -> void { value = (value & ~0b00000100) | (v ? 0b00000100 : 0); }
-				auto set_d(bool const v) -> void { value = (value & ~0b00001000) | (v ? 0b00001000 : 0); }
-				auto set_b(bool const v) -> void { value = (value & ~0b00010000) | (v ? 0b00010000 : 0); }
-				auto set_v(bool const v) -> void { value = (value & ~0b01000000) | (v ? 0b01000000 : 0); }
-				auto set_n(bool const v) -> void { value = (value & ~0b10000000) | (v ? 0b10000000 : 0); }
-
-				u8 value{ 0b00100100 };
-			} p{};
-		} registers_{};
+				u16 pc{ 0 };
+				u8 sp{ 0xFD };
+				u8 a{ 0 };
+				u8 x{ 0 };
+				u8 y{ 0 };
+				struct
+				{
+					auto get_c() const -> bool { return value & 0b00000001; } // carry
+					auto get_z() const -> bool { return value & 0b00000010; } // zero
+					auto get_i() const -> bool { return value & 0b00000100; } // interrupt inhibit
+					auto get_d() const -> bool { return value & 0b00001000; } // decimal
+					auto get_b() const -> bool { return value & 0b00010000; } // break
+					auto get_v() const -> bool { return value & 0b01000000; } // overflow
+					auto get_n() const -> bool { return value & 0b10000000; } // negative
+
+					auto set_c(bool const v) -> void { value = (value & ~0b00000001) | (v ? 0b00000001 : 0); }
+					auto set_z(bool const v) -> void { value = (value & ~0b00000010) | (v ? 0b00000010 : 0); }
+					auto set_i(bool const v) -> void { value = (value & ~0b00000100) | (v ? 0b00000100 : 0); }
+					auto set_d(bool const v) -> void { value = (value & ~0b00001000) | (v ? 0b00001000 : 0); }
+					auto set_b(bool const v) -> void { value = (value & ~0b00010000) | (v ? 0b00010000 : 0); }
+					auto set_v(bool const v) -> void { value = (value & ~0b01000000) | (v ? 0b01000000 : 0); }
+					auto set_n(bool const v) -> void { value = (value & ~0b10000000) | (v ? 0b10000000 : 0); }
+
+					u8 value{ 0b00100100 };
+				} p{};
+				u8 padding{ 0 };
+			} registers{};
+			u8 padding_2[6]{};
+		};
+
+	private:
+		state state_{};
+		ram ram_{};
+		ppu& ppu_;
+		apu& apu_;
+		cartridge& cartridge_;
+		controller& controller_1_;
+		controller& controller_2_;
 
 	public:
-		explicit cpu(ppu&, cartridge&, controller& controller_1, controller& controller_2);
+		explicit cpu(ppu&, apu&, cartridge&, controller& controller_1, controller& controller_2);
 
 		cpu(cpu const&) = delete;
 		cpu(cpu&&) = delete;
 		auto operator=(cpu const&) -> cpu& = delete;
 		auto operator=(cpu&&) -> cpu& = delete;
 
-		auto get_cycles() const -> cycle_count { return current_cycles_; }
+		auto get_cycles() const -> cycle_count { return state_.cycles; }
+		auto get_state() const -> state const& { return state_; }
+		auto set_state(state const& value) -> void { state_ = value; }
+		auto get_ram() const -> ram const& { return ram_; }
+		auto ref_ram() -> ram& { return ram_; }
 #ifdef NES_ENABLE_SNAPSHOTS
 		auto build_snapshot(snapshot&) -> void;
 #endif
 		auto stall_cycles(cycle_count) -> void;
 		auto trigger_nmi() -> void;
 		auto step() -> status;
-		auto is_nmi_pending() const -> bool { return nmi_pending_; } // XXX: Debugging
 
 		// Memory access
 
@@ -214,7 +236,7 @@ namespace nes::sys
 		auto update_zn(u8 value) -> void;
 		template<detail::addressing_mode Mode>
 		auto branch(bool condition) -> void;
-		auto execute_interrupt(address) -> void;
+		auto execute_interrupt(address, detail::interrupt_source) -> void;
 
 		auto eval_ror(u8 arg) -> u8;
 		auto eval_rol(u8 arg) -> u8;
@@ -263,8 +285,8 @@ namespace nes::sys
 			{
 			}
 
-			auto read() -> u8 { return cpu_.registers_.a; }
-			auto write(u8 const value) -> void { cpu_.registers_.a = value; }
+			auto read() -> u8 { return cpu_.state_.registers.a; }
+			auto write(u8 const value) -> void { cpu_.state_.registers.a = value; }
 			auto get_cycles() -> cycle_count { return cycle_count::from_cpu(2); }
 		};
 
@@ -14,19 +14,20 @@ namespace nes::sys
 		public:
 			explicit mapper_nrom() = default;
 
-			auto validate(cartridge& cartridge) -> status override
+			auto validate(rom_image const& rom) -> status override
 			{
-				if (cartridge.get_ram().get_length() != 0x2000)
+				if (rom.get_ram_size() != 0x2000)
 				{
 					return status::error_invalid_ines_data;
 				}
 
-				if (cartridge.get_prg_rom().get_length() != 0x4000 && cartridge.get_prg_rom().get_length() != 0x8000)
+				if (rom.get_prg_rom().get_length() != 0x4000 && rom.get_prg_rom().get_length() != 0x8000)
 				{
 					return status::error_invalid_ines_data;
 				}
 
-				if (cartridge.get_chr_rom().get_length() != 0x2000)
+				// Cartridges without CHR-ROM use 8 KiB of CHR-RAM instead.
+				if (rom.get_chr_rom().get_length() != 0x2000 && rom.get_chr_rom().get_length() != 0)
 				{
 					return status::error_invalid_ines_data;
 				}
@@ -67,17 +68,17 @@ namespace nes::sys
 				}
 				if (addr <= address{ 0x7FFF })
 				{
-					cartridge.ref_ram()[addr.get_absolute() - 0x6000] = value;
+					cartridge.write_ram(addr.get_absolute() - 0x6000, value);
 					return;
 				}
 			}
 
-			auto read_ppu(address const addr, cartridge& cartridge, span<u8 const> const vram) -> u8 override
+			auto read_ppu(address const addr, cartridge& cartridge, name_table_memory const& vram) -> u8 override
 			{
 				if (addr <= address{ 0x1FFF })
 				{
 					auto const rel = addr.get_absolute();
-					return cartridge.get_chr_rom()[rel];
+					return has_chr_ram(cartridge) ? cartridge.get_chr_ram()[rel] : cartridge.get_chr_rom()[rel];
 				}
 				if (addr <= address{ 0x3EFF })
 				{
@@ -87,20 +88,38 @@ namespace nes::sys
 				return 0x0;
 			}
 
-			auto write_ppu(address const addr, u8 const value, cartridge& cartridge, span<u8> const vram) -> void override
+			auto write_ppu(address const addr, u8 const value, cartridge& cartridge, name_table_memory& vram) -> void override
 			{
 				if (addr <= address{ 0x1FFF })
 				{
+					if (has_chr_ram(cartridge)) { cartridge.write_chr_ram(addr.get_absolute(), value); }
 					return;
 				}
 				if (addr <= address{ 0x3EFF })
 				{
-					vram[mirrored_vram_address(addr, cartridge)] = value;
+					vram.write(mirrored_vram_address(addr, cartridge), value);
 					return;
 				}
 			}
 
+			auto read_ppu_tile_row(address const addr, cartridge& cartridge) -> u16 override
+			{
+				auto const rel = addr.get_absolute() % 0x2000u;
+				if (has_chr_ram(cartridge))
+				{
+					auto const chr_ram = cartridge.get_chr_ram();
+					return rom_image::decode_tile_row(chr_ram[rel], chr_ram[rel + 8]);
+				}
+
+				return cartridge.get_rom().get_chr_tile_row(rel);
+			}
+
 		private:
+			static auto has_chr_ram(cartridge const& cartridge) -> bool
+			{
+				return cartridge.get_chr_rom().is_empty();
+			}
+
 			static auto mirrored_vram_address(address const addr, cartridge const& cartridge) -> u32
 			{
 				auto const rel = addr.get_absolute() % 0x1000u;
@@ -136,11 +155,12 @@ namespace nes::sys
 		public:
 			explicit mapper_invalid() = default;
 
-			auto validate(cartridge&) -> status override { return status::error_unsupported_mapper; }
+			auto validate(rom_image const&) -> status override { return status::error_unsupported_mapper; }
 			auto read_cpu(address, cartridge&) -> u8 override { return 0; }
 			auto write_cpu(address, u8, cartridge&) -> void override {}
-			auto read_ppu(address, cartridge&, span<u8 const>) -> u8 override { return 0; }
-			auto write_ppu(address, u8, cartridge&, span<u8>) -> void override {}
+			auto read_ppu(address, cartridge&, name_table_memory const&) -> u8 override { return 0; }
+			auto write_ppu(address, u8, cartridge&, name_table_memory&) -> void override {}
+			auto read_ppu_tile_row(address, cartridge&) -> u16 override { return 0; }
 		};
 	} // namespace
 
@@ -154,7 +174,7 @@ namespace nes::sys
 		return instance;
 	}
 
-	auto mapper::get(u8 const number) -> mapper&
+	auto mapper::get(u16 const number) -> mapper&
 	{
 		switch (number)
 		{
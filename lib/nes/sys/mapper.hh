@@ -1,6 +1,7 @@
 #pragma once
 
 #include "nes/sys/types/address.hh"
+#include "nes/sys/types/paged-memory.hh"
 #include "nes/common/containers/span.hh"
 #include "nes/common/status.hh"
 #include "nes/common/types.hh"
@@ -8,12 +9,16 @@
 namespace nes::sys
 {
 	class cartridge;
+	class rom_image;
+
+	/// Name table memory inside the console, which mappers arrange (and possibly replace).
+	using name_table_memory = paged_memory<0x800>;
 
 	class mapper
 	{
 	public:
 		static auto invalid() -> mapper&;
-		static auto get(u8 number) -> mapper&;
+		static auto get(u16 number) -> mapper&;
 
 		virtual ~mapper() = default;
 
@@ -22,11 +27,13 @@ namespace nes::sys
 		auto operator=(mapper const&) -> mapper& = delete;
 		auto operator=(mapper&&) -> mapper& = delete;
 
-		virtual auto validate(cartridge&) -> status = 0;
+		virtual auto validate(rom_image const&) -> status = 0;
 		virtual auto read_cpu(address, cartridge&) -> u8 = 0;
 		virtual auto write_cpu(address, u8, cartridge&) -> void = 0;
-		virtual auto read_ppu(address, cartridge&, span<u8 const> vram) -> u8 = 0;
-		virtual auto write_ppu(address, u8, cartridge&, span<u8> vram) -> void = 0;
+		virtual auto read_ppu(address, cartridge&, name_table_memory const& vram) -> u8 = 0;
+		virtual auto write_ppu(address, u8, cartridge&, name_table_memory& vram) -> void = 0;
+		/// Read both bitplanes of a pattern table row at once (see rom_image::decode_tile_row).
+		virtual auto read_ppu_tile_row(address, cartridge&) -> u16 = 0;
 
 	protected:
 		explicit mapper() = default;
@@ -0,0 +1,124 @@
+#include "nes/sys/movie.hh"
+#include "nes/common/debug.hh"
+
+namespace nes::sys
+{
+	namespace
+	{
+		constexpr auto movie_magic = u32{ 0x4D53454E }; // "NESM"
+		constexpr auto movie_version = u32{ 1 };
+		constexpr auto max_run_length = u32{ 0xFFFF };
+
+		static_assert(sizeof(movie::run) == 4);
+	} // namespace
+
+	auto movie_writer::begin(span<u8> const buffer, nes const& console) -> status
+	{
+		end();
+		length_ = 0;
+		frame_count_ = 0;
+		if (buffer.get_length() < movie::base_size) { return status::error_buffer_overflow; }
+
+		auto const header = movie::header{ movie_magic, movie_version, console.get_rom().get_crc32(), 0 };
+		__builtin_memcpy(&buffer[0], &header, sizeof(header));
+		if (auto const s = console.save_state(buffer.subspan(sizeof(header))); s != status::success) { return s; }
+
+		buffer_ = buffer;
+		length_ = movie::base_size;
+		recording_ = true;
+		return status::success;
+	}
+
+	auto movie_writer::record(button_mask const controller_1, button_mask const controller_2) -> status
+	{
+		NES_ASSERT(is_active() && "recording has not been started");
+
+		auto run = movie::run{ 0, controller_1.get_raw_value(), controller_2.get_raw_value() };
+		auto offset = length_;
+		if (length_ > movie::base_size)
+		{
+			// Extend the last run if the input has not changed.
+			auto last = movie::run{};
+			__builtin_memcpy(&last, &buffer_[length_ - sizeof(last)], sizeof(last));
+			if (last.length < max_run_length && last.controller_1 == run.controller_1 &&
+				last.controller_2 == run.controller_2)
+			{
+				run.length = last.length;
+				offset = length_ - sizeof(last);
+			}
+		}
+
+		if (offset + sizeof(run) > buffer_.get_length()) { return status::error_buffer_overflow; }
+
+		run.length += 1;
+		__builtin_memcpy(&buffer_[offset], &run, sizeof(run));
+		length_ = offset + sizeof(run);
+		frame_count_ += 1;
+		__builtin_memcpy(&buffer_[__builtin_offsetof(movie::header, frame_count)], &frame_count_, sizeof(frame_count_));
+		return status::success;
+	}
+
+	auto movie_writer::end() -> void
+	{
+		recording_ = false;
+	}
+
+	auto movie_reader::begin(span<u8 const> const data, nes& console) -> status
+	{
+		end();
+		if (data.get_length() < movie::base_size) { return status::error_invalid_movie; }
+
+		auto header = movie::header{};
+		__builtin_memcpy(&header, &data[0], sizeof(header));
+		if (header.magic != movie_magic || header.version != movie_version) { return status::error_invalid_movie; }
+		if (header.rom_crc32 != console.get_rom().get_crc32()) { return status::error_invalid_movie; }
+
+		// Validate the runs up front, so that playback cannot fail halfway.
+		auto const runs = data.subspan(movie::base_size);
+		if (runs.get_length() % sizeof(movie::run) != 0) { return status::error_invalid_movie; }
+		auto frame_count = u64{ 0 };
+		for (auto offset = u32{ 0 }; offset < runs.get_length(); offset += sizeof(movie::run))
+		{
+			auto run = movie::run{};
+			__builtin_memcpy(&run, &runs[offset], sizeof(run));
+			if (run.length == 0) { return status::error_invalid_movie; }
+			frame_count += run.length;
+		}
+		if (frame_count != header.frame_count) { return status::error_invalid_movie; }
+
+		if (console.load_state(data.subspan(sizeof(header), nes::state_size)) != status::success)
+		{
+			return status::error_invalid_movie;
+		}
+
+		data_ = data;
+		header_ = header;
+		position_ = movie::base_size;
+		remaining_ = 0;
+		frame_index_ = 0;
+		return status::success;
+	}
+
+	auto movie_reader::next(button_mask& controller_1, button_mask& controller_2) -> bool
+	{
+		if (!is_active() || frame_index_ >= header_.frame_count) { return false; }
+
+		if (remaining_ == 0)
+		{
+			__builtin_memcpy(&run_, &data_[position_], sizeof(run_));
+			position_ += sizeof(run_);
+			remaining_ = run_.length;
+		}
+
+		controller_1 = button_mask::from_raw_value(run_.controller_1);
+		controller_2 = button_mask::from_raw_value(run_.controller_2);
+		remaining_ -= 1;
+		frame_index_ += 1;
+		return true;
+	}
+
+	auto movie_reader::end() -> void
+	{
+		data_ = span<u8 const>{};
+	}
+} // namespace nes::sys
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "nes/sys/nes.hh"
+#include "nes/sys/types/button-mask.hh"
+#include "nes/common/containers/span.hh"
+#include "nes/common/status.hh"
+#include "nes/common/types.hh"
+
+namespace nes::sys
+{
+	/// A recording of the inputs of both controllers for every frame, starting from a save state.
+	///
+	/// Since the emulation is deterministic, replaying a movie on the same ROM reproduces every frame exactly. A movie
+	/// consists of a header (including the CRC-32 of the ROM), the initial save state and the per-frame button masks,
+	/// which are run-length encoded as runs of up to 0xFFFF frames with the same input. Like save states, the format is
+	/// specific to the host.
+	namespace movie
+	{
+		struct header
+		{
+			u32 magic;
+			u32 version;
+			u32 rom_crc32;
+			u32 frame_count;
+		};
+
+		struct run
+		{
+			u16 length;
+			u8 controller_1;
+			u8 controller_2;
+		};
+
+		/// Size of a movie without any frames.
+		inline constexpr auto base_size = u32{ sizeof(header) + nes::state_size };
+	} // namespace movie
+
+	/// Records a movie into a caller-provided buffer.
+	class movie_writer
+	{
+		span<u8> buffer_{};
+		u32 length_{ 0 };
+		u32 frame_count_{ 0 };
+		bool recording_{ false };
+
+	public:
+		explicit movie_writer() = default;
+
+		movie_writer(movie_writer const&) = delete;
+		movie_writer(movie_writer&&) = delete;
+		auto operator=(movie_writer const&) -> movie_writer& = delete;
+		auto operator=(movie_writer&&) -> movie_writer& = delete;
+
+		auto is_active() const -> bool { return recording_; }
+		auto get_frame_count() const -> u32 { return frame_count_; }
+		/// The movie recorded so far (which is always complete), also available after the recording has ended.
+		auto get_data() const -> span<u8 const> { return span<u8 const>{ buffer_.get_data(), length_ }; }
+
+		/// Start recording into the buffer (which must outlive the recording) from the current state of the console.
+		auto begin(span<u8> buffer, nes const&) -> status;
+		/// Append the input for the next frame, which must be applied to the console before emulating the frame.
+		auto record(button_mask controller_1, button_mask controller_2) -> status;
+		/// Stop recording, keeping the recorded data.
+		auto end() -> void;
+	};
+
+	/// Plays back a movie stored in memory.
+	class movie_reader
+	{
+		span<u8 const> data_{};
+		movie::header header_{};
+		u32 position_{ 0 };
+		u32 remaining_{ 0 };
+		movie::run run_{};
+		u32 frame_index_{ 0 };
+
+	public:
+		explicit movie_reader() = default;
+
+		movie_reader(movie_reader const&) = delete;
+		movie_reader(movie_reader&&) = delete;
+		auto operator=(movie_reader const&) -> movie_reader& = delete;
+		auto operator=(movie_reader&&) -> movie_reader& = delete;
+
+		auto is_active() const -> bool { return !data_.is_empty(); }
+		auto get_rom_crc32() const -> u32 { return header_.rom_crc32; }
+		auto get_frame_count() const -> u32 { return header_.frame_count; }
+		auto get_frame_index() const -> u32 { return frame_index_; }
+
+		/// Validate the movie (which must outlive the playback) and load its initial state into the console.
+		auto begin(span<u8 const> data, nes&) -> status;
+		/// Read the input for the next frame. Returns false once the movie has ended.
+		auto next(button_mask& controller_1, button_mask& controller_2) -> bool;
+		/// Stop the playback.
+		auto end() -> void;
+	};
+} // namespace nes::sys
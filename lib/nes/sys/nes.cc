@@ -1,12 +1,90 @@
 #include "nes/sys/nes.hh"
+#include "nes/common/debug.hh"
+#include "nes/common/xxh3.hh"
 
 namespace nes::sys
 {
-	nes::nes(display& display, span<u8 const> const rom_data)
-		: cartridge_{ rom_data }
+	namespace
+	{
+		constexpr auto state_magic = u32{ 0x5345414E }; // "NAES"
+		constexpr auto state_version = u32{ 3 };
+
+		static_assert(__is_trivially_copyable(cpu::state));
+		static_assert(__is_trivially_copyable(ppu::state));
+		static_assert(__is_trivially_copyable(apu::state));
+		static_assert(__is_trivially_copyable(controller::state));
+		static_assert(__is_trivially_copyable(cartridge::state));
+		static_assert(__is_trivially_copyable(nes::state));
+		// States are copied, hashed and XOR-ed byte by byte, so all padding is explicit (and initialized).
+		static_assert(__has_unique_object_representations(nes::state));
+
+		/// Copies values into a buffer back-to-back.
+		class state_writer
+		{
+			span<u8> buffer_;
+			u32 offset_{ 0 };
+
+		public:
+			explicit state_writer(span<u8> const buffer)
+				: buffer_{ buffer }
+			{
+			}
+
+			template<typename T>
+			auto write(T const& value) -> void
+			{
+				NES_ASSERT(offset_ + sizeof(T) <= buffer_.get_length() && "save state buffer too small");
+				__builtin_memcpy(buffer_.get_data() + offset_, &value, sizeof(T));
+				offset_ += sizeof(T);
+			}
+
+			auto write_bytes(span<u8 const> const data) -> void
+			{
+				NES_ASSERT(offset_ + data.get_length() <= buffer_.get_length() && "save state buffer too small");
+				__builtin_memcpy(buffer_.get_data() + offset_, data.get_data(), data.get_length());
+				offset_ += data.get_length();
+			}
+		};
+
+		/// Copies values out of a buffer written by state_writer.
+		class state_reader
+		{
+			span<u8 const> buffer_;
+			u32 offset_{ 0 };
+
+		public:
+			explicit state_reader(span<u8 const> const buffer)
+				: buffer_{ buffer }
+			{
+			}
+
+			template<typename T>
+			auto read(T& value) -> void
+			{
+				NES_ASSERT(offset_ + sizeof(T) <= buffer_.get_length() && "save state buffer too small");
+				__builtin_memcpy(&value, buffer_.get_data() + offset_, sizeof(T));
+				offset_ += sizeof(T);
+			}
+
+			template<typename Memory>
+			auto read_memory(Memory& memory) -> void
+			{
+				auto const data = memory.ref_data();
+				NES_ASSERT(offset_ + data.get_length() <= buffer_.get_length() && "save state buffer too small");
+				__builtin_memcpy(data.get_data(), buffer_.get_data() + offset_, data.get_length());
+				offset_ += data.get_length();
+				memory.set_dirty();
+			}
+		};
+
+	} // namespace
+
+	nes::nes(display& display, rom_image const& rom)
+		: cartridge_{ rom }
 		, display_{ display }
 		, ppu_{ cpu_, cartridge_, display_ }
-		, cpu_{ ppu_, cartridge_, controller_1_, controller_2_ }
+		, apu_{ cpu_ }
+		, cpu_{ ppu_, apu_, cartridge_, controller_1_, controller_2_ }
 		, status_{ cartridge_.get_status() }
 	{
 	}
@@ -15,7 +93,18 @@ namespace nes::sys
 	{
 		if (get_status() != status::success) { return; }
 
+		// The PPU may still be behind after run_frame.
+		while (ppu_.get_cycles() < cpu_.get_cycles())
+		{
+			ppu_.step();
+		}
+
 		status_ = cpu_.step();
+		// The APU is otherwise only run when it is accessed, but needs to catch up in time to raise interrupts.
+		if (cpu_.get_cycles() >= apu_.get_next_event())
+		{
+			apu_.run_until(cpu_.get_cycles());
+		}
 		while (ppu_.get_cycles() < cpu_.get_cycles())
 		{
 			ppu_.step();
@@ -31,16 +120,127 @@ namespace nes::sys
 		}
 	}
 
-	auto nes::step_to_nmi() -> void
+	auto nes::run_frame(cycle_count const budget) -> bool
 	{
-		while (cpu_.is_nmi_pending())
+		auto const frame = ppu_.get_frame_count();
+		auto const start = cpu_.get_cycles();
+		auto completed = false;
+		while (get_status() == status::success)
 		{
-			step();
+			// Step the PPU dot by dot to stop right at the frame boundary.
+			while (ppu_.get_cycles() < cpu_.get_cycles() && ppu_.get_frame_count() == frame)
+			{
+				ppu_.step();
+			}
+			if (ppu_.get_frame_count() != frame)
+			{
+				completed = true;
+				break;
+			}
+			if ((cpu_.get_cycles() - start).get_units() >= budget.get_units()) { break; }
+
+			status_ = cpu_.step();
+			if (cpu_.get_cycles() >= apu_.get_next_event())
+			{
+				apu_.run_until(cpu_.get_cycles());
+			}
 		}
-		while (!cpu_.is_nmi_pending())
+
+		// Keep time-based stepping in sync.
+		current_cycles_ = cpu_.get_cycles();
+		return completed;
+	}
+
+	auto nes::get_state() const -> state
+	{
+		auto res = state{};
+		res.cycles = current_cycles_;
+		res.cpu = cpu_.get_state();
+		res.ppu = ppu_.get_state();
+		res.apu = apu_.get_state();
+		res.controller_1 = controller_1_.get_state();
+		res.controller_2 = controller_2_.get_state();
+		res.cartridge = cartridge_.get_state();
+		return res;
+	}
+
+	auto nes::set_state(state const& value) -> void
+	{
+		current_cycles_ = value.cycles;
+		cpu_.set_state(value.cpu);
+		ppu_.set_state(value.ppu);
+		apu_.set_state(value.apu);
+		controller_1_.set_state(value.controller_1);
+		controller_2_.set_state(value.controller_2);
+		cartridge_.set_state(value.cartridge);
+	}
+
+	auto nes::get_state_hash() const -> u64
+	{
+		// The registers are serialized explicitly (in little endian), so that the hash does not depend on the host's
+		// struct layout and padding.
+		auto const& cpu_state = cpu_.get_state();
+		auto const& ppu_state = ppu_.get_state();
+		auto const cycles = cpu_state.cycles.get_units();
+		u8 const registers[]
 		{
-			step();
+			static_cast<u8>(cycles >> 0), static_cast<u8>(cycles >> 8), static_cast<u8>(cycles >> 16),
+			static_cast<u8>(cycles >> 24), static_cast<u8>(cycles >> 32), static_cast<u8>(cycles >> 40),
+			static_cast<u8>(cycles >> 48), static_cast<u8>(cycles >> 56),
+			static_cast<u8>(cpu_state.registers.pc >> 0), static_cast<u8>(cpu_state.registers.pc >> 8),
+			cpu_state.registers.sp, cpu_state.registers.a, cpu_state.registers.x, cpu_state.registers.y,
+			cpu_state.registers.p.value,
+			ppu_state.control.value, ppu_state.mask.value, ppu_state.status.value, ppu_state.oamaddr,
+			static_cast<u8>(ppu_state.internal.v.value >> 0), static_cast<u8>(ppu_state.internal.v.value >> 8),
+			static_cast<u8>(ppu_state.internal.t.value >> 0), static_cast<u8>(ppu_state.internal.t.value >> 8),
+			ppu_state.internal.x, static_cast<u8>(ppu_state.internal.w),
+		};
+
+		auto res = xxh3{};
+		res.update(span{ registers });
+		res.update(span{ reinterpret_cast<u8 const*>(ppu_state.palette_buffer), sizeof(ppu_state.palette_buffer) });
+		res.update(cpu_.get_ram().get_data());
+		res.update(ppu_.get_vram().get_data());
+		res.update(ppu_.get_oam().get_data());
+		res.update(cartridge_.get_ram());
+		if (cartridge_.get_chr_rom().is_empty()) { res.update(cartridge_.get_chr_ram()); }
+		return res.get_value();
+	}
+
+	auto nes::save_state(span<u8> const buffer) const -> status
+	{
+		if (buffer.get_length() < state_size) { return status::error_buffer_overflow; }
+
+		auto writer = state_writer{ buffer };
+		writer.write(state_header{ state_magic, state_version, state_size, cartridge_.get_rom().get_crc32() });
+		writer.write(get_state());
+		writer.write_bytes(cpu_.get_ram().get_data());
+		writer.write_bytes(ppu_.get_vram().get_data());
+		writer.write_bytes(ppu_.get_oam().get_data());
+		writer.write_bytes(cartridge_.get_ram_memory().get_data());
+		writer.write_bytes(cartridge_.get_chr_ram_memory().get_data());
+		return status::success;
+	}
+
+	auto nes::load_state(span<u8 const> const buffer) -> status
+	{
+		if (buffer.get_length() < state_size) { return status::error_invalid_save_state; }
+
+		auto reader = state_reader{ buffer };
+		auto header = state_header{};
+		reader.read(header);
+		if (header.magic != state_magic || header.version != state_version || header.size != state_size ||
+			header.rom_crc32 != cartridge_.get_rom().get_crc32())
+		{
+			return status::error_invalid_save_state;
 		}
+
+		auto value = state{};
+		reader.read(value);
+		set_state(value);
+		for_each_memory([&](auto& memory) { reader.read_memory(memory); });
+		status_ = cartridge_.get_status();
+		return status::success;
 	}
 
 #ifdef NES_ENABLE_SNAPSHOTS
@@ -3,10 +3,13 @@
 #include "nes/sys/types/cycle-count.hh"
 #include "nes/sys/types/snapshot.hh"
 #include "nes/sys/cartridge.hh"
+#include "nes/sys/rom-image.hh"
 #include "nes/sys/controller.hh"
 #include "nes/sys/cpu.hh"
 #include "nes/sys/ppu.hh"
+#include "nes/sys/apu.hh"
 #include "nes/common/containers/span.hh"
+#include "nes/common/status.hh"
 
 namespace nes
 {
@@ -18,17 +21,52 @@ namespace nes::sys
 	/// The main console abstraction.
 	class nes
 	{
+		struct state_header
+		{
+			u32 magic;
+			u32 version;
+			u32 size;
+			u32 rom_crc32;
+		};
+
 		cartridge cartridge_;
 		display& display_;
 		controller controller_1_;
 		controller controller_2_;
 		ppu ppu_;
+		apu apu_;
 		cpu cpu_;
 		cycle_count current_cycles_;
 		status status_{ status::error_invalid_ines_data };
 
+		static constexpr auto unlimited_budget = cycle_count::from_units(~u64{ 0 });
+
 	public:
-		explicit nes(display&, span<u8 const> rom_data);
+		/// All mutable state of the console except for paged memory (see for_each_memory). The component states have no
+		/// implicit padding, so saving the same state always produces the same bytes.
+		struct state
+		{
+			cycle_count cycles{};
+			sys::cpu::state cpu{};
+			sys::ppu::state ppu{};
+			sys::apu::state apu{};
+			sys::controller::state controller_1{};
+			sys::controller::state controller_2{};
+			sys::cartridge::state cartridge{};
+		};
+
+		/// Total number of pages in the paged memory blocks.
+		static constexpr auto memory_page_count = u32{
+			cpu::ram::page_count + name_table_memory::page_count + ppu::oam::page_count + cartridge::ram::page_count +
+			cartridge::chr_ram::page_count };
+
+		/// Size of a save state in bytes.
+		static constexpr auto state_size = u32{
+			sizeof(state_header) + sizeof(state) + cpu::ram::size + name_table_memory::size + ppu::oam::size +
+			cartridge::ram::size + cartridge::chr_ram::size };
+
+		/// Create a console running the given ROM image, which must outlive the console.
+		explicit nes(display&, rom_image const&);
 
 		nes(nes const&) = delete;
 		nes(nes&&) = delete;
@@ -36,14 +74,56 @@ namespace nes::sys
 		auto operator=(nes&&) -> nes& = delete;
 
 		auto get_status() const -> status { return status_; }
+		auto get_rom() const -> rom_image const& { return cartridge_.get_rom(); }
 		auto get_controller_1() const -> controller const& { return controller_1_; }
 		auto ref_controller_1() -> controller& { return controller_1_; }
 		auto get_controller_2() const -> controller const& { return controller_2_; }
 		auto ref_controller_2() -> controller& { return controller_2_; }
+		auto ref_apu() -> apu& { return apu_; }
+		auto get_cpu_ram() const -> span<u8 const> { return cpu_.get_ram().get_data(); }
+		/// The cartridge's PRG RAM (mapped to $6000 for most cartridges).
+		auto get_cartridge_ram() const -> span<u8 const> { return cartridge_.get_ram(); }
+		auto get_frame_count() const -> u64 { return ppu_.get_frame_count(); }
+		/// Number of cycles emulated since power-on.
+		auto get_cycles() const -> cycle_count { return cpu_.get_cycles(); }
+		/// While disabled, frames are emulated as usual but not passed to the display.
+		auto set_video_enabled(bool const value) -> void { ppu_.set_video_enabled(value); }
 
 		auto step() -> void;
 		auto step(cycle_count delta) -> void;
-		auto step_to_nmi() -> void;
+		/// Run until the PPU has completed the current frame, stopping at exactly the first dot of vblank (independent of
+		/// whether the game enables NMIs). The PPU may be left behind the CPU, it catches up before the next instruction.
+		///
+		/// With a budget, no new instruction is started once that many cycles have been emulated. Returns false if the
+		/// frame could not be completed (because the budget ran out or an error occurred).
+		auto run_frame(cycle_count budget = unlimited_budget) -> bool;
+
+		auto get_state() const -> state;
+		/// Restore the state, leaving the paged memory unchanged.
+		auto set_state(state const&) -> void;
+
+		/// Call the function with each block of paged memory (always in the same order).
+		template<typename Function>
+		auto for_each_memory(Function&& function) -> void
+		{
+			function(cpu_.ref_ram());
+			function(ppu_.ref_vram());
+			function(ppu_.ref_oam());
+			function(cartridge_.ref_ram_memory());
+			function(cartridge_.ref_chr_ram_memory());
+		}
+
+		/// Hash of the state visible to the game (CPU and PPU registers, palette, RAM, VRAM, OAM, cartridge RAM and CHR
+		/// RAM), which is identical across hosts and builds. Comparing the hashes of two runs at frame boundaries
+		/// detects desyncs without storing full states.
+		auto get_state_hash() const -> u64;
+
+		/// Write the complete console state into the buffer (at least state_size bytes). The format is versioned, but
+		/// specific to the host (byte order and struct layout) and the ROM image.
+		auto save_state(span<u8> buffer) const -> status;
+		/// Restore a state written by save_state. All paged memory is marked as dirty, and a console which stopped
+		/// with an error continues running.
+		auto load_state(span<u8 const> buffer) -> status;
 
 #ifdef NES_ENABLE_SNAPSHOTS
 		auto get_snapshot() -> snapshot;
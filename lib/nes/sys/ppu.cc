@@ -20,8 +20,8 @@ namespace nes::sys
 #ifdef NES_ENABLE_SNAPSHOTS
 	auto ppu::build_snapshot(snapshot& snapshot) -> void
 	{
-		snapshot.vram = std::vector(std::begin(vram_), std::end(vram_));
-		snapshot.oam = std::vector(std::begin(oam_), std::end(oam_));
+		snapshot.vram = std::vector(vram_.get_data().begin(), vram_.get_data().end());
+		snapshot.oam = std::vector(oam_.get_data().begin(), oam_.get_data().end());
 	}
 #endif
 
@@ -30,32 +30,32 @@ namespace nes::sys
 		// See https://www.nesdev.org/wiki/PPU_rendering
 		// Inspired by https://github.com/fogleman/nes/blob/master/nes/ppu.go
 
-		auto const enable_rendering = mask_.get_enable_background() || mask_.get_enable_sprites();
+		auto const enable_rendering = state_.mask.get_enable_background() || state_.mask.get_enable_sprites();
 
-		current_cycles_ += cycle_count::from_ppu(1);
-		scanline_cycle_ += 1;
-		if (enable_rendering && !even_frame_ && scanline_ == 261 && scanline_cycle_ == 340)
+		state_.cycles += cycle_count::from_ppu(1);
+		state_.scanline_cycle += 1;
+		if (enable_rendering && !state_.even_frame && state_.scanline == 261 && state_.scanline_cycle == 340)
 		{
-			current_cycles_ += cycle_count::from_ppu(1);
-			scanline_cycle_ += 1;
+			state_.cycles += cycle_count::from_ppu(1);
+			state_.scanline_cycle += 1;
 		}
-		if (scanline_cycle_ == 341)
+		if (state_.scanline_cycle == 341)
 		{
-			scanline_cycle_ = 0;
-			scanline_ += 1;
+			state_.scanline_cycle = 0;
+			state_.scanline += 1;
 
-			if (scanline_ == 262)
+			if (state_.scanline == 262)
 			{
-				scanline_ = 0;
-				even_frame_ = !even_frame_;
+				state_.scanline = 0;
+				state_.even_frame = !state_.even_frame;
 			}
 		}
 
-		auto const pre_line = scanline_ == 261;
-		auto const visible_line = scanline_ < 240;
+		auto const pre_line = state_.scanline == 261;
+		auto const visible_line = state_.scanline < 240;
 		auto const render_line = pre_line || visible_line;
-		auto const pre_fetch_cycle = scanline_cycle_ >= 321 && scanline_cycle_ <= 336;
-		auto const visible_cycle = scanline_cycle_ >= 1 && scanline_cycle_ <= 256;
+		auto const pre_fetch_cycle = state_.scanline_cycle >= 321 && state_.scanline_cycle <= 336;
+		auto const visible_cycle = state_.scanline_cycle >= 1 && state_.scanline_cycle <= 256;
 		auto const fetch_cycle = pre_fetch_cycle || visible_cycle;
 
 		// Background Logic
@@ -69,12 +69,12 @@ namespace nes::sys
 			if (render_line && fetch_cycle)
 			{
 				// Fetch cycle for the background.
-				switch (scanline_cycle_ % 8)
+				switch (state_.scanline_cycle % 8)
 				{
 					case 1:
 					{
 						// Load the tile pattern for the background from the name table.
-						fetch_cycle_.background_tile = tile{ read8(address{ 0x2000 } + internal_.v.get_tile_address()) };
+						state_.fetch_cycle.background_tile = tile{ read8(address{ 0x2000 } + state_.internal.v.get_tile_address()) };
 						break;
 					}
 					case 3:
@@ -82,41 +82,29 @@ namespace nes::sys
 						// Load the tile palette for the background from the attribute table.
 						auto const addr =
 							address{ 0x23C0 } +
-							(static_cast<u32>(internal_.v.get_name_table()) * 0x400u) +
-							((internal_.v.get_coarse_y() & 0b11100u) << 1) +
-							((internal_.v.get_coarse_x() & 0b11100u) >> 2);
+							(static_cast<u32>(state_.internal.v.get_name_table()) * 0x400u) +
+							((state_.internal.v.get_coarse_y() & 0b11100u) << 1) +
+							((state_.internal.v.get_coarse_x() & 0b11100u) >> 2);
 						auto const shift =
-							((internal_.v.get_coarse_y() & 0b00010u) << 1) |
-							((internal_.v.get_coarse_x() & 0b00010u) << 0);
-						fetch_cycle_.background_palette = static_cast<palette>((read8(addr) >> shift) & 0b11);
+							((state_.internal.v.get_coarse_y() & 0b00010u) << 1) |
+							((state_.internal.v.get_coarse_x() & 0b00010u) << 0);
+						state_.fetch_cycle.background_palette = static_cast<palette>((read8(addr) >> shift) & 0b11);
 						break;
 					}
 					case 5:
 					{
-						// Load bitplane 0 for the background tile's pattern.
-						fetch_cycle_.pattern_bitplane_0 = get_tile_bitplane(
-							control_.get_background_pattern_table(),
-							fetch_cycle_.background_tile,
-							internal_.v.get_fine_y(),
-							bitplane::_0);
-						break;
-					}
-					case 7:
-					{
-						// Load bitplane 1 for the background tile's pattern.
-						fetch_cycle_.pattern_bitplane_1 = get_tile_bitplane(
-							control_.get_background_pattern_table(),
-							fetch_cycle_.background_tile,
-							internal_.v.get_fine_y(),
-							bitplane::_1);
+						// Load both bitplanes for the background tile's pattern.
+						state_.fetch_cycle.pattern = get_tile_pattern(
+							state_.control.get_background_pattern_table(),
+							state_.fetch_cycle.background_tile,
+							state_.internal.v.get_fine_y());
 						break;
 					}
 					case 0:
 					{
 						// Fetch cycle done -> build the tile row for the background.
-						current_background_ = next_background_;
-						next_background_ = get_tile_row(
-							fetch_cycle_.background_palette, fetch_cycle_.pattern_bitplane_0, fetch_cycle_.pattern_bitplane_1);
+						state_.current_background = state_.next_background;
+						state_.next_background = get_tile_row(state_.fetch_cycle.background_palette, state_.fetch_cycle.pattern);
 						break;
 					}
 					default:
@@ -124,32 +112,37 @@ namespace nes::sys
 				}
 			}
 
-			if (pre_line && scanline_cycle_ >= 280 && scanline_cycle_ <= 304)
+			if (pre_line && state_.scanline_cycle >= 280 && state_.scanline_cycle <= 304)
 			{
 				copy_y();
 			}
 
 			if (render_line)
 			{
-				if (fetch_cycle && scanline_cycle_ % 8 == 0)
+				if (fetch_cycle && state_.scanline_cycle % 8 == 0)
 				{
 					increment_x();
 				}
-				if (scanline_cycle_ == 256)
+				if (state_.scanline_cycle == 256)
 				{
 					increment_y();
 				}
-				if (scanline_cycle_ == 257)
+				if (state_.scanline_cycle == 257)
 				{
 					copy_x();
 				}
 			}
 		}
+		else if (visible_line && visible_cycle)
+		{
+			// With rendering disabled, the screen shows the backdrop color.
+			output_pixel(state_.scanline_cycle - 1, state_.scanline, color_index{ 0 });
+		}
 
 		// Sprite Logic
 		if (enable_rendering)
 		{
-			if (scanline_cycle_ == 257)
+			if (state_.scanline_cycle == 257)
 			{
 				if (visible_line)
 				{
@@ -157,45 +150,48 @@ namespace nes::sys
 				}
 				else
 				{
-					sprite_count_ = 0;
+					state_.sprite_count = 0;
 				}
 			}
 		}
 
+		if (visible_line && state_.scanline_cycle == 256 && video_enabled_) { display_.end_scanline(state_.scanline); }
+
 		// Vblank Logic
-		if (scanline_ == 241 && scanline_cycle_ == 1)
+		if (state_.scanline == 241 && state_.scanline_cycle == 1)
 		{
-			display_.switch_buffers();
-			status_.set_vblank(true);
-			if (control_.get_vblank_nmi()) { cpu_.trigger_nmi(); }
+			if (video_enabled_) { display_.switch_buffers(); }
+			state_.frame_count += 1;
+			state_.status.set_vblank(true);
+			if (state_.control.get_vblank_nmi()) { cpu_.trigger_nmi(); }
 		}
-		if (pre_line && scanline_cycle_ == 1)
+		if (pre_line && state_.scanline_cycle == 1)
 		{
-			status_.set_vblank(false);
-			status_.set_sprite_zero_hit(false);
-			status_.set_sprite_overflow(false);
+			state_.status.set_vblank(false);
+			state_.status.set_sprite_zero_hit(false);
+			state_.status.set_sprite_overflow(false);
 		}
 	}
 
 	auto ppu::render_pixel() -> void
 	{
-		auto const x = scanline_cycle_ - 1;
-		auto const y = scanline_;
+		auto const x = state_.scanline_cycle - 1;
+		auto const y = state_.scanline;
 
 		auto background_color = color_index{ 0 };
-		if (mask_.get_enable_background())
+		if (state_.mask.get_enable_background())
 		{
-			background_color = current_background_.colors[internal_.x + x % tile_size];
+			background_color = state_.current_background.colors[state_.internal.x + x % tile_size];
 			background_color.set_role(role::background);
 		}
 
 		auto foreground = evaluated_sprite{};
 		auto foreground_color = color_index{ 0 };
-		if (mask_.get_enable_sprites())
+		if (state_.mask.get_enable_sprites())
 		{
-			for (auto i = u32{ 0 }; i < sprite_count_; ++i)
+			for (auto i = u32{ 0 }; i < state_.sprite_count; ++i)
 			{
-				auto const s = sprites_[i];
+				auto const s = state_.sprites[i];
 				auto const offset = static_cast<int>(x) - static_cast<int>(s.x);
 				if (offset < 0 || static_cast<u32>(offset) >= tile_size) { continue; }
 				auto const color = s.pattern.colors[offset];
@@ -211,8 +207,8 @@ namespace nes::sys
 		auto has_background = background_color.get_color() != palette_color::_0;
 		auto has_foreground = foreground_color.get_color() != palette_color::_0;
 
-		if (x < tile_size && !mask_.get_show_background_start()) { has_background = false; }
-		if (x < tile_size && !mask_.get_show_sprites_start()) { has_foreground = false; }
+		if (x < tile_size && !state_.mask.get_show_background_start()) { has_background = false; }
+		if (x < tile_size && !state_.mask.get_show_sprites_start()) { has_foreground = false; }
 
 		auto color = color_index{ 0 };
 		if (!has_background && has_foreground)
@@ -227,36 +223,52 @@ namespace nes::sys
 		{
 			if (foreground.is_sprite_zero && x < 255)
 			{
-				status_.set_sprite_zero_hit(true);
+				state_.status.set_sprite_zero_hit(true);
 			}
 
 			color = foreground.is_in_front ? foreground_color : background_color;
 		}
 
-		display_.set(x, y, resolve_color(ref_color(color)));
+		output_pixel(x, y, color);
+	}
+
+	auto ppu::output_pixel(u32 const x, u32 const y, color_index const color) -> void
+	{
+		if (!video_enabled_) { return; }
+		if (display_.is_indexed())
+		{
+			// Like the actual video signal, the raw output is affected by the grayscale and emphasis bits.
+			auto index = static_cast<u16>(static_cast<u8>(ref_color(color)) & 0x3F);
+			if (state_.mask.get_grayscale()) { index &= 0x30; }
+			display_.set_index(x, y, static_cast<u16>(index | ((state_.mask.value >> 5) << 6)));
+		}
+		else
+		{
+			display_.set(x, y, resolve_color(ref_color(color)));
+		}
 	}
 
 	auto ppu::evaluate_sprites() -> void
 	{
 		auto const height = get_sprite_height();
-		sprite_count_ = 0;
+		state_.sprite_count = 0;
 		for (auto i = u32{ 0 }; i < sprite_max_count; ++i)
 		{
-			auto const s = sprite{ span<u8 const>{ oam_ }.subspan<4>(i * 4) };
-			auto const row = static_cast<int>(scanline_) - static_cast<int>(s.get_y());
+			auto const s = sprite{ oam_.get_data().subspan<4>(i * 4) };
+			auto const row = static_cast<int>(state_.scanline) - static_cast<int>(s.get_y());
 			if (row < 0 || static_cast<u32>(row) >= height) { continue; }
 
-			if (sprite_count_ < 8)
+			if (state_.sprite_count < 8)
 			{
-				sprites_[sprite_count_].pattern = fetch_sprite_pattern(s, static_cast<u32>(row));
-				sprites_[sprite_count_].x = s.get_x();
-				sprites_[sprite_count_].is_in_front = !s.get_behind_background();
-				sprites_[sprite_count_].is_sprite_zero = i == 0;
-				sprite_count_ += 1;
+				state_.sprites[state_.sprite_count].pattern = fetch_sprite_pattern(s, static_cast<u32>(row));
+				state_.sprites[state_.sprite_count].x = s.get_x();
+				state_.sprites[state_.sprite_count].is_in_front = !s.get_behind_background();
+				state_.sprites[state_.sprite_count].is_sprite_zero = i == 0;
+				state_.sprite_count += 1;
 			}
 			else
 			{
-				status_.set_sprite_overflow(true);
+				state_.status.set_sprite_overflow(true);
 				break;
 			}
 		}
@@ -267,11 +279,11 @@ namespace nes::sys
 		if (s.get_flip_vertical()) { row = get_sprite_height() - 1 - row; }
 		tile tile;
 		pattern_table pattern_table;
-		switch (control_.get_sprite_size())
+		switch (state_.control.get_sprite_size())
 		{
 			case sprite_size::single_height:
 				tile = s.get_small_tile();
-				pattern_table = control_.get_sprite_pattern_table();
+				pattern_table = state_.control.get_sprite_pattern_table();
 				break;
 			case sprite_size::double_height:
 				tile = s.get_large_top_tile();
@@ -286,9 +298,7 @@ namespace nes::sys
 				return tile_row{};
 		}
 
-		auto const bitplane_0 = get_tile_bitplane(pattern_table, tile, row, bitplane::_0);
-		auto const bitplane_1 = get_tile_bitplane(pattern_table, tile, row, bitplane::_1);
-		auto res = get_tile_row(s.get_palette(), bitplane_0, bitplane_1);
+		auto res = get_tile_row(s.get_palette(), get_tile_pattern(pattern_table, tile, row));
 
 		if (s.get_flip_horizontal())
 		{
@@ -349,17 +359,17 @@ namespace nes::sys
 
 	auto ppu::read_latch() -> u8
 	{
-		return latch_;
+		return state_.latch;
 	}
 
 	auto ppu::read_ppustatus() -> u8
 	{
-		auto res = status_;
-		res.set_remaining(latch_);
+		auto res = state_.status;
+		res.set_remaining(state_.latch);
 		NES_DEBUG_LOG(ppu, "PPUSTATUS -> {:#2x}", res.value);
 
-		status_.set_vblank(false);
-		internal_.w = false;
+		state_.status.set_vblank(false);
+		state_.internal.w = false;
 
 		write_latch(res.value);
 		return res.value;
@@ -367,8 +377,8 @@ namespace nes::sys
 
 	auto ppu::read_oamdata() -> u8
 	{
-		auto res = oam_[oamaddr_];
-		if ((oamaddr_ & 0x3) == 0x2)
+		auto res = oam_[state_.oamaddr];
+		if ((state_.oamaddr & 0x3) == 0x2)
 		{
 			res &= 0xE3;
 		}
@@ -379,102 +389,102 @@ namespace nes::sys
 
 	auto ppu::read_ppudata() -> u8
 	{
-		auto const addr = address{ internal_.v.value };
+		auto const addr = address{ state_.internal.v.value };
 		auto res = read8(addr);
-		write_latch(ppudata_read_buffer_);
+		write_latch(state_.ppudata_read_buffer);
 
 		if (addr % 0x4000 <= address{ 0x3EFF })
 		{
-			swap(res, ppudata_read_buffer_);
+			swap(res, state_.ppudata_read_buffer);
 		}
 		else
 		{
 			// For palette buffers: buffer the mirrored nametable instead.
-			ppudata_read_buffer_ = read8(addr - 0x1000);
+			state_.ppudata_read_buffer = read8(addr - 0x1000);
 		}
 
-		NES_DEBUG_LOG(ppu, "PPUDATA -> {:#2x} (address: {:#4x})", res, internal_.v);
+		NES_DEBUG_LOG(ppu, "PPUDATA -> {:#2x} (address: {:#4x})", res, state_.internal.v);
 		increment_vram();
 		return res;
 	}
 
 	auto ppu::write_latch(u8 const value) -> void
 	{
-		latch_ = value;
+		state_.latch = value;
 	}
 
 	auto ppu::write_ppuctrl(u8 const value) -> void
 	{
 		write_latch(value);
-		if (current_cycles_ > boot_up_cycles)
+		if (state_.cycles > boot_up_cycles)
 		{
 			NES_DEBUG_LOG(ppu, "PPUCTRL <- {:#2x}", value);
-			control_.value = value;
-			internal_.t.set_name_table(control_.get_base_name_table());
-			if (control_.get_vblank_nmi() && status_.get_vblank()) { cpu_.trigger_nmi(); }
+			state_.control.value = value;
+			state_.internal.t.set_name_table(state_.control.get_base_name_table());
+			if (state_.control.get_vblank_nmi() && state_.status.get_vblank()) { cpu_.trigger_nmi(); }
 		}
 	}
 
 	auto ppu::write_ppuscroll(u8 const value) -> void
 	{
 		write_latch(value);
-		if (current_cycles_ > boot_up_cycles)
+		if (state_.cycles > boot_up_cycles)
 		{
 			NES_DEBUG_LOG(ppu, "PPUSCROLL <- {:#2x}", value);
-			if (!internal_.w)
+			if (!state_.internal.w)
 			{
 				// First write -> x value.
-				internal_.t.set_coarse_x((value & 0b11111000) >> 3);
-				internal_.x = (value & 0b00000111) >> 0;
+				state_.internal.t.set_coarse_x((value & 0b11111000) >> 3);
+				state_.internal.x = (value & 0b00000111) >> 0;
 			}
 			else
 			{
 				// Second write -> y value.
-				internal_.t.set_coarse_y((value & 0b11111000) >> 3);
-				internal_.t.set_fine_y((value & 0b00000111) >> 0);
+				state_.internal.t.set_coarse_y((value & 0b11111000) >> 3);
+				state_.internal.t.set_fine_y((value & 0b00000111) >> 0);
 			}
 
-			internal_.w = !internal_.w;
+			state_.internal.w = !state_.internal.w;
 		}
 	}
 
 	auto ppu::write_ppumask(u8 const value) -> void
 	{
 		write_latch(value);
-		if (current_cycles_ > boot_up_cycles)
+		if (state_.cycles > boot_up_cycles)
 		{
 			NES_DEBUG_LOG(ppu, "PPUMASK <- {:#2x}", value);
-			mask_.value = value;
+			state_.mask.value = value;
 		}
 	}
 
 	auto ppu::write_ppuaddr(u8 const value) -> void
 	{
 		write_latch(value);
-		if (current_cycles_ > boot_up_cycles)
+		if (state_.cycles > boot_up_cycles)
 		{
 			NES_DEBUG_LOG(ppu, "PPUADDR <- {:#2x}", value);
-			if (!internal_.w)
+			if (!state_.internal.w)
 			{
 				// First write.
-				internal_.t.set_address_high(value & 0b00111111);
+				state_.internal.t.set_address_high(value & 0b00111111);
 			}
 			else
 			{
 				// Second write.
-				internal_.t.set_address_low(value);
-				internal_.v = internal_.t;
+				state_.internal.t.set_address_low(value);
+				state_.internal.v = state_.internal.t;
 			}
 
-			internal_.w = !internal_.w;
+			state_.internal.w = !state_.internal.w;
 		}
 	}
 
 	auto ppu::write_ppudata(u8 const value) -> void
 	{
-		NES_DEBUG_LOG(ppu, "PPUDATA <- {:#2x} (address: {:#4x})", value, internal_.v);
+		NES_DEBUG_LOG(ppu, "PPUDATA <- {:#2x} (address: {:#4x})", value, state_.internal.v);
 		write_latch(value);
-		write8(address{ internal_.v.value }, value);
+		write8(address{ state_.internal.v.value }, value);
 		increment_vram();
 	}
 
@@ -482,15 +492,15 @@ namespace nes::sys
 	{
 		NES_DEBUG_LOG(ppu, "OAMADDR <- {:#2x}", value);
 		write_latch(value);
-		oamaddr_ = value;
+		state_.oamaddr = value;
 	}
 
 	auto ppu::write_oamdata(u8 const value) -> void
 	{
 		NES_DEBUG_LOG(ppu, "OAMDATA <- {:#2x}", value);
 		write_latch(value);
-		oam_[oamaddr_] = value;
-		oamaddr_ += 1;
+		oam_.write(state_.oamaddr, value);
+		state_.oamaddr += 1;
 	}
 
 	auto ppu::write_oamdma(u8 const value) -> void
@@ -499,8 +509,8 @@ namespace nes::sys
 		auto addr = address{ value, 0x00 };
 		for (auto i = u32{ 0 }; i < 256; ++i)
 		{
-			oam_[oamaddr_] = cpu_.read8(addr);
-			oamaddr_ += 1;
+			oam_.write(state_.oamaddr, cpu_.read8(addr));
+			state_.oamaddr += 1;
 			addr = addr + 1;
 		}
 
@@ -514,72 +524,72 @@ namespace nes::sys
 
 	auto ppu::increment_vram() -> void
 	{
-		switch (control_.get_vram_increment())
+		switch (state_.control.get_vram_increment())
 		{
 			case vram_increment::forward:
-				internal_.v.value += 1;
+				state_.internal.v.value += 1;
 				break;
 			case vram_increment::downward:
-				internal_.v.value += 32;
+				state_.internal.v.value += 32;
 				break;
 		}
 	}
 
 	auto ppu::increment_x() -> void
 	{
-		if (internal_.v.get_coarse_x() == 31)
+		if (state_.internal.v.get_coarse_x() == 31)
 		{
-			internal_.v.set_coarse_x(0);
-			internal_.v.set_horizontal_name_table(1 ^ internal_.v.get_horizontal_name_table());
+			state_.internal.v.set_coarse_x(0);
+			state_.internal.v.set_horizontal_name_table(1 ^ state_.internal.v.get_horizontal_name_table());
 		}
 		else
 		{
-			internal_.v.set_coarse_x(internal_.v.get_coarse_x() + 1);
+			state_.internal.v.set_coarse_x(state_.internal.v.get_coarse_x() + 1);
 		}
 	}
 
 	auto ppu::increment_y() -> void
 	{
-		if (internal_.v.get_fine_y() == 7)
+		if (state_.internal.v.get_fine_y() == 7)
 		{
-			internal_.v.set_fine_y(0);
-			if (internal_.v.get_coarse_y() == 29)
+			state_.internal.v.set_fine_y(0);
+			if (state_.internal.v.get_coarse_y() == 29)
 			{
-				internal_.v.set_coarse_y(0);
-				internal_.v.set_vertical_name_table(1 ^ internal_.v.get_vertical_name_table());
+				state_.internal.v.set_coarse_y(0);
+				state_.internal.v.set_vertical_name_table(1 ^ state_.internal.v.get_vertical_name_table());
 			}
-			else if (internal_.v.get_coarse_y() == 31)
+			else if (state_.internal.v.get_coarse_y() == 31)
 			{
-				internal_.v.set_coarse_y(0);
+				state_.internal.v.set_coarse_y(0);
 				// Nametable not switched
 			}
 			else
 			{
-				internal_.v.set_coarse_y(internal_.v.get_coarse_y() + 1);
+				state_.internal.v.set_coarse_y(state_.internal.v.get_coarse_y() + 1);
 			}
 		}
 		else
 		{
-			internal_.v.set_fine_y(internal_.v.get_fine_y() + 1);
+			state_.internal.v.set_fine_y(state_.internal.v.get_fine_y() + 1);
 		}
 	}
 
 	auto ppu::copy_x() -> void
 	{
-		internal_.v.set_coarse_x(internal_.t.get_coarse_x());
-		internal_.v.set_horizontal_name_table(internal_.t.get_horizontal_name_table());
+		state_.internal.v.set_coarse_x(state_.internal.t.get_coarse_x());
+		state_.internal.v.set_horizontal_name_table(state_.internal.t.get_horizontal_name_table());
 	}
 
 	auto ppu::copy_y() -> void
 	{
-		internal_.v.set_coarse_y(internal_.t.get_coarse_y());
-		internal_.v.set_fine_y(internal_.t.get_fine_y());
-		internal_.v.set_vertical_name_table(internal_.t.get_vertical_name_table());
+		state_.internal.v.set_coarse_y(state_.internal.t.get_coarse_y());
+		state_.internal.v.set_fine_y(state_.internal.t.get_fine_y());
+		state_.internal.v.set_vertical_name_table(state_.internal.t.get_vertical_name_table());
 	}
 
 	auto ppu::get_sprite_height() const -> u32
 	{
-		switch (control_.get_sprite_size())
+		switch (state_.control.get_sprite_size())
 		{
 			case sprite_size::single_height:
 				return tile_size;
@@ -590,25 +600,20 @@ namespace nes::sys
 		return tile_size;
 	}
 
-	auto ppu::get_tile_bitplane(
-		pattern_table const pattern_table, tile const tile, u32 const row, bitplane const bitplane) -> u8
+	auto ppu::get_tile_pattern(pattern_table const pattern_table, tile const tile, u32 const row) -> u16
 	{
 		auto const addr = static_cast<u16>(
 			0x1000 * static_cast<u32>(pattern_table) + 0x10 * static_cast<u32>(tile) + row);
-		return read8(address{ addr } + (static_cast<u32>(bitplane) * 8u));
+		return cartridge_.get_mapper().read_ppu_tile_row(address{ addr }, cartridge_);
 	}
 
-	auto ppu::get_tile_row(palette const palette, u8 bitplane_0, u8 bitplane_1) const -> tile_row
+	auto ppu::get_tile_row(palette const palette, u16 const pattern) const -> tile_row
 	{
 		auto res = tile_row{};
 		for (auto i = u32{ 0 }; i < tile_size; ++i)
 		{
-			auto const bit_0 = (bitplane_0 & 0b10000000u) >> 7;
-			auto const bit_1 = (bitplane_1 & 0b10000000u) >> 7;
-			bitplane_0 <<= 1;
-			bitplane_1 <<= 1;
 			res.colors[i].set_palette(palette);
-			res.colors[i].set_color(palette_color{ (bit_1 << 1) | (bit_0 << 0) });
+			res.colors[i].set_color(palette_color{ (pattern >> (14 - 2 * i)) & 0b11u });
 		}
 		return res;
 	}
@@ -622,10 +627,15 @@ namespace nes::sys
 			// The first color is mirrored between background and foreground palettes.
 			index.set_role(role::background);
 		}
-		return palette_buffer_[index.value];
+		return state_.palette_buffer[index.value];
+	}
+
+	auto ppu::get_palette_rgb(u8 const index) -> rgb
+	{
+		return resolve_color(color{ index });
 	}
 
-	auto ppu::resolve_color(color const color) const -> rgb
+	auto ppu::resolve_color(color const color) -> rgb
 	{
 		auto const index = static_cast<u8>(color);
 		switch (index & 0x3F)
@@ -2,6 +2,8 @@
 
 #include "nes/sys/types/cycle-count.hh"
 #include "nes/sys/types/snapshot.hh"
+#include "nes/sys/types/paged-memory.hh"
+#include "nes/sys/mapper.hh"
 #include "nes/common/containers/span.hh"
 #include "nes/common/types.hh"
 
@@ -20,14 +22,12 @@ namespace nes::sys
 	class ppu
 	{
 		static constexpr auto sprite_max_count = u32{ 64 };
-		static constexpr auto vram_size = u32{ 0x800 };
 		static constexpr auto oam_size = u32{ sprite_max_count * 4 };
 		static constexpr auto palette_buffer_size = u32{ 0x20 };
 		static constexpr auto tile_size = u32{ 8 };
 		// Writes to some registers are ignored until this clock cycle.
 		static constexpr auto boot_up_cycles = cycle_count::from_ppu(29658);
 
-		enum class bitplane : u32 { _0, _1 };
 		enum class palette : u32 { _0, _1, _2, _3 };
 		enum class palette_color : u32 { _0, _1, _2, _3 };
 		enum class name_table : u32 { _0, _1, _2, _3 };
@@ -116,114 +116,128 @@ namespace nes::sys
 			bool is_sprite_zero{ false };
 		};
 
-		cycle_count current_cycles_;
-		cpu& cpu_;
-		cartridge& cartridge_;
-		display& display_;
-		u8 vram_[vram_size]{};
-		u8 oam_[oam_size]{};
-		color palette_buffer_[palette_buffer_size]
-		{
-			color{ 0x09 }, color{ 0x01 }, color{ 0x00 }, color{ 0x01 },
-			color{ 0x00 }, color{ 0x02 }, color{ 0x02 }, color{ 0x0D },
-			color{ 0x08 }, color{ 0x10 }, color{ 0x08 }, color{ 0x24 },
-			color{ 0x00 }, color{ 0x00 }, color{ 0x04 }, color{ 0x2C },
-			color{ 0x09 }, color{ 0x01 }, color{ 0x34 }, color{ 0x03 },
-			color{ 0x00 }, color{ 0x04 }, color{ 0x00 }, color{ 0x14 },
-			color{ 0x08 }, color{ 0x3A }, color{ 0x00 }, color{ 0x02 },
-			color{ 0x00 }, color{ 0x20 }, color{ 0x2C }, color{ 0x08 },
-		};
-		u8 latch_{}; // The last read/written IO register value, returned when reading write-only registers.
-		struct
+	public:
+		using oam = paged_memory<oam_size>;
+
+		/// All mutable state of the PPU except for its memory, which can be saved and restored as a whole.
+		struct state
 		{
-			BITFIELD_FLAG(sprite_overflow, value, 0b00100000, 5)
-			BITFIELD_FLAG(sprite_zero_hit, value, 0b01000000, 6)
-			BITFIELD_FLAG(vblank, value, 0b10000000, 7)
+			cycle_count cycles{};
+			color palette_buffer[palette_buffer_size]
+			{
+				color{ 0x09 }, color{ 0x01 }, color{ 0x00 }, color{ 0x01 },
+				color{ 0x00 }, color{ 0x02 }, color{ 0x02 }, color{ 0x0D },
+				color{ 0x08 }, color{ 0x10 }, color{ 0x08 }, color{ 0x24 },
+				color{ 0x00 }, color{ 0x00 }, color{ 0x04 }, color{ 0x2C },
+				color{ 0x09 }, color{ 0x01 }, color{ 0x34 }, color{ 0x03 },
+				color{ 0x00 }, color{ 0x04 }, color{ 0x00 }, color{ 0x14 },
+				color{ 0x08 }, color{ 0x3A }, color{ 0x00 }, color{ 0x02 },
+				color{ 0x00 }, color{ 0x20 }, color{ 0x2C }, color{ 0x08 },
+			};
+			u8 latch{}; // The last read/written IO register value, returned when reading write-only registers.
+			struct
+			{
+				BITFIELD_FLAG(sprite_overflow, value, 0b00100000, 5)
+				BITFIELD_FLAG(sprite_zero_hit, value, 0b01000000, 6)
+				BITFIELD_FLAG(vblank, value, 0b10000000, 7)
 
-			// Set the remaining (unused) bits based on the given value.
-			auto set_remaining(u8 const v) -> void { value = (value & ~0b00011111) | (v & 0b00011111); }
+				// Set the remaining (unused) bits based on the given value.
+				auto set_remaining(u8 const v) -> void { value = (value & ~0b00011111) | (v & 0b00011111); }
 
-			u8 value{ 0b00000000 };
-		} status_{};
-		struct
-		{
-			// Base nametable address.
-			BITFIELD_ENUM(base_name_table, name_table, value, 0b00000011, 0)
-			// How VRAM addresses should be incremented each read/write.
-			BITFIELD_ENUM(vram_increment, vram_increment, value, 0b00000100, 2)
-			// Sprite pattern table address for 8x8 sprites.
-			BITFIELD_ENUM(sprite_pattern_table, pattern_table, value, 0b00001000, 3)
-			// Background pattern table address.
-			BITFIELD_ENUM(background_pattern_table, pattern_table, value, 0b00010000, 4)
-			// The size of the sprites used (i.e. single-height or double-height).
-			BITFIELD_ENUM(sprite_size, sprite_size, value, 0b00100000, 5)
-			// PPU master/slave select.
-			BITFIELD_FLAG(enable_ext_pin, value, 0b01000000, 6)
-			// Enable/disable vblank NMI.
-			BITFIELD_FLAG(vblank_nmi, value, 0b10000000, 7)
-
-			u8 value{ 0b00000000 };
-		} control_{};
-		struct
-		{
-			// Enable/disable grayscale.
-			BITFIELD_FLAG(grayscale, value, 0b00000001, 0)
-			// Show background in leftmost 8 pixels of screen.
-			BITFIELD_FLAG(show_background_start, value, 0b00000010, 1)
-			// Show sprites in leftmost 8 pixels of screen.
-			BITFIELD_FLAG(show_sprites_start, value, 0b00000100, 2)
-			// Enable background rendering.
-			BITFIELD_FLAG(enable_background, value, 0b00001000, 3)
-			// Enable sprite rendering.
-			BITFIELD_FLAG(enable_sprites, value, 0b00010000, 4)
-			// Emphasize red.
-			BITFIELD_FLAG(emphasize_red, value, 0b00100000, 5)
-			// Emphasize green.
-			BITFIELD_FLAG(emphasize_green, value, 0b01000000, 6)
-			// Emphasize blue.
-			BITFIELD_FLAG(emphasize_blue, value, 0b10000000, 7)
-
-			u8 value{ 0b00000000 };
-		} mask_{};
-		struct
-		{
-			// See https://www.nesdev.org/wiki/PPU_scrolling#PPU_internal_registers
+				u8 value{ 0b00000000 };
+			} status{};
 			struct
 			{
-				// Scroll position
-				BITFIELD_VALUE(coarse_x, value, 0b0000000000011111, 0)
-				BITFIELD_VALUE(coarse_y, value, 0b0000001111100000, 5)
-				BITFIELD_ENUM(name_table, name_table, value, 0b0000110000000000, 10)
-				BITFIELD_VALUE(horizontal_name_table, value, 0b0000010000000000, 10)
-				BITFIELD_VALUE(vertical_name_table, value, 0b0000100000000000, 11)
-				BITFIELD_VALUE(tile_address, value, 0b0000111111111111, 0)
-				BITFIELD_VALUE(fine_y, value, 0b0111000000000000, 12)
-
-				// Address
-				BITFIELD_VALUE(address_low, value, 0b0000000011111111, 0)
-				BITFIELD_VALUE(address_high, value, 0b0111111100000000, 8)
-
-				u16 value{};
-			} v{}, t{}; // Current and temporary VRAM address and scroll position (15 bits)
-			u8 x{}; // Fine X scroll (3 bits)
-			bool w{}; // Second write toggle (1 bit)
-		} internal_{};
-		u8 oamaddr_{}; // Address accessed by IO registers
-		u8 ppudata_read_buffer_{}; // Delays PPUDATA reads by one.
-		u32 scanline_{ 240 };
-		u32 scanline_cycle_{ 340 };
-		bool even_frame_{ true };
-		tile_row current_background_{};
-		tile_row next_background_{};
-		struct
-		{
-			tile background_tile{ 0 };
-			palette background_palette{ 0 };
-			u8 pattern_bitplane_0{ 0 };
-			u8 pattern_bitplane_1{ 0 };
-		} fetch_cycle_{}; // Data populated during the fetch cycle.
-		evaluated_sprite sprites_[8]{}; // Evaluated sprites.
-		u32 sprite_count_{ 0 }; // Number of evaluated sprites in sprites_.
+				// Base nametable address.
+				BITFIELD_ENUM(base_name_table, name_table, value, 0b00000011, 0)
+				// How VRAM addresses should be incremented each read/write.
+				BITFIELD_ENUM(vram_increment, vram_increment, value, 0b00000100, 2)
+				// Sprite pattern table address for 8x8 sprites.
+				BITFIELD_ENUM(sprite_pattern_table, pattern_table, value, 0b00001000, 3)
+				// Background pattern table address.
+				BITFIELD_ENUM(background_pattern_table, pattern_table, value, 0b00010000, 4)
+				// The size of the sprites used (i.e. single-height or double-height).
+				BITFIELD_ENUM(sprite_size, sprite_size, value, 0b00100000, 5)
+				// PPU master/slave select.
+				BITFIELD_FLAG(enable_ext_pin, value, 0b01000000, 6)
+				// Enable/disable vblank NMI.
+				BITFIELD_FLAG(vblank_nmi, value, 0b10000000, 7)
+
+				u8 value{ 0b00000000 };
+			} control{};
+			struct
+			{
+				// Enable/disable grayscale.
+				BITFIELD_FLAG(grayscale, value, 0b00000001, 0)
+				// Show background in leftmost 8 pixels of screen.
+				BITFIELD_FLAG(show_background_start, value, 0b00000010, 1)
+				// Show sprites in leftmost 8 pixels of screen.
+				BITFIELD_FLAG(show_sprites_start, value, 0b00000100, 2)
+				// Enable background rendering.
+				BITFIELD_FLAG(enable_background, value, 0b00001000, 3)
+				// Enable sprite rendering.
+				BITFIELD_FLAG(enable_sprites, value, 0b00010000, 4)
+				// Emphasize red.
+				BITFIELD_FLAG(emphasize_red, value, 0b00100000, 5)
+				// Emphasize green.
+				BITFIELD_FLAG(emphasize_green, value, 0b01000000, 6)
+				// Emphasize blue.
+				BITFIELD_FLAG(emphasize_blue, value, 0b10000000, 7)
+
+				u8 value{ 0b00000000 };
+			} mask{};
+			struct
+			{
+				// See https://www.nesdev.org/wiki/PPU_scrolling#PPU_internal_registers
+				struct
+				{
+					// Scroll position
+					BITFIELD_VALUE(coarse_x, value, 0b0000000000011111, 0)
+					BITFIELD_VALUE(coarse_y, value, 0b0000001111100000, 5)
+					BITFIELD_ENUM(name_table, name_table, value, 0b0000110000000000, 10)
+					BITFIELD_VALUE(horizontal_name_table, value, 0b0000010000000000, 10)
+					BITFIELD_VALUE(vertical_name_table, value, 0b0000100000000000, 11)
+					BITFIELD_VALUE(tile_address, value, 0b0000111111111111, 0)
+					BITFIELD_VALUE(fine_y, value, 0b0111000000000000, 12)
+
+					// Address
+					BITFIELD_VALUE(address_low, value, 0b0000000011111111, 0)
+					BITFIELD_VALUE(address_high, value, 0b0111111100000000, 8)
+
+					u16 value{};
+				} v{}, t{}; // Current and temporary VRAM address and scroll position (15 bits)
+				u8 x{}; // Fine X scroll (3 bits)
+				bool w{}; // Second write toggle (1 bit)
+			} internal{};
+			u8 oamaddr{}; // Address accessed by IO registers
+			u8 ppudata_read_buffer{}; // Delays PPUDATA reads by one.
+			u32 scanline{ 240 };
+			u32 scanline_cycle{ 340 };
+			bool even_frame{ true };
+			u8 padding_1[3]{};
+			u64 frame_count{ 0 }; // Number of frames completed (at the start of vblank).
+			tile_row current_background{};
+			tile_row next_background{};
+			struct
+			{
+				tile background_tile{ 0 };
+				u8 padding_1[3]{};
+				palette background_palette{ 0 };
+				u16 pattern{ 0 };
+				u8 padding_2[2]{};
+			} fetch_cycle{}; // Data populated during the fetch cycle.
+			evaluated_sprite sprites[8]{}; // Evaluated sprites.
+			u32 sprite_count{ 0 }; // Number of evaluated sprites in sprites.
+		};
+
+	private:
+		state state_{};
+		name_table_memory vram_{};
+		oam oam_{};
+		cpu& cpu_;
+		cartridge& cartridge_;
+		display& display_;
+		bool video_enabled_{ true };
 
 #undef BITFIELD_VALIDATE
 #undef BITFIELD_VALUE
@@ -238,7 +252,18 @@ namespace nes::sys
 		auto operator=(ppu const&) -> ppu& = delete;
 		auto operator=(ppu&&) -> ppu& = delete;
 
-		auto get_cycles() const -> cycle_count { return current_cycles_; }
+		auto get_cycles() const -> cycle_count { return state_.cycles; }
+		auto get_state() const -> state const& { return state_; }
+		auto set_state(state const& value) -> void { state_ = value; }
+		auto get_vram() const -> name_table_memory const& { return vram_; }
+		auto ref_vram() -> name_table_memory& { return vram_; }
+		auto get_oam() const -> oam const& { return oam_; }
+		auto ref_oam() -> oam& { return oam_; }
+		auto get_frame_count() const -> u64 { return state_.frame_count; }
+		/// While disabled, frames are emulated as usual but not passed to the display.
+		auto set_video_enabled(bool const value) -> void { video_enabled_ = value; }
+		/// RGB value of an index (0-63) in the console's palette.
+		static auto get_palette_rgb(u8 index) -> rgb;
 #ifdef NES_ENABLE_SNAPSHOTS
 		auto build_snapshot(snapshot&) -> void;
 #endif
@@ -268,6 +293,7 @@ namespace nes::sys
 
 	private:
 		auto render_pixel() -> void;
+		auto output_pixel(u32 x, u32 y, color_index) -> void;
 		auto evaluate_sprites() -> void;
 		auto fetch_sprite_pattern(sprite, u32 row) -> tile_row;
 
@@ -279,9 +305,9 @@ namespace nes::sys
 		auto copy_x() -> void;
 		auto copy_y() -> void;
 		auto get_sprite_height() const -> u32;
-		auto get_tile_bitplane(pattern_table, tile, u32 row, bitplane) -> u8;
-		auto get_tile_row(palette, u8 bitplane_0, u8 bitplane_1) const -> tile_row;
+		auto get_tile_pattern(pattern_table, tile, u32 row) -> u16;
+		auto get_tile_row(palette, u16 pattern) const -> tile_row;
 		auto ref_color(color_index) -> color&;
-		auto resolve_color(color) const -> rgb;
+		static auto resolve_color(color) -> rgb;
 	};
 } // namespace nes::sys
@@ -0,0 +1,28 @@
+#include "nes/sys/rom-database.hh"
+#include "nes/sys/database/roms.hh"
+
+namespace nes::sys::rom_database
+{
+	auto find(u32 const crc32) -> entry const*
+	{
+		// The generator guarantees that the entries are sorted by CRC-32 and unique.
+		auto first = u32{ 0 };
+		auto last = database::roms_count;
+		while (first < last)
+		{
+			auto const middle = first + (last - first) / 2;
+			auto const& e = database::roms[middle];
+			if (e.crc32 == crc32) { return &e; }
+			if (e.crc32 < crc32)
+			{
+				first = middle + 1;
+			}
+			else
+			{
+				last = middle;
+			}
+		}
+
+		return nullptr;
+	}
+} // namespace nes::sys::rom_database
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "nes/sys/types/name-table-arrangement.hh"
+#include "nes/common/types.hh"
+
+namespace nes::sys::rom_database
+{
+	/// Known-good board properties for a single ROM, used to correct bad iNES headers.
+	struct entry
+	{
+		u32 crc32{ 0 }; // CRC-32 of the PRG-ROM followed by the CHR-ROM (without header and trainer).
+		u16 mapper{ 0 };
+		sys::name_table_arrangement name_table_arrangement{};
+		u8 prg_ram_kib{ 0 };
+	};
+
+	/// Look up a ROM by the CRC-32 of its PRG-ROM and CHR-ROM data in O(log n).
+	auto find(u32 crc32) -> entry const*;
+} // namespace nes::sys::rom_database
@@ -0,0 +1,170 @@
+#include "nes/sys/rom-image.hh"
+#include "nes/sys/rom-database.hh"
+#include "nes/common/crc32.hh"
+#include "nes/common/status.hh"
+#include "nes/common/utils.hh"
+
+namespace nes::sys
+{
+	namespace
+	{
+		// NES 2.0 ROM sizes are either a number of banks or, if the most significant nibble is $F, use an
+		// exponent-multiplier notation.
+		auto decode_rom_size(u32 const lsb, u32 const msb, u32 const bank_size) -> u64
+		{
+			if (msb == 0xF)
+			{
+				auto const exponent = lsb >> 2;
+				auto const multiplier = (lsb & 0b11) * 2 + 1;
+				if (exponent >= 32) { return ~u64{ 0 }; }
+				return (u64{ 1 } << exponent) * multiplier;
+			}
+
+			return static_cast<u64>((msb << 8) | lsb) * bank_size;
+		}
+
+		auto decode_ram_size(u32 const shift) -> u64
+		{
+			return shift == 0 ? 0 : u64{ 64 } << shift;
+		}
+	} // namespace
+
+	// -----------------------------------------------------------------------------------------------------------------
+	// Header
+	// -----------------------------------------------------------------------------------------------------------------
+
+	//
+	// See: https://www.nesdev.org/wiki/INES and https://www.nesdev.org/wiki/NES_2.0
+	//
+
+	auto rom_image::header::get_mapper_number() const -> u16
+	{
+		switch (get_format())
+		{
+			case header_format::ines:
+			{
+				// Old dumping tools wrote signatures like "DiskDude!" starting at byte 7. Bytes 12-15 are unused (and
+				// thus empty) in valid headers, so if they contain anything, the upper nibble in byte 7 cannot be
+				// trusted either.
+				auto const has_garbage = (value[12] | value[13] | value[14] | value[15]) != 0;
+				return static_cast<u16>((has_garbage ? 0 : get_mapper_high()) | get_mapper_low());
+			}
+			case header_format::nes_2_0:
+				return static_cast<u16>(get_mapper_extended() | get_mapper_high() | get_mapper_low());
+		}
+
+		return 0;
+	}
+
+	auto rom_image::header::get_prg_rom_size() const -> u64
+	{
+		switch (get_format())
+		{
+			case header_format::ines:
+				return get_prg_rom_size_lsb() * prg_rom_bank_size;
+			case header_format::nes_2_0:
+				return decode_rom_size(get_prg_rom_size_lsb(), get_prg_rom_size_msb(), prg_rom_bank_size);
+		}
+
+		return 0;
+	}
+
+	auto rom_image::header::get_chr_rom_size() const -> u64
+	{
+		switch (get_format())
+		{
+			case header_format::ines:
+				return get_chr_rom_size_lsb() * chr_rom_bank_size;
+			case header_format::nes_2_0:
+				return decode_rom_size(get_chr_rom_size_lsb(), get_chr_rom_size_msb(), chr_rom_bank_size);
+		}
+
+		return 0;
+	}
+
+	auto rom_image::header::get_ram_size() const -> u64
+	{
+		switch (get_format())
+		{
+			case header_format::ines:
+				return get_ram_banks() * ram_bank_size;
+			case header_format::nes_2_0:
+				return decode_ram_size(get_prg_ram_shift()) + decode_ram_size(get_prg_nvram_shift());
+		}
+
+		return 0;
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	// ROM Image
+	// -----------------------------------------------------------------------------------------------------------------
+
+	rom_image::rom_image(span<u8 const> const data)
+	{
+		// Parse header.
+		if (data.get_length() < header_length) { return; }
+		auto const h = header{ data.subspan<header_length>(0) };
+		if (h.get_magic_0() != 'N' || h.get_magic_1() != 'E' || h.get_magic_2() != 'S' || h.get_magic_3() != 0x1A)
+		{
+			return;
+		}
+
+		header_format_ = h.get_format();
+		mapper_number_ = h.get_mapper_number();
+		name_table_arrangement_ = h.get_name_table_arrangement();
+		auto ram_size = h.get_ram_size();
+
+		// Load program data.
+		auto offset = u32{ 16 };
+		if (h.get_has_trainer()) { offset += 512; }
+
+		if (h.get_prg_rom_size() > max_prg_rom_size) { return; }
+		prg_rom_size_ = static_cast<u32>(h.get_prg_rom_size());
+		if (data.get_length() < offset + prg_rom_size_) { return; }
+		copy(&data[offset], prg_rom_, prg_rom_size_);
+
+		offset += prg_rom_size_;
+
+		if (h.get_chr_rom_size() > max_chr_rom_size) { return; }
+		chr_rom_size_ = static_cast<u32>(h.get_chr_rom_size());
+		if (data.get_length() < offset + chr_rom_size_) { return; }
+		copy(&data[offset], chr_rom_, chr_rom_size_);
+
+		// Each 16 byte tile consists of 8 bytes for bitplane 0 followed by 8 bytes for bitplane 1.
+		for (auto tile = u32{ 0 }; tile < chr_rom_size_ / 16; ++tile)
+		{
+			for (auto row = u32{ 0 }; row < 8; ++row)
+			{
+				chr_tile_rows_[tile * 8 + row] = decode_tile_row(chr_rom_[tile * 16 + row], chr_rom_[tile * 16 + row + 8]);
+			}
+		}
+
+		// Replace the header contents with known-good values if the ROM is in the database.
+		auto checksum = crc32{};
+		checksum.update(get_prg_rom());
+		checksum.update(get_chr_rom());
+		crc32_ = checksum.get_value();
+		if (auto const entry = rom_database::find(crc32_))
+		{
+			corrected_ = true;
+			mapper_number_ = entry->mapper;
+			name_table_arrangement_ = entry->name_table_arrangement;
+			ram_size = entry->prg_ram_kib * u64{ 1024 };
+		}
+
+		mapper_ = &mapper::get(mapper_number_);
+
+		// Many games expect work RAM without declaring it, so at least one bank is always provided.
+		ram_size = max(ram_size, u64{ ram_bank_size });
+		if (ram_size > max_ram_size) { return; }
+		ram_size_ = static_cast<u32>(ram_size);
+
+		status_ = get_mapper().validate(*this);
+		if (status_ != status::success) { return; }
+	}
+
+	rom_image::~rom_image()
+	{
+		NES_ASSERT(get_user_count() == 0 && "ROM image destroyed while still in use");
+	}
+} // namespace nes::sys
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "nes/sys/types/name-table-arrangement.hh"
+#include "nes/sys/mapper.hh"
+#include "nes/common/containers/span.hh"
+#include "nes/common/debug.hh"
+#include "nes/common/status.hh"
+#include "nes/common/types.hh"
+
+namespace nes::sys
+{
+	enum class header_format
+	{
+		ines,
+		nes_2_0,
+	};
+
+	/// The immutable contents of an iNES file.
+	///
+	/// A ROM image can be shared by any number of consoles running the same game. The image does not manage its own
+	/// lifetime and must outlive all consoles created from it. Cartridges only count their uses of the image, so
+	/// destroying it too early is detected in debug builds.
+	class rom_image
+	{
+		static constexpr auto prg_rom_bank_size = u32{ 16 * 1024 };
+		static constexpr auto chr_rom_bank_size = u32{ 8 * 1024 };
+		static constexpr auto ram_bank_size = u32{ 8 * 1024 };
+		static constexpr auto max_prg_rom_size = u32{ 4 * prg_rom_bank_size };
+		static constexpr auto max_chr_rom_size = u32{ 4 * chr_rom_bank_size };
+		static constexpr auto header_length = u32{ 16 };
+		static constexpr auto tile_row_stride = u32{ 2 };
+
+		struct header
+		{
+			auto get_magic_0() const -> u8 { return value[0]; }
+			auto get_magic_1() const -> u8 { return value[1]; }
+			auto get_magic_2() const -> u8 { return value[2]; }
+			auto get_magic_3() const -> u8 { return value[3]; }
+			auto get_prg_rom_size_lsb() const -> u32 { return value[4]; }
+			auto get_chr_rom_size_lsb() const -> u32 { return value[5]; }
+			auto get_control_1() const -> u8 { return value[6]; }
+			auto get_control_2() const -> u8 { return value[7]; }
+			auto get_ram_banks() const -> u32 { return value[8]; }
+			auto get_has_trainer() const -> bool { return get_control_1() & 0b00000100; }
+			auto get_mapper_low() const -> u32 { return (get_control_1() & 0b11110000) >> 4; }
+			auto get_mapper_high() const -> u32 { return (get_control_2() & 0b11110000) >> 0; }
+			auto get_name_table_arrangement() const -> name_table_arrangement { return static_cast<name_table_arrangement>((get_control_1() & 0b00000001) >> 0); }
+			auto get_format() const -> header_format { return (get_control_2() & 0b00001100) == 0b00001000 ? header_format::nes_2_0 : header_format::ines; }
+
+			// NES 2.0 only
+			auto get_mapper_extended() const -> u32 { return (value[8] & 0b00001111) << 8; }
+			auto get_prg_rom_size_msb() const -> u32 { return (value[9] & 0b00001111) >> 0; }
+			auto get_chr_rom_size_msb() const -> u32 { return (value[9] & 0b11110000) >> 4; }
+			auto get_prg_ram_shift() const -> u32 { return (value[10] & 0b00001111) >> 0; }
+			auto get_prg_nvram_shift() const -> u32 { return (value[10] & 0b11110000) >> 4; }
+
+			u8 value[header_length]{};
+
+			explicit header(span<u8 const, header_length> const v)
+			{
+				for (auto i = u32{ 0 }; i < header_length; ++i)
+				{
+					value[i] = v[i];
+				}
+			}
+
+			auto get_mapper_number() const -> u16;
+			auto get_prg_rom_size() const -> u64;
+			auto get_chr_rom_size() const -> u64;
+			auto get_ram_size() const -> u64;
+		};
+
+		status status_{ status::error_invalid_ines_data };
+		header_format header_format_{};
+		u32 crc32_{ 0 };
+		bool corrected_{ false };
+		u16 mapper_number_{ 0 };
+		u8 prg_rom_[max_prg_rom_size]{};
+		u8 chr_rom_[max_chr_rom_size]{};
+		u16 chr_tile_rows_[max_chr_rom_size / tile_row_stride]{}; // Pre-decoded pattern rows, see decode_tile_row.
+		u32 prg_rom_size_{};
+		u32 chr_rom_size_{};
+		u32 ram_size_{};
+		name_table_arrangement name_table_arrangement_{};
+		mapper* mapper_{ &mapper::invalid() };
+		mutable u32 users_{ 0 }; // Number of cartridges using the image, only checked when it is destroyed.
+
+	public:
+		static constexpr auto max_ram_size = u32{ 4 * ram_bank_size };
+		static constexpr auto max_file_size = u32{ max_prg_rom_size + max_chr_rom_size + 512 + header_length };
+
+		explicit rom_image(span<u8 const>);
+		~rom_image();
+
+		rom_image(rom_image const&) = delete;
+		rom_image(rom_image&&) = delete;
+		auto operator=(rom_image const&) -> rom_image& = delete;
+		auto operator=(rom_image&&) -> rom_image& = delete;
+
+		auto get_status() const -> status { return status_; }
+		auto get_header_format() const -> header_format { return header_format_; }
+		/// CRC-32 of the PRG-ROM followed by the CHR-ROM, used as the key in the ROM database.
+		auto get_crc32() const -> u32 { return crc32_; }
+		/// Indicates whether the header contents were replaced by a ROM database entry.
+		auto is_corrected() const -> bool { return corrected_; }
+		auto get_mapper_number() const -> u16 { return mapper_number_; }
+		auto get_prg_rom() const -> span<u8 const> { return span{ prg_rom_, prg_rom_size_ }; }
+		auto get_chr_rom() const -> span<u8 const> { return span{ chr_rom_, chr_rom_size_ }; }
+		/// Size of the PRG-RAM requested by the header or database (the RAM itself is part of each cartridge).
+		auto get_ram_size() const -> u32 { return ram_size_; }
+		auto get_mapper() const -> mapper& { return *mapper_; }
+		auto get_name_table_arrangement() const -> name_table_arrangement { return name_table_arrangement_; }
+
+		/// Get the pre-decoded pattern table row starting at the given CHR-ROM offset.
+		auto get_chr_tile_row(u32 const offset) const -> u16
+		{
+			NES_ASSERT(offset < chr_rom_size_ && "tile row out of bounds");
+			return chr_tile_rows_[(offset / 16) * 8 + (offset % 8)];
+		}
+
+		/// Combine the two bitplanes of a pattern table row, storing two bits per pixel with the leftmost pixel in the
+		/// most significant bits.
+		static constexpr auto decode_tile_row(u8 const bitplane_0, u8 const bitplane_1) -> u16
+		{
+			auto res = u16{ 0 };
+			for (auto i = u32{ 0 }; i < 8; ++i)
+			{
+				auto const bit_0 = (bitplane_0 >> (7 - i)) & 1u;
+				auto const bit_1 = (bitplane_1 >> (7 - i)) & 1u;
+				res = static_cast<u16>((res << 2) | (bit_1 << 1) | (bit_0 << 0));
+			}
+			return res;
+		}
+
+		// Use counting (for debugging)
+
+		auto add_user() const -> void { __atomic_fetch_add(&users_, 1, __ATOMIC_RELAXED); }
+		auto remove_user() const -> void { __atomic_fetch_sub(&users_, 1, __ATOMIC_RELEASE); }
+		auto get_user_count() const -> u32 { return __atomic_load_n(&users_, __ATOMIC_ACQUIRE); }
+	};
+} // namespace nes::sys
@@ -0,0 +1,190 @@
+#include "nes/sys/state-tree.hh"
+#include "nes/common/debug.hh"
+#include "nes/common/utils.hh"
+
+namespace nes::sys
+{
+	namespace
+	{
+		auto is_zero(u8 const* const data, u32 const length) -> bool
+		{
+			auto res = u8{ 0 };
+			for (auto i = u32{ 0 }; i < length; ++i) { res |= data[i]; }
+			return res == 0;
+		}
+	} // namespace
+
+	state_tree::state_tree(span<page> const pages, span<node> const nodes)
+		: pages_{ pages }
+		, nodes_{ nodes }
+	{
+		for (auto i = pages_.get_length(); i > 0; --i)
+		{
+			pages_[i - 1].references = 0;
+			pages_[i - 1].next_free = free_page_;
+			free_page_ = i - 1;
+		}
+		free_page_count_ = pages_.get_length();
+
+		for (auto i = nodes_.get_length(); i > 0; --i)
+		{
+			nodes_[i - 1].references = 0;
+			nodes_[i - 1].next_free = free_node_;
+			free_node_ = i - 1;
+		}
+		free_node_count_ = nodes_.get_length();
+	}
+
+	auto state_tree::fork(nes& console, handle& result) -> status
+	{
+		if (free_node_ == invalid_handle) { return status::error_buffer_overflow; }
+
+		auto const index = free_node_;
+		auto& n = nodes_[index];
+		free_node_ = n.next_free;
+		free_node_count_ -= 1;
+		n.references = 1;
+		n.state = console.get_state();
+
+		// Pages which have not been written since the last synchronization are identical to the base node's pages.
+		auto const synchronized = console_ == &console && base_ != invalid_handle;
+		auto page_index = u32{ 0 };
+		auto success = true;
+		console.for_each_memory([&](auto& memory)
+		{
+			auto const data = memory.get_data();
+			for (auto p = u32{ 0 }; p < memory.page_count; ++p, ++page_index)
+			{
+				auto& entry = n.pages[page_index];
+				if (synchronized && !memory.is_dirty(p))
+				{
+					entry = nodes_[base_].pages[page_index];
+					retain_page(entry);
+					continue;
+				}
+
+				auto const offset = p * memory_page_size;
+				auto const length = min(memory_page_size, data.get_length() - offset);
+				if (is_zero(&data[offset], length))
+				{
+					entry = zero_page;
+					continue;
+				}
+
+				entry = allocate_page();
+				if (entry == invalid_handle)
+				{
+					success = false;
+					continue;
+				}
+
+				__builtin_memcpy(pages_[entry].data, &data[offset], length);
+				__builtin_memset(pages_[entry].data + length, 0, memory_page_size - length);
+			}
+		});
+
+		if (!success)
+		{
+			release(index);
+			return status::error_buffer_overflow;
+		}
+
+		console.for_each_memory([](auto& memory) { memory.clear_dirty(); });
+		set_base(index, console);
+		result = index;
+		return status::success;
+	}
+
+	auto state_tree::restore(handle const h, nes& console) -> void
+	{
+		NES_ASSERT(h < nodes_.get_length() && nodes_[h].references > 0 && "invalid node");
+
+		auto const& target = nodes_[h];
+		auto const synchronized = console_ == &console && base_ != invalid_handle;
+		auto page_index = u32{ 0 };
+		console.for_each_memory([&](auto& memory)
+		{
+			auto const data = memory.ref_data();
+			for (auto p = u32{ 0 }; p < memory.page_count; ++p, ++page_index)
+			{
+				auto const entry = target.pages[page_index];
+				if (synchronized && !memory.is_dirty(p) && nodes_[base_].pages[page_index] == entry) { continue; }
+
+				auto const offset = p * memory_page_size;
+				auto const length = min(memory_page_size, data.get_length() - offset);
+				if (entry == zero_page) { __builtin_memset(&data[offset], 0, length); }
+				else { __builtin_memcpy(&data[offset], pages_[entry].data, length); }
+			}
+			memory.clear_dirty();
+		});
+
+		console.set_state(target.state);
+		set_base(h, console);
+	}
+
+	auto state_tree::retain(handle const h) -> void
+	{
+		NES_ASSERT(h < nodes_.get_length() && nodes_[h].references > 0 && "invalid node");
+		nodes_[h].references += 1;
+	}
+
+	auto state_tree::release(handle const h) -> void
+	{
+		NES_ASSERT(h < nodes_.get_length() && nodes_[h].references > 0 && "invalid node");
+
+		auto& n = nodes_[h];
+		n.references -= 1;
+		if (n.references > 0) { return; }
+
+		for (auto const entry : n.pages) { release_page(entry); }
+		n.next_free = free_node_;
+		free_node_ = h;
+		free_node_count_ += 1;
+	}
+
+	auto state_tree::detach() -> void
+	{
+		if (base_ != invalid_handle) { release(base_); }
+		base_ = invalid_handle;
+		console_ = nullptr;
+	}
+
+	auto state_tree::set_base(handle const h, nes const& console) -> void
+	{
+		// The base node is retained, so that its pages stay valid as long as the console refers to them.
+		retain(h);
+		if (base_ != invalid_handle) { release(base_); }
+		base_ = h;
+		console_ = &console;
+	}
+
+	auto state_tree::allocate_page() -> u32
+	{
+		if (free_page_ == invalid_handle) { return invalid_handle; }
+
+		auto const res = free_page_;
+		free_page_ = pages_[res].next_free;
+		free_page_count_ -= 1;
+		pages_[res].references = 1;
+		return res;
+	}
+
+	auto state_tree::retain_page(u32 const index) -> void
+	{
+		if (index == zero_page) { return; }
+		pages_[index].references += 1;
+	}
+
+	auto state_tree::release_page(u32 const index) -> void
+	{
+		if (index == invalid_handle || index == zero_page) { return; }
+
+		auto& p = pages_[index];
+		p.references -= 1;
+		if (p.references > 0) { return; }
+
+		p.next_free = free_page_;
+		free_page_ = index;
+		free_page_count_ += 1;
+	}
+} // namespace nes::sys
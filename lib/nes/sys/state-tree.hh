@@ -0,0 +1,79 @@
+#pragma once
+
+#include "nes/sys/nes.hh"
+#include "nes/sys/types/paged-memory.hh"
+#include "nes/common/containers/span.hh"
+#include "nes/common/status.hh"
+#include "nes/common/types.hh"
+
+namespace nes::sys
+{
+	/// Stores console states as a tree of branches which share unchanged memory pages.
+	///
+	/// Search algorithms explore many input sequences starting from common states. Instead of copying the full state for
+	/// every branch, a node references reference-counted pages, and only the pages written by the console since it was
+	/// last synchronized with the tree (by fork or restore) are copied. The console tracks these writes itself.
+	///
+	/// All storage is provided by the caller. A console should only be used with one tree at a time.
+	class state_tree
+	{
+	public:
+		using handle = u32;
+		static constexpr auto invalid_handle = ~handle{ 0 };
+
+		struct page
+		{
+			u8 data[memory_page_size];
+			u32 references;
+			u32 next_free;
+		};
+
+		struct node
+		{
+			nes::state state;
+			u32 pages[nes::memory_page_count];
+			u32 references;
+			u32 next_free;
+		};
+
+	private:
+		// Pages containing only zeros (like unused cartridge RAM) are not stored at all.
+		static constexpr auto zero_page = invalid_handle - 1;
+
+		span<page> pages_;
+		span<node> nodes_;
+		u32 free_page_{ invalid_handle };
+		u32 free_node_{ invalid_handle };
+		u32 free_page_count_{ 0 };
+		u32 free_node_count_{ 0 };
+		nes const* console_{ nullptr }; // Console synchronized with base_.
+		handle base_{ invalid_handle };
+
+	public:
+		explicit state_tree(span<page> pages, span<node> nodes);
+
+		state_tree(state_tree const&) = delete;
+		state_tree(state_tree&&) = delete;
+		auto operator=(state_tree const&) -> state_tree& = delete;
+		auto operator=(state_tree&&) -> state_tree& = delete;
+
+		auto get_free_page_count() const -> u32 { return free_page_count_; }
+		auto get_free_node_count() const -> u32 { return free_node_count_; }
+
+		/// Store the current state of the console as a new node (with one reference owned by the caller).
+		auto fork(nes&, handle& result) -> status;
+		/// Load the state of a node into the console, only copying the pages which differ.
+		auto restore(handle, nes&) -> void;
+		auto retain(handle) -> void;
+		/// Drop a reference, freeing the node (and pages no longer used) once there are none left.
+		auto release(handle) -> void;
+		/// Forget about the console last synchronized with the tree, which must be called before destroying it.
+		auto detach() -> void;
+
+	private:
+		auto set_base(handle, nes const&) -> void;
+		auto allocate_page() -> u32;
+		auto retain_page(u32) -> void;
+		auto release_page(u32) -> void;
+	};
+} // namespace nes::sys
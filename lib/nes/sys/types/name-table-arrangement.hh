@@ -0,0 +1,11 @@
+#pragma once
+
+namespace nes::sys
+{
+	/// How the two physical name tables are arranged in the PPU's address space (determines mirroring).
+	enum class name_table_arrangement
+	{
+		horizontal,
+		vertical,
+	};
+} // namespace nes::sys
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "nes/common/containers/span.hh"
+#include "nes/common/types.hh"
+
+namespace nes::sys
+{
+	/// Granularity in which modifications of console memory are tracked.
+	inline constexpr auto memory_page_size = u32{ 256 };
+
+	/// A block of console memory which keeps track of the pages written since the last call to clear_dirty.
+	template<u32 Size>
+	class paged_memory
+	{
+	public:
+		static constexpr auto size = Size;
+		static constexpr auto page_count = (Size + memory_page_size - 1) / memory_page_size;
+
+	private:
+		static constexpr auto mask_count = (page_count + 63) / 64;
+
+		u8 data_[Size]{};
+		u64 dirty_[mask_count]{};
+
+	public:
+		explicit paged_memory() = default;
+
+		paged_memory(paged_memory const&) = delete;
+		paged_memory(paged_memory&&) = delete;
+		auto operator=(paged_memory const&) -> paged_memory& = delete;
+		auto operator=(paged_memory&&) -> paged_memory& = delete;
+
+		auto operator[](u32 const index) const -> u8 { return data_[index]; }
+
+		auto write(u32 const index, u8 const value) -> void
+		{
+			data_[index] = value;
+			auto const page = index / memory_page_size;
+			dirty_[page / 64] |= u64{ 1 } << (page % 64);
+		}
+
+		auto get_data() const -> span<u8 const> { return span<u8 const>{ data_, Size }; }
+		/// Direct access to the memory, which bypasses the dirty tracking.
+		auto ref_data() -> span<u8> { return span<u8>{ data_, Size }; }
+
+		auto is_dirty(u32 const page) const -> bool { return (dirty_[page / 64] >> (page % 64)) & 1; }
+
+		auto set_dirty() -> void
+		{
+			for (auto& mask : dirty_) { mask = ~u64{ 0 }; }
+		}
+
+		auto clear_dirty() -> void
+		{
+			for (auto& mask : dirty_) { mask = 0; }
+		}
+	};
+} // namespace nes::sys
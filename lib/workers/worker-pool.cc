@@ -0,0 +1,66 @@
+#include "worker-pool.hh"
+
+namespace nes
+{
+	worker_pool::worker_pool(u32 const thread_count)
+	{
+		for (auto i = u32{ 1 }; i < thread_count; ++i)
+		{
+			threads_.emplace_back([this] { run_thread(); });
+		}
+	}
+
+	worker_pool::~worker_pool()
+	{
+		{
+			auto const lock = std::lock_guard{ mutex_ };
+			stopping_ = true;
+		}
+		started_.notify_all();
+		for (auto& thread : threads_) { thread.join(); }
+	}
+
+	auto worker_pool::run(u32 const count, std::function<void(u32)> const& task) -> void
+	{
+		{
+			auto const lock = std::lock_guard{ mutex_ };
+			task_ = &task;
+			task_count_ = count;
+			next_task_ = 0;
+			active_threads_ = static_cast<u32>(threads_.size());
+			generation_ += 1;
+		}
+		started_.notify_all();
+
+		work();
+
+		auto lock = std::unique_lock{ mutex_ };
+		finished_.wait(lock, [this] { return active_threads_ == 0; });
+		task_ = nullptr;
+	}
+
+	auto worker_pool::work() -> void
+	{
+		for (auto i = next_task_.fetch_add(1); i < task_count_; i = next_task_.fetch_add(1)) { (*task_)(i); }
+	}
+
+	auto worker_pool::run_thread() -> void
+	{
+		auto generation = u64{ 0 };
+		while (true)
+		{
+			{
+				auto lock = std::unique_lock{ mutex_ };
+				started_.wait(lock, [&] { return stopping_ || generation_ != generation; });
+				if (stopping_) { return; }
+				generation = generation_;
+			}
+
+			work();
+
+			auto const lock = std::lock_guard{ mutex_ };
+			active_threads_ -= 1;
+			if (active_threads_ == 0) { finished_.notify_one(); }
+		}
+	}
+} // namespace nes
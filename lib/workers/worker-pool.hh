@@ -0,0 +1,44 @@
+#pragma once
+
+#include "nes/common/types.hh"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nes
+{
+	/// Threads which are started once and then wait for batches of tasks, with the calling thread helping out.
+	class worker_pool
+	{
+		std::vector<std::thread> threads_;
+		std::mutex mutex_;
+		std::condition_variable started_;
+		std::condition_variable finished_;
+		std::function<void(u32)> const* task_{ nullptr };
+		u32 task_count_{ 0 };
+		std::atomic<u32> next_task_{ 0 };
+		u32 active_threads_{ 0 };
+		u64 generation_{ 0 };
+		bool stopping_{ false };
+
+	public:
+		/// Start the given number of threads minus one (the calling thread being the last one).
+		explicit worker_pool(u32 thread_count);
+		~worker_pool();
+
+		worker_pool(worker_pool const&) = delete;
+		worker_pool(worker_pool&&) = delete;
+		auto operator=(worker_pool const&) -> worker_pool& = delete;
+		auto operator=(worker_pool&&) -> worker_pool& = delete;
+
+		/// Call the function for each index in [0, count) and wait until all calls have returned.
+		auto run(u32 count, std::function<void(u32)> const& task) -> void;
+
+	private:
+		auto work() -> void;
+		auto run_thread() -> void;
+	};
+} // namespace nes
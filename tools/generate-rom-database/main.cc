@@ -0,0 +1,165 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <optional>
+#include <algorithm>
+#include <vector>
+#include <iomanip>
+#include <cstdlib>
+#include <cstdint>
+#include <unistd.h>
+#include <fcntl.h>
+
+namespace
+{
+	enum class status
+	{
+		ok,
+		invalid,
+	};
+
+	struct entry
+	{
+		std::uint32_t crc32{ 0 };
+		unsigned mapper{ 0 };
+		std::string name_table_arrangement;
+		unsigned prg_ram_kib{ 0 };
+	};
+
+	auto parse_line(std::string const& line, entry* out_entry) -> status
+	{
+		auto str = std::istringstream{ line };
+		auto res = entry{};
+		str >> std::hex >> res.crc32 >> std::dec >> res.mapper >> res.name_table_arrangement >> res.prg_ram_kib;
+		if (str.fail()) { return status::invalid; }
+
+		auto rest = std::string{};
+		if (str >> rest) { return status::invalid; }
+		if (res.mapper > 0xFFF) { return status::invalid; }
+		if (res.name_table_arrangement != "horizontal" && res.name_table_arrangement != "vertical")
+		{
+			return status::invalid;
+		}
+		if (res.prg_ram_kib > 0xFF) { return status::invalid; }
+
+		*out_entry = res;
+		return status::ok;
+	}
+
+	auto load_entries(char const* path, std::vector<entry>* out_entries) -> status
+	{
+		auto file = std::ifstream{ path };
+		if (!file)
+		{
+			std::cerr << "Unable to open file: " << path << std::endl;
+			return status::invalid;
+		}
+
+		auto line = std::string{};
+		auto line_number = 0u;
+		while (std::getline(file, line))
+		{
+			line_number += 1;
+			auto const first = line.find_first_not_of(" \t\r");
+			if (first == std::string::npos || line[first] == '#') { continue; }
+
+			auto e = entry{};
+			if (parse_line(line, &e) != status::ok)
+			{
+				std::cerr << path << ":" << line_number << ": Invalid entry" << std::endl;
+				return status::invalid;
+			}
+			out_entries->push_back(e);
+		}
+
+		std::sort(
+			out_entries->begin(), out_entries->end(), [](entry const& a, entry const& b) { return a.crc32 < b.crc32; });
+		auto const duplicate = std::adjacent_find(
+			out_entries->begin(), out_entries->end(), [](entry const& a, entry const& b) { return a.crc32 == b.crc32; });
+		if (duplicate != out_entries->end())
+		{
+			std::cerr << path << ": Duplicate entry: " << std::hex << duplicate->crc32 << std::endl;
+			return status::invalid;
+		}
+
+		return status::ok;
+	}
+
+	auto write_file(std::string_view const filename, std::string_view const content) -> status
+	{
+		auto const filename_str = std::string{ filename };
+
+		auto const fd = open(filename_str.c_str(), O_TRUNC | O_WRONLY | O_CREAT, 0644);
+		if (fd == -1)
+		{
+			perror("open");
+			return status::invalid;
+		}
+
+		if (write(fd, content.data(), content.length()) == -1)
+		{
+			perror("write");
+			return status::invalid;
+		}
+
+		close(fd);
+		return status::ok;
+	}
+} // namespace
+
+int main(int const argc, char** const argv)
+{
+	if (argc != 5)
+	{
+		std::cerr << "Usage:\n";
+		std::cerr << "  " << argv[0] << " <name> <output-header> <output-source> <file>" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	auto const name = std::string_view{ argv[1] };
+	auto const output_header = std::string_view{ argv[2] };
+	auto const output_source = std::string_view{ argv[3] };
+
+	auto entries = std::vector<entry>{};
+	if (load_entries(argv[4], &entries) != status::ok) { return EXIT_FAILURE; }
+
+	auto header = std::stringstream{};
+	auto source = std::stringstream{};
+
+	header << "#pragma once\n";
+	header << "\n";
+	header << "#include \"nes/sys/rom-database.hh\"\n";
+	header << "\n";
+	header << "namespace nes::sys::database\n";
+	header << "{\n";
+	header << "\t// Sorted by CRC-32.\n";
+	header << "\textern rom_database::entry const " << name << "[];\n";
+	header << "\textern u32 const " << name << "_count;\n";
+	header << "} // namespace nes::sys::database\n";
+
+	source << "#include \"nes/sys/rom-database.hh\"\n";
+	source << "\n";
+	source << "namespace nes::sys::database\n";
+	source << "{\n";
+	source << "\textern rom_database::entry const " << name << "[] =\n";
+	source << "\t{\n";
+	for (auto const& e : entries)
+	{
+		source << "\t\trom_database::entry{ 0x" << std::hex << std::uppercase << std::setw(8) << std::setfill('0')
+			<< e.crc32 << std::dec << ", " << e.mapper << ", name_table_arrangement::" << e.name_table_arrangement
+			<< ", " << e.prg_ram_kib << " },\n";
+	}
+	if (entries.empty())
+	{
+		// Arrays must not be empty.
+		source << "\t\trom_database::entry{},\n";
+	}
+	source << "\t};\n";
+	source << "\textern u32 const " << name << "_count = " << entries.size() << ";\n";
+	source << "} // namespace nes::sys::database\n";
+
+	if (write_file(output_header, header.str()) != status::ok) { return EXIT_FAILURE; }
+	if (write_file(output_source, source.str()) != status::ok) { return EXIT_FAILURE; }
+
+	return EXIT_SUCCESS;
+}